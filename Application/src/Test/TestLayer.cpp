@@ -1,6 +1,35 @@
 #include "TestLayer.h"
 #include "FGEngine.h"
+#include "renderer/Model.h"
 
+#include <glm/gtc/matrix_transform.hpp>
+
+
+void TestLayer::OnAttach()
+{
+	// the renderer keeps its own copies, the model can go once they are created
+	FGEngine::Model model("model/viking_room/viking_room.obj");
+
+	texture = FGEngine::Renderer::CreateTexture(FGEngine::Texture("model/viking_room/viking_room.png"));
+	material = FGEngine::Renderer::CreateMaterial({ texture });
+
+	for (uint32_t i = 0; i < model.GetMeshCount(); i++)
+	{
+		meshes.push_back(FGEngine::Renderer::CreateMesh(*model.GetMesh(i)));
+	}
+}
+
+void TestLayer::OnDetach()
+{
+	for (FGEngine::Handle<FGEngine::Mesh> mesh : meshes)
+	{
+		FGEngine::Renderer::DestroyMesh(mesh);
+	}
+	meshes.clear();
+
+	FGEngine::Renderer::DestroyMaterial(material);
+	FGEngine::Renderer::DestroyTexture(texture);
+}
 
 void TestLayer::OnUpdate(float deltaTime)
 {
@@ -10,6 +39,29 @@ void TestLayer::OnUpdate(float deltaTime)
 	//testDelegate->Broadcast(456, 321);
 	//testDelegate->RemoveFunction(this, TestLayer::OnTestDelegated);
 	//testDelegate->Broadcast(456, 321);
+
+	time += deltaTime;
+
+	// a grid of small rooms, the renderer turns the repeated submissions into one instanced draw per mesh
+	constexpr int GridSize = 12;
+	constexpr float Spacing = 0.6f;
+	for (int y = 0; y < GridSize; y++)
+	{
+		for (int x = 0; x < GridSize; x++)
+		{
+			glm::vec3 position((x - (GridSize - 1) * 0.5f) * Spacing, (y - (GridSize - 1) * 0.5f) * Spacing, 0);
+			glm::mat4 transform = glm::translate(glm::mat4(1.0f), position);
+			transform = glm::rotate(transform, time * glm::radians(90.0f) + (x + y) * 0.3f, glm::vec3(0, 0, 1));
+			transform = glm::scale(transform, glm::vec3(0.25f));
+
+			glm::vec4 color(0.6f + 0.4f * x / (GridSize - 1), 0.6f + 0.4f * y / (GridSize - 1), 1.0f, 1.0f);
+
+			for (FGEngine::Handle<FGEngine::Mesh> mesh : meshes)
+			{
+				FGEngine::Renderer::Submit(mesh, material, transform, color);
+			}
+		}
+	}
 }
 
 void TestLayer::OnTestDelegated(int val1, int val2)
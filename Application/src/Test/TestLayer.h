@@ -2,6 +2,9 @@
 
 #include "core/AppLayer.h"
 #include "core/Delegate.h"
+#include "renderer/Renderer.h"
+
+#include <vector>
 
 DECLARE_DELEGATE(Test, int, int);
 
@@ -9,6 +12,8 @@ class TestLayer : public FGEngine::AppLayer
 {
 
 public:
+	virtual void OnAttach() override;
+	virtual void OnDetach() override;
 	virtual void OnUpdate(float deltaTime) override;
 
 private:
@@ -16,5 +21,11 @@ private:
 
 private:
 	TestDelegate testDelegate;
+
+	FGEngine::Handle<FGEngine::Texture> texture;
+	FGEngine::Handle<FGEngine::Material> material;
+	std::vector<FGEngine::Handle<FGEngine::Mesh>> meshes;
+	// seconds the rooms have been turning
+	float time = 0.0f;
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core/Application.h"
+#include "core/MemoryTracker.h"
 
 extern FGEngine::Application* FGEngine::CreateApplication();
 
@@ -9,4 +10,13 @@ int main(int argc, char** argv)
 	auto* app = FGEngine::CreateApplication();
 	app->Run();
 	delete app;
+
+#if ENABLE_MEMORY_TRACKING
+	// a non-zero exit code lets CI fail runs that went over a memory budget set by the client.
+	// leaks are reported by the engine itself, after its statics are torn down
+	FGEngine::MemoryTracker::Report();
+	return FGEngine::MemoryTracker::IsWithinBudget() ? 0 : 1;
+#else
+	return 0;
+#endif
 }
\ No newline at end of file
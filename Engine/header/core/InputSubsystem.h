@@ -3,9 +3,13 @@
 #include "event/KeyboardEvent.h"
 #include "subsystem/EngineSubsystem.h"
 #include "core/Delegate.h"
+#include "core/SnapshotBuffer.h"
+#include "core/PoolAllocator.h"
 
 #include <glm/glm.hpp>
+#include <array>
 #include <vector>
+#include <memory_resource>
 
 namespace FGEngine
 {
@@ -159,6 +163,24 @@ enum class EMouseButton : uint8_t
 	Count
 };
 
+// Immutable copy of the input state, published once per frame for reading from worker threads.
+struct InputSnapshot
+{
+	uint64_t frame = 0;
+	std::array<EKeyState, (size_t)EKey::Count> keyStates{};
+	std::array<EKeyState, (size_t)EMouseButton::Count> mouseStates{};
+	glm::dvec2 mouseScroll{};
+	glm::dvec2 cursorPosition{};
+	glm::dvec2 cursorDelta{};
+
+	bool IsKeyPressed(EKey key) const { return keyStates[(size_t)key] == EKeyState::Pressed; }
+	bool IsKeyReleased(EKey key) const { return keyStates[(size_t)key] == EKeyState::Released; }
+	bool IsKeyRepeated(EKey key) const { return keyStates[(size_t)key] == EKeyState::Repeated; }
+
+	bool IsMouseButtonPressed(EMouseButton button) const { return mouseStates[(size_t)button] == EKeyState::Pressed; }
+	bool IsMouseButtonReleased(EMouseButton button) const { return mouseStates[(size_t)button] == EKeyState::Released; }
+};
+
 DECLARE_DELEGATE(InputKey, EKey, EKeyState);
 DECLARE_DELEGATE(InputMouse, EMouseButton, EKeyState);
 DECLARE_DELEGATE(InputMouseScroll, const glm::dvec2&);
@@ -169,11 +191,7 @@ DECLARE_DELEGATE(InputCursorEnterChanged, bool);
 class InputSubsystem : public EngineSubsystem
 {
 public:
-	InputSubsystem()
-		: keyStates((size_t)EKey::Count)
-		, mouseStates((size_t)EMouseButton::Count)
-	{
-	}
+	InputSubsystem() = default;
 
 	void ProcessQueue();
 	void AddQueue(const std::shared_ptr<IWindowEvent>& windowEvent);
@@ -189,6 +207,9 @@ public:
 	glm::dvec2 GetCursorPosition() const;
 	glm::dvec2 GetCursorDelta() const;
 
+	// Safe to call from any thread, returns a copy of the latest published snapshot.
+	InputSnapshot GetSnapshot() const { return snapshotBuffer.Read(); }
+
 public:
 	InputKeyDelegate inputKeyDelegate;
 	InputMouseDelegate inputMouseDelegate;
@@ -198,13 +219,11 @@ public:
 	InputCursorEnterChangedDelegate inputCursorEnterChangedDelegate;
 
 private:
-	std::vector<std::shared_ptr<IWindowEvent>> queueEvents;
-	std::vector<EKeyState> keyStates;
-	std::vector<EKeyState> mouseStates;
-	glm::dvec2 mouseScroll;
-	glm::dvec2 cursorPosition;
-	glm::dvec2 cursorPreviousPosition;
-	glm::dvec2 cursorDelta;
+	std::pmr::vector<std::shared_ptr<IWindowEvent>> queueEvents{ &PoolMemoryResource::GetDefault() };
+
+	// main thread working state, copied into the snapshot buffer at the end of ProcessQueue
+	InputSnapshot state;
+	SnapshotBuffer<InputSnapshot> snapshotBuffer;
 };
 
 }
\ No newline at end of file
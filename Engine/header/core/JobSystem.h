@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FGEngine
+{
+	/*
+	* Fixed set of worker threads for data parallel loops.
+	*
+	* ParallelFor() hands out indices to the workers and the calling thread, which works along instead of idling,
+	* and returns once every index ran. Only one loop runs at a time, jobs must not start another.
+	*/
+	class JobSystem
+	{
+	public:
+		// 0 picks one worker per hardware thread besides the caller
+		explicit JobSystem(uint32_t workerCount = 0);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t index)>& job);
+
+		// threads that take part in a loop, the workers and the caller
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+
+	private:
+		void WorkerLoop();
+		// runs indices of the current loop until none are left
+		void RunJobs();
+
+	private:
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable workDone;
+
+		// written under the mutex while no worker is inside RunJobs()
+		const std::function<void(uint32_t)>* job = nullptr;
+		uint32_t jobCount = 0;
+
+		std::atomic<uint32_t> nextIndex = 0;
+		std::atomic<uint32_t> completedCount = 0;
+		uint32_t activeWorkerCount = 0;
+		bool bStopping = false;
+	};
+}
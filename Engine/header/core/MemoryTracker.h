@@ -0,0 +1,88 @@
+#pragma once
+
+#include "core/Core.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// replaces the global operator new/delete of the Engine module and routes stb/Vulkan host allocations through the tracker
+#ifndef ENABLE_MEMORY_TRACKING
+#define ENABLE_MEMORY_TRACKING 1
+#endif
+
+namespace FGEngine
+{
+	enum class EMemoryTag : uint8_t
+	{
+		Untagged,
+		Core,
+		Layer,
+		Input,
+		Asset,
+		Renderer,
+		Vulkan,
+
+		Count
+	};
+
+	struct MemoryTagStats
+	{
+		size_t currentBytes = 0;
+		size_t currentCount = 0;
+		size_t peakBytes = 0;
+		size_t totalBytes = 0;
+		size_t totalCount = 0;
+		size_t budgetBytes = 0;		// 0 means no budget
+	};
+
+	/*
+	* Engine-wide allocation tracking.
+	*
+	* Every allocation is attributed to the tag on top of the calling thread's tag stack (see ScopedMemoryTag).
+	* Live allocations are kept in a side table keyed by pointer, so memory can still be freed from another
+	* module (e.g. layers created by the application and deleted by the engine); such pointers are simply
+	* not found and released untracked.
+	*/
+	class ENGINE_API MemoryTracker
+	{
+	public:
+		static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		static void* Allocate(size_t size, size_t alignment, EMemoryTag tag);
+		static void* Reallocate(void* ptr, size_t size, size_t alignment = alignof(std::max_align_t));
+		static void* Reallocate(void* ptr, size_t size, size_t alignment, EMemoryTag tag);
+		static void Free(void* ptr);
+
+		static void PushTag(EMemoryTag tag);
+		static void PopTag();
+		static EMemoryTag GetCurrentTag();
+
+		static MemoryTagStats GetStats(EMemoryTag tag);
+		static void SetBudget(EMemoryTag tag, size_t bytes);
+		// false when a tag's high-water mark went over its budget
+		static bool IsWithinBudget();
+
+		static void Report();
+		// logs allocations still alive per tag, returns the number of leaked allocations.
+		// called automatically once the engine's statics are destroyed, earlier calls also count what they hold
+		static size_t ReportLeaks();
+
+		static const char* GetTagName(EMemoryTag tag);
+	};
+
+	class ScopedMemoryTag
+	{
+	public:
+		explicit ScopedMemoryTag(EMemoryTag tag)
+		{
+			MemoryTracker::PushTag(tag);
+		}
+
+		~ScopedMemoryTag()
+		{
+			MemoryTracker::PopTag();
+		}
+
+		ScopedMemoryTag(const ScopedMemoryTag&) = delete;
+		ScopedMemoryTag& operator=(const ScopedMemoryTag&) = delete;
+	};
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "core/Core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace FGEngine
+{
+/*
+* Free-list pool of equally sized blocks, carved out of chunks allocated from the upstream heap.
+* Blocks are never returned to the upstream heap until the pool is destroyed. Not thread-safe.
+*/
+class FixedSizePool
+{
+public:
+	FixedSizePool(size_t inBlockSize, size_t inBlockAlignment = alignof(std::max_align_t), size_t inBlocksPerChunk = 64)
+		: blockSize(RoundUp(inBlockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : inBlockSize, inBlockAlignment))
+		, blockAlignment(inBlockAlignment)
+		, blocksPerChunk(inBlocksPerChunk)
+	{
+	}
+
+	~FixedSizePool()
+	{
+		for (void* chunk : chunks)
+		{
+			::operator delete(chunk, std::align_val_t(blockAlignment));
+		}
+	}
+
+	FixedSizePool(const FixedSizePool&) = delete;
+	FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+	void* Allocate()
+	{
+		if (!freeList)
+		{
+			AllocateChunk();
+		}
+
+		FreeBlock* block = freeList;
+		freeList = block->next;
+		allocatedCount++;
+		return block;
+	}
+
+	void Deallocate(void* ptr)
+	{
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->next = freeList;
+		freeList = block;
+		allocatedCount--;
+	}
+
+	size_t GetBlockSize() const { return blockSize; }
+	size_t GetAllocatedCount() const { return allocatedCount; }
+	size_t GetCapacity() const { return chunks.size() * blocksPerChunk; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	static size_t RoundUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	void AllocateChunk()
+	{
+		uint8_t* chunk = static_cast<uint8_t*>(::operator new(blockSize * blocksPerChunk, std::align_val_t(blockAlignment)));
+		chunks.push_back(chunk);
+
+		// link back to front so blocks are handed out in address order
+		for (size_t i = blocksPerChunk; i > 0; i--)
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * blockSize);
+			block->next = freeList;
+			freeList = block;
+		}
+	}
+
+private:
+	size_t blockSize;
+	size_t blockAlignment;
+	size_t blocksPerChunk;
+
+	FreeBlock* freeList = nullptr;
+	std::vector<void*> chunks;
+	size_t allocatedCount = 0;
+};
+
+// Typed object pool on top of FixedSizePool, objects of one type stay contiguous in memory. Not thread-safe.
+template<typename T>
+class ObjectPool
+{
+public:
+	explicit ObjectPool(size_t blocksPerChunk = 64)
+		: pool(sizeof(T), alignof(T), blocksPerChunk)
+	{
+	}
+
+	template<typename... Args>
+	T* Create(Args&&... args)
+	{
+		void* ptr = pool.Allocate();
+		return new (ptr) T(std::forward<Args>(args)...);
+	}
+
+	void Destroy(T* object)
+	{
+		if (!object) return;
+
+		object->~T();
+		pool.Deallocate(object);
+	}
+
+	size_t GetAllocatedCount() const { return pool.GetAllocatedCount(); }
+
+private:
+	FixedSizePool pool;
+};
+
+/*
+* Thread-aware std::pmr resource with size classes from 16 to 1024 bytes.
+* Each size class is a FixedSizePool behind a mutex, and every thread keeps a small cache of free blocks
+* per size class so most allocations and frees don't touch the lock. Blocks are aligned to their size,
+* requests over 1024 bytes (size or alignment) go to the upstream resource.
+* Cached blocks are handed back when the thread exits.
+*/
+class ENGINE_API PoolMemoryResource : public std::pmr::memory_resource
+{
+public:
+	static constexpr size_t MinBlockSize = 16;
+	static constexpr size_t MaxBlockSize = 1024;
+	static constexpr size_t SizeClassCount = 7;
+
+	explicit PoolMemoryResource(std::pmr::memory_resource* inUpstream = std::pmr::new_delete_resource());
+	virtual ~PoolMemoryResource() override;
+
+	PoolMemoryResource(const PoolMemoryResource&) = delete;
+	PoolMemoryResource& operator=(const PoolMemoryResource&) = delete;
+
+	// hands the calling thread's cached blocks back to the shared pools
+	void FlushThreadCache();
+
+	// engine wide resource for small, short lived objects (events, queues), never destroyed
+	static PoolMemoryResource& GetDefault();
+
+protected:
+	virtual void* do_allocate(size_t bytes, size_t alignment) override;
+	virtual void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	struct SizeClass;
+	friend struct ThreadCache;
+
+	void* AllocateFromSizeClass(size_t sizeClassIndex);
+	void DeallocateToSizeClass(size_t sizeClassIndex, void* ptr);
+
+	void RefillCache(size_t sizeClassIndex, void** blocks, uint32_t& count);
+	void ReturnBlocks(size_t sizeClassIndex, void** blocks, uint32_t count);
+
+private:
+	std::pmr::memory_resource* upstream;
+	SizeClass* sizeClasses;
+	uint64_t id;
+};
+
+// shared_ptr whose object and control block come from the default pool resource
+template<typename T, typename... Args>
+std::shared_ptr<T> MakePooledShared(Args&&... args)
+{
+	return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(&PoolMemoryResource::GetDefault()), std::forward<Args>(args)...);
+}
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "core/Logger.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace FGEngine
+{
+/*
+* Typed 32-bit handle into a SlotMap: 20 bits of slot index and 12 bits of generation.
+* The generation starts at 1, so a zero value is never a live handle.
+*/
+template<typename T>
+class Handle
+{
+public:
+	static constexpr uint32_t IndexBits = 20;
+	static constexpr uint32_t MaxIndex = (1u << IndexBits) - 1;
+	static constexpr uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+	Handle() = default;
+	Handle(uint32_t index, uint32_t generation) : value((generation << IndexBits) | index) {}
+
+	uint32_t GetIndex() const { return value & MaxIndex; }
+	uint32_t GetGeneration() const { return value >> IndexBits; }
+	uint32_t GetValue() const { return value; }
+
+	bool IsValid() const { return value != 0; }
+	explicit operator bool() const { return IsValid(); }
+
+	bool operator==(const Handle& other) const = default;
+
+private:
+	uint32_t value = 0;
+};
+
+// front-end handles (Handle<Mesh>, ...) are backed by a slot map of the API specific resource type
+template<typename To, typename From>
+Handle<To> HandleCast(Handle<From> handle)
+{
+	return handle.IsValid() ? Handle<To>(handle.GetIndex(), handle.GetGeneration()) : Handle<To>();
+}
+
+/*
+* Generational slot map. Values are stored contiguously (removal swaps the last value into the hole),
+* handles go through a slot table that is validated by generation, so lookups of removed values fail in O(1).
+* Pointers returned by Get() are invalidated by Emplace() and Remove(), handles are not.
+*/
+template<typename T>
+class SlotMap
+{
+public:
+	SlotMap() = default;
+
+	SlotMap(const SlotMap&) = delete;
+	SlotMap& operator=(const SlotMap&) = delete;
+	SlotMap(SlotMap&&) = default;
+	SlotMap& operator=(SlotMap&&) = default;
+
+	template<typename... Args>
+	Handle<T> Emplace(Args&&... args)
+	{
+		uint32_t slotIndex;
+		if (freeHead != InvalidIndex)
+		{
+			slotIndex = freeHead;
+			freeHead = slots[slotIndex].denseIndex;
+		}
+		else
+		{
+			Check(slots.size() <= Handle<T>::MaxIndex, "SlotMap is out of handles");
+			slotIndex = static_cast<uint32_t>(slots.size());
+			slots.push_back({ InvalidIndex, 1 });
+		}
+
+		Slot& slot = slots[slotIndex];
+		slot.denseIndex = static_cast<uint32_t>(values.size());
+		values.emplace_back(std::forward<Args>(args)...);
+		valueSlots.push_back(slotIndex);
+
+		return Handle<T>(slotIndex, slot.generation);
+	}
+
+	Handle<T> Insert(T&& value)
+	{
+		return Emplace(std::move(value));
+	}
+
+	bool Contains(Handle<T> handle) const
+	{
+		// released slots bump their generation, so a matching generation means the value is alive
+		return handle.IsValid() && handle.GetIndex() < slots.size() && slots[handle.GetIndex()].generation == handle.GetGeneration();
+	}
+
+	T* Get(Handle<T> handle)
+	{
+		return Contains(handle) ? &values[slots[handle.GetIndex()].denseIndex] : nullptr;
+	}
+
+	const T* Get(Handle<T> handle) const
+	{
+		return Contains(handle) ? &values[slots[handle.GetIndex()].denseIndex] : nullptr;
+	}
+
+	bool Remove(Handle<T> handle)
+	{
+		if (!Contains(handle)) return false;
+
+		uint32_t slotIndex = handle.GetIndex();
+		uint32_t denseIndex = slots[slotIndex].denseIndex;
+		uint32_t lastIndex = static_cast<uint32_t>(values.size()) - 1;
+		if (denseIndex != lastIndex)
+		{
+			values[denseIndex] = std::move(values[lastIndex]);
+			valueSlots[denseIndex] = valueSlots[lastIndex];
+			slots[valueSlots[denseIndex]].denseIndex = denseIndex;
+		}
+		values.pop_back();
+		valueSlots.pop_back();
+
+		ReleaseSlot(slotIndex);
+		return true;
+	}
+
+	void Clear()
+	{
+		for (uint32_t slotIndex : valueSlots)
+		{
+			ReleaseSlot(slotIndex);
+		}
+		values.clear();
+		valueSlots.clear();
+	}
+
+	void Reserve(size_t count)
+	{
+		values.reserve(count);
+		valueSlots.reserve(count);
+		slots.reserve(count);
+	}
+
+	size_t Size() const { return values.size(); }
+	bool IsEmpty() const { return values.empty(); }
+
+	// dense access, the order changes on removal
+	T* Data() { return values.data(); }
+	const T* Data() const { return values.data(); }
+	Handle<T> GetHandleAt(size_t denseIndex) const
+	{
+		uint32_t slotIndex = valueSlots[denseIndex];
+		return Handle<T>(slotIndex, slots[slotIndex].generation);
+	}
+
+	typename std::vector<T>::iterator begin() { return values.begin(); }
+	typename std::vector<T>::iterator end() { return values.end(); }
+	typename std::vector<T>::const_iterator begin() const { return values.begin(); }
+	typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+private:
+	void ReleaseSlot(uint32_t slotIndex)
+	{
+		Slot& slot = slots[slotIndex];
+		// stale handles stop matching, skipping generation 0 to keep it invalid
+		slot.generation = slot.generation == Handle<T>::MaxGeneration ? 1 : slot.generation + 1;
+		slot.denseIndex = freeHead;
+		freeHead = slotIndex;
+	}
+
+private:
+	static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+	struct Slot
+	{
+		// index into values while alive, next free slot while free
+		uint32_t denseIndex;
+		uint32_t generation;
+	};
+
+	std::vector<T> values;
+	std::vector<uint32_t> valueSlots;
+	std::vector<Slot> slots;
+	uint32_t freeHead = InvalidIndex;
+};
+}
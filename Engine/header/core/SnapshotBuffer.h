@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace FGEngine
+{
+/*
+* Sequence lock handing data produced once per frame by a single thread (the main thread)
+* to any number of reading threads, without a mutex.
+*
+* The value is kept as atomic 64-bit words next to a sequence number that is odd while Publish() writes them.
+* Publish() never waits. Read() copies the words and retries if the sequence was odd or changed meanwhile, so a
+* reader only ever spins for the duration of one copy and always returns a value that was published as a whole.
+* The copy belongs to the reader, read once per job and pass it on rather than reading per access.
+*/
+template<typename T>
+class SnapshotBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>, "SnapshotBuffer copies its value word by word");
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "SnapshotBuffer needs lock-free 64-bit atomics");
+
+public:
+	SnapshotBuffer() { Publish(T{}); }
+
+	SnapshotBuffer(const SnapshotBuffer&) = delete;
+	SnapshotBuffer& operator=(const SnapshotBuffer&) = delete;
+
+	// producer only
+	void Publish(const T& value)
+	{
+		Words data{};
+		std::memcpy(data.data(), &value, sizeof(T));
+
+		const uint64_t begin = sequence.load(std::memory_order_relaxed);
+		sequence.store(begin + 1, std::memory_order_relaxed);
+		// orders the odd sequence before the words, readers that see any new word see the odd sequence too
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t i = 0; i < WordCount; i++)
+		{
+			words[i].store(data[i], std::memory_order_relaxed);
+		}
+		sequence.store(begin + 2, std::memory_order_release);
+	}
+
+	// any thread
+	T Read() const
+	{
+		Words data;
+		for (;;)
+		{
+			const uint64_t begin = sequence.load(std::memory_order_acquire);
+			if (begin & 1)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			for (size_t i = 0; i < WordCount; i++)
+			{
+				data[i] = words[i].load(std::memory_order_relaxed);
+			}
+			// orders the words before the second look at the sequence
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence.load(std::memory_order_relaxed) == begin) break;
+		}
+
+		T value;
+		std::memcpy(&value, data.data(), sizeof(T));
+		return value;
+	}
+
+private:
+	static constexpr size_t WordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	using Words = std::array<uint64_t, WordCount>;
+
+	std::atomic<uint64_t> sequence = 0;
+	std::array<std::atomic<uint64_t>, WordCount> words{};
+};
+}
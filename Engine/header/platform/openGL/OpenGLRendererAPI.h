@@ -10,9 +10,16 @@ namespace FGEngine
 		// Inherited via IRendererAPI
 		virtual void SetClearColor(float r, float g, float b, float a) override;
 		virtual void Clear() const override;
-		virtual void Render(void* nativeWindow) override;
+		virtual void Render(void* nativeWindow, RenderQueue& renderQueue) override;
 		virtual void Resize() override;
 
+		virtual Handle<Texture> CreateTexture(const Texture& texture) override;
+		virtual void DestroyTexture(Handle<Texture> texture) override;
+		virtual Handle<Mesh> CreateMesh(const Mesh& mesh) override;
+		virtual void DestroyMesh(Handle<Mesh> mesh) override;
+		virtual Handle<Material> CreateMaterial(const Material& material) override;
+		virtual void DestroyMaterial(Handle<Material> material) override;
+
 		virtual std::string GetName() const override;
 		virtual std::string GetVersion() const override;
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+
+	/*
+	* One descriptor set holding every sampled texture (binding 0), indexed from fragment shaders.
+	*
+	* The set is bound once per frame and textures are referred to by their slot index instead of through per-draw
+	* sets. The binding is partially bound and update-unused-while-pending, so registering writes a free slot while
+	* frames using other slots are in flight. Released slots go through the deletion queue before they are handed out
+	* again, a replaced resource gets a new slot rather than having its old one rewritten.
+	* Requires VulkanLogicalDevice::IsBindlessEnabled().
+	*/
+	class VulkanBindlessTable
+	{
+	public:
+		VulkanBindlessTable(VkPhysicalDevice physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t maxTextures = DefaultMaxTextures);
+		~VulkanBindlessTable();
+
+		VulkanBindlessTable(const VulkanBindlessTable&) = delete;
+		VulkanBindlessTable& operator=(const VulkanBindlessTable&) = delete;
+
+		uint32_t RegisterTexture(VkImageView imageView, VkSampler sampler);
+		void ReleaseTexture(uint32_t index);
+
+		VkDescriptorSetLayout GetSetLayout() const { return setLayout; }
+		VkDescriptorSet GetSet() const { return descriptorSet; }
+
+	public:
+		static constexpr uint32_t DefaultMaxTextures = 4096;
+		// the only stage reading the table
+		static constexpr VkShaderStageFlags StageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	private:
+		struct SlotList
+		{
+			std::vector<uint32_t> freeIndices;
+			uint32_t nextIndex = 0;
+			uint32_t capacity = 0;
+		};
+
+		uint32_t AllocateSlot(SlotList& slots, const char* kind);
+		void ReleaseSlot(SlotList& slots, uint32_t index);
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		VkDescriptorSetLayout setLayout;
+		VkDescriptorPool descriptorPool;
+		VkDescriptorSet descriptorSet;
+
+		SlotList textureSlots;
+	};
+}
@@ -3,7 +3,8 @@
 #include "vulkan/vulkan_core.h"
 #include "platform/vulkan/VulkanPhysicalDevice.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
-#include "platform/vulkan/VulkanCommand.h"
+#include "platform/vulkan/VulkanUploadManager.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
 
 namespace FGEngine
 {
@@ -20,31 +21,21 @@ namespace FGEngine
 
 		~VulkanBuffer();
 
+		// stored by value in slot maps, so only movable
+		VulkanBuffer(const VulkanBuffer&) = delete;
+		VulkanBuffer& operator=(const VulkanBuffer&) = delete;
+		VulkanBuffer(VulkanBuffer&& other) noexcept;
+		VulkanBuffer& operator=(VulkanBuffer&& other) noexcept;
+
+		// creates a device local buffer and queues its contents on the upload manager, usable after the next Flush()
 		template<typename T>
 		void Init(
-			const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice,
-			const std::shared_ptr<VulkanCommand>& command,
-			std::vector<T> inBuffer,
+			VulkanUploadManager& uploadManager,
+			const std::vector<T>& inBuffer,
 			EBufferType bufferType)
 		{
 			VkDeviceSize bufferSize = sizeof(inBuffer[0]) * inBuffer.size();
 
-			VkBuffer stagingBuffer;
-			VkDeviceMemory stagingBufferMemory;
-
-			CreateBuffer(physicalDevice, logicalDevice,
-				bufferSize,
-				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				stagingBuffer, stagingBufferMemory);
-
-			void* data;
-			vkMapMemory(*logicalDevice, stagingBufferMemory, 0, bufferSize, 0, &data);
-			{
-				memcpy(data, inBuffer.data(), (size_t)bufferSize);
-			}
-			vkUnmapMemory(*logicalDevice, stagingBufferMemory);
-
 			VkBufferUsageFlagBits usageFlagBit = (VkBufferUsageFlagBits)0;
 			switch (bufferType)
 			{
@@ -57,32 +48,44 @@ namespace FGEngine
 			}
 			Check(usageFlagBit, "Usage flag not set.");
 
-			CreateBuffer(physicalDevice, logicalDevice, 
+			// transfer source so the contents can be moved when the buffer is demoted
+			size = bufferSize;
+			usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlagBit;
+
+			CreateBuffer(logicalDevice, 
 				bufferSize,
-				VK_BUFFER_USAGE_TRANSFER_DST_BIT | usageFlagBit,
+				usage,
 				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-				buffer, bufferMemory);
-
-			command->CopyBuffer(stagingBuffer, buffer, bufferSize);
+				buffer, allocation);
 
-			vkDestroyBuffer(*logicalDevice, stagingBuffer, nullptr);
-			vkFreeMemory(*logicalDevice, stagingBufferMemory, nullptr);
+			uploadManager.UploadBuffer(buffer, inBuffer.data(), bufferSize);
 		}
 
+		// moves the contents to host memory the device reads over the bus, false when already there
+		bool Demote(VulkanUploadManager& uploadManager);
+
 		operator VkBuffer() const { return buffer; }
+		const VulkanAllocation& GetAllocation() const { return allocation; }
 
 	public:
+		// host visible memory comes back persistently mapped through allocation.mappedData.
+		// shared buffers are concurrent with the async compute queue, so both queues use them without ownership transfers
 		static void CreateBuffer(
-			const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, 
 			const std::shared_ptr<VulkanLogicalDevice>& logicalDevice,
 			VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, 
-			VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+			VkBuffer& buffer, VulkanAllocation& allocation, bool bSharedWithCompute = false);
+
+	private:
+		// hands the buffer and its memory to the deletion queue
+		void Retire();
 
 	private:
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
 
-		VkBuffer buffer;
-		VkDeviceMemory bufferMemory;
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VulkanAllocation allocation;
+		VkDeviceSize size = 0;
+		VkBufferUsageFlags usage = 0;
 	};
 }
 
@@ -3,6 +3,7 @@
 #include "vulkan/vulkan_core.h"
 
 #include <memory>
+#include <vector>
 
 namespace FGEngine
 {
@@ -12,12 +13,14 @@ namespace FGEngine
 	class VulkanCommand
 	{
 	public:
-		VulkanCommand(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t bufferCount);
+		// one primary buffer per frame, and per frame secondaryCount pools with a secondary buffer each
+		VulkanCommand(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t bufferCount, uint32_t secondaryCount = 0);
 		~VulkanCommand();
 
 	private:
 		void CreateCommandPool(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& logicalDevice);
 		void CreateCommandBuffers(const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, uint32_t bufferCount);
+		void CreateSecondaryCommandBuffers(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, uint32_t bufferCount, uint32_t secondaryCount);
 
 	public:
 		VkCommandPool GetPool() const { return commandPool; }
@@ -28,17 +31,22 @@ namespace FGEngine
 			return true;
 		}
 
-		VkCommandBuffer BeginSingleTimeCommands();
-		void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
-
-		void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-		void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+		uint32_t GetSecondaryCount() const { return secondaryCount; }
+		// each secondary has its own pool, so different secondaries of a frame can be recorded on different threads
+		VkCommandBuffer GetSecondaryBuffer(uint32_t index, uint32_t secondaryIndex) const { return secondaryCommandBuffers[index * secondaryCount + secondaryIndex]; }
+		// recycles the secondaries of a frame at once, the frame must not be in flight
+		void ResetSecondaryBuffers(uint32_t index);
 
 	private:
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
 
 		VkCommandPool commandPool;
 		std::vector<VkCommandBuffer> commandBuffers;
+
+		uint32_t secondaryCount = 0;
+		// frame major, secondaryCount entries per frame
+		std::vector<VkCommandPool> secondaryCommandPools;
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
 	};
 }
 
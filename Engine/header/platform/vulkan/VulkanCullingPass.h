@@ -0,0 +1,138 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/glm.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+	class VulkanComputePipeline;
+
+	// what the vertex shader reads per instance, matches InstanceData of TestShader.vert
+	struct VulkanInstanceData
+	{
+		alignas(16) glm::mat4 transform;
+		alignas(16) glm::vec4 color;
+	};
+
+	// culling input, matches ObjectData of CullInstances.comp
+	struct VulkanCullObject
+	{
+		alignas(16) glm::mat4 transform;
+		alignas(16) glm::vec4 color;
+		// local space, xyz center and w radius
+		alignas(16) glm::vec4 boundingSphere;
+		uint32_t drawIndex;
+	};
+
+	/*
+	* GPU frustum culling feeding indirect draws.
+	*
+	* Every frame the renderer writes one object per submission and one VkDrawIndexedIndirectCommand per instanced draw,
+	* with instanceCount 0 and firstInstance at the start of the draw's object range. Dispatch() tests every object's
+	* bounding sphere against the frustum of the frame's uniforms (so it sees the late latched camera) and appends
+	* the visible ones to the instance range of their draw, counting them in instanceCount.
+	*
+	* When the device has an async compute queue the culling is submitted there instead, overlapping the graphics work
+	* still in flight. The buffers are shared concurrently between both queue families and the graphics submission
+	* waits on the timeline value returned by Submit() before reading the draws.
+	*/
+	class VulkanCullingPass
+	{
+	public:
+		// the uniforms are bound as UNIFORM_BUFFER_DYNAMIC, their offset is given to Dispatch()
+		VulkanCullingPass(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, VkBuffer uniformBuffer, uint64_t uniformBufferObjectSize);
+		~VulkanCullingPass();
+
+		VulkanCullingPass(const VulkanCullingPass&) = delete;
+		VulkanCullingPass& operator=(const VulkanCullingPass&) = delete;
+
+		// grows the buffers of a frame that is not in flight, true when its instance buffer was replaced
+		// and the descriptor sets reading it have to be rewritten
+		bool Reserve(uint32_t frame, uint32_t objectCount, uint32_t drawCount);
+		// rewrites the set of a frame that is not in flight when the uniform buffer was replaced
+		void SetUniformBuffer(uint32_t frame, VkBuffer uniformBuffer);
+
+		// persistently mapped and host coherent, written by the CPU before the frame is submitted
+		VulkanCullObject* GetObjects(uint32_t frame) const;
+		VkDrawIndexedIndirectCommand* GetDraws(uint32_t frame) const;
+
+		// records the culling outside of a render pass, without async compute. the reads of the draws and instances
+		// are synchronised by whoever records it, the render graph in the renderer
+		void Dispatch(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t objectCount, uint32_t uniformOffset);
+
+		// with async compute, submits the culling of a frame that is not in flight to the compute queue.
+		// returns the timeline value to wait for before drawing, 0 when there is nothing to wait for
+		uint64_t Submit(uint32_t frame, uint32_t objectCount, uint32_t uniformOffset);
+
+		bool IsAsync() const { return bAsyncCompute; }
+		VkSemaphore GetTimelineSemaphore() const { return timelineSemaphore; }
+
+		VkBuffer GetDrawBuffer(uint32_t frame) const { return frames[frame].drawBuffer.buffer; }
+		const std::vector<VkBuffer>& GetInstanceBuffers() const { return instanceBuffers; }
+
+	public:
+		static constexpr uint32_t InitialObjectCapacity = 1024;
+		static constexpr uint32_t InitialDrawCapacity = 64;
+		static constexpr uint32_t WorkgroupSize = 64;
+
+	private:
+		struct Buffer
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VulkanAllocation allocation;
+		};
+
+		struct Frame
+		{
+			VkBuffer uniformBuffer;
+			Buffer objectBuffer;
+			Buffer drawBuffer;
+			VulkanAllocation instanceAllocation;
+			uint32_t objectCapacity = 0;
+			uint32_t drawCapacity = 0;
+
+			VkDescriptorSet descriptorSet;
+			// async compute only
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		};
+
+		void CreateDescriptorSetLayout();
+		void CreateDescriptorPool();
+		void CreatePipeline();
+		void CreateComputeCommands();
+
+		void RecordCulling(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t objectCount, uint32_t uniformOffset);
+
+		void CreateObjectBuffers(uint32_t frame, uint32_t capacity);
+		void CreateDrawBuffer(uint32_t frame, uint32_t capacity);
+		void WriteDescriptorSet(uint32_t frame);
+		// frames in flight may still read it
+		void RetireBuffer(VkBuffer buffer, const VulkanAllocation& allocation);
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+		uint64_t uniformBufferObjectSize;
+
+		VkDescriptorSetLayout descriptorSetLayout;
+		VkDescriptorPool descriptorPool;
+		std::unique_ptr<VulkanComputePipeline> pipeline;
+
+		bool bAsyncCompute;
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		// counts compute submissions
+		VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+		uint64_t timelineValue = 0;
+
+		std::vector<Frame> frames;
+		// output of the culling, the instance buffer bound to the material descriptor sets of each frame
+		std::vector<VkBuffer> instanceBuffers;
+	};
+}
@@ -10,6 +10,10 @@ namespace FGEngine
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		// transfer only, DMA engines that copy without holding up the graphics queue
+		std::optional<uint32_t> transferFamily;
+		// compute without graphics, runs alongside the graphics queue
+		std::optional<uint32_t> computeFamily;
 
 		bool IsComplete()
 		{
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace FGEngine
+{
+	/*
+	* Deferred destruction of GPU objects.
+	*
+	* Destroyed resources are retired with the number of the frame being recorded, and their deleter only runs
+	* once the renderer reports that frame as completed (its in-flight fence signaled). Frames complete in order,
+	* so every submission that could still reference the resource has finished by then.
+	* Deleters must not hold a reference to the logical device, which owns the queue.
+	*/
+	class VulkanDeletionQueue
+	{
+	public:
+		VulkanDeletionQueue() = default;
+		~VulkanDeletionQueue();
+
+		VulkanDeletionQueue(const VulkanDeletionQueue&) = delete;
+		VulkanDeletionQueue& operator=(const VulkanDeletionQueue&) = delete;
+
+		void Retire(std::function<void()>&& deleter);
+
+		// closes the frame that was just submitted, the returned number is what Collect() expects once its fence signals
+		uint64_t EndFrame();
+
+		// runs the deleters retired up to and including completedFrame
+		void Collect(uint64_t completedFrame);
+
+		// runs every deleter, only valid while the device is idle
+		void Flush();
+
+		uint64_t GetCurrentFrame() const;
+		size_t GetPendingCount() const;
+
+	private:
+		struct Entry
+		{
+			uint64_t frame;
+			std::function<void()> deleter;
+		};
+
+		mutable std::mutex mutex;
+		// frame numbers only grow, so entries are sorted by frame
+		std::deque<Entry> entries;
+		uint64_t currentFrame = 1;
+	};
+}
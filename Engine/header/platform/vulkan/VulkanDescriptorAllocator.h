@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+
+	/*
+	* Transient descriptor sets, allocated per frame in flight.
+	*
+	* Each frame owns a chain of pools. When the current pool runs out, the next one is taken from the frame's
+	* free list or created with twice the capacity of the last, up to MaxSetsPerPool. Sets are never freed one by one,
+	* ResetFrame() resets every pool of the frame once its fence has signalled and they all become free again.
+	*/
+	class VulkanDescriptorAllocator
+	{
+	public:
+		VulkanDescriptorAllocator(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, uint32_t initialSetsPerPool = 64);
+		~VulkanDescriptorAllocator();
+
+		VulkanDescriptorAllocator(const VulkanDescriptorAllocator&) = delete;
+		VulkanDescriptorAllocator& operator=(const VulkanDescriptorAllocator&) = delete;
+
+		// valid until ResetFrame() of the same frame
+		VkDescriptorSet Allocate(uint32_t frame, VkDescriptorSetLayout layout);
+
+		// returns every set of the frame at once, the frame must no longer be in flight
+		void ResetFrame(uint32_t frame);
+
+	public:
+		static constexpr uint32_t MaxSetsPerPool = 4096;
+
+	private:
+		struct Frame
+		{
+			VkDescriptorPool currentPool = VK_NULL_HANDLE;
+			std::vector<VkDescriptorPool> usedPools;
+			std::vector<VkDescriptorPool> freePools;
+		};
+
+		VkDescriptorPool NextPool(Frame& frame);
+		VkDescriptorPool CreatePool(uint32_t setCount);
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		std::vector<Frame> frames;
+		uint32_t setsPerPool;
+	};
+
+	// collects the writes of one set and applies them in a single vkUpdateDescriptorSets
+	class VulkanDescriptorWriter
+	{
+	public:
+		VulkanDescriptorWriter& WriteBuffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+		VulkanDescriptorWriter& WriteImage(uint32_t binding, VkDescriptorType type, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+		void Update(VkDevice device, VkDescriptorSet descriptorSet);
+
+	private:
+		// deques, so the write structs can point into them while more infos are added
+		std::deque<VkDescriptorBufferInfo> bufferInfos;
+		std::deque<VkDescriptorImageInfo> imageInfos;
+		std::vector<VkWriteDescriptorSet> writes;
+	};
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+
+	/*
+	* Descriptor set layouts keyed by their bindings.
+	*
+	* Equal binding lists (in any order) return the same VkDescriptorSetLayout, which keeps pipeline layouts that
+	* are described separately compatible with each other. Layouts live as long as the cache.
+	*/
+	class VulkanDescriptorLayoutCache
+	{
+	public:
+		VulkanDescriptorLayoutCache(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice);
+		~VulkanDescriptorLayoutCache();
+
+		VulkanDescriptorLayoutCache(const VulkanDescriptorLayoutCache&) = delete;
+		VulkanDescriptorLayoutCache& operator=(const VulkanDescriptorLayoutCache&) = delete;
+
+		// immutable samplers are not supported
+		VkDescriptorSetLayout GetOrCreate(std::vector<VkDescriptorSetLayoutBinding> bindings);
+
+	private:
+		struct LayoutKey
+		{
+			// sorted by binding
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+			bool operator==(const LayoutKey& other) const;
+		};
+
+		struct LayoutKeyHash
+		{
+			size_t operator()(const LayoutKey& key) const;
+		};
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		std::mutex mutex;
+		std::unordered_map<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> layouts;
+	};
+}
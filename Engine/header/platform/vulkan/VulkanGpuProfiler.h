@@ -0,0 +1,96 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "renderer/Renderer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanPhysicalDevice;
+	class VulkanLogicalDevice;
+
+	/*
+	* GPU timings of named scopes on the graphics queue.
+	*
+	* Every frame in flight has its own timestamp query pool, two queries per scope, and a pipeline statistics pool
+	* when the device supports them. Only one statistics query can be active at a time, so statistics are gathered for
+	* scopes begun with bStatistics, which must not nest. A frame's results are read in Collect() once its fence has
+	* signaled, without waiting, and kept until the next frame completes.
+	*
+	* Scopes are added on the recording thread. AddScope() only reserves one, so its timestamps can be written from
+	* whichever thread records the command buffer it belongs to, e.g. a secondary of the main pass.
+	*/
+	class VulkanGpuProfiler
+	{
+	public:
+		VulkanGpuProfiler(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, uint32_t inMaxScopes = DefaultMaxScopes);
+		~VulkanGpuProfiler();
+
+		VulkanGpuProfiler(const VulkanGpuProfiler&) = delete;
+		VulkanGpuProfiler& operator=(const VulkanGpuProfiler&) = delete;
+
+		// reads the results of frame, its fence must have signaled
+		void Collect(uint32_t frame);
+		// resets the queries of frame, recorded first into its command buffer outside of a render pass
+		void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber);
+
+		// UINT32_MAX once the frame is out of scopes, the write functions ignore it
+		uint32_t AddScope(const std::string& name);
+		void WriteBegin(VkCommandBuffer commandBuffer, uint32_t scope) const;
+		void WriteEnd(VkCommandBuffer commandBuffer, uint32_t scope) const;
+
+		// scopes added until EndScope() nest inside it
+		uint32_t BeginScope(VkCommandBuffer commandBuffer, const std::string& name, bool bStatistics = false);
+		void EndScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+		// what secondaries executed inside the open scopes have to inherit, see VkCommandBufferInheritanceInfo
+		VkQueryPipelineStatisticFlags GetInheritedStatistics() const { return bStatisticsOpen ? statisticFlags : 0; }
+
+		bool IsEnabled() const { return bTimestamps || statisticFlags != 0; }
+		// empty until the first frame completed
+		const GpuFrameStats& GetLastFrameStats() const { return lastFrameStats; }
+
+	public:
+		static constexpr uint32_t DefaultMaxScopes = 256;
+
+	private:
+		struct Scope
+		{
+			std::string name;
+			uint32_t depth;
+			bool bStatistics;
+		};
+
+		struct Frame
+		{
+			VkQueryPool timestampPool = VK_NULL_HANDLE;
+			VkQueryPool statisticsPool = VK_NULL_HANDLE;
+			std::vector<Scope> scopes;
+			uint64_t frameNumber = 0;
+			// recorded and not collected yet
+			bool bPending = false;
+		};
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		std::vector<Frame> frames;
+		uint32_t maxScopes;
+		// the frame being recorded
+		uint32_t currentFrame = 0;
+		std::vector<uint32_t> openScopes;
+		bool bStatisticsOpen = false;
+		bool bOutOfScopesLogged = false;
+
+		bool bTimestamps = false;
+		// nanoseconds per tick
+		float timestampPeriod = 1.0f;
+		uint64_t timestampMask = 0;
+		VkQueryPipelineStatisticFlags statisticFlags = 0;
+
+		GpuFrameStats lastFrameStats;
+	};
+}
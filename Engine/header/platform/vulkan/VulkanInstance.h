@@ -17,17 +17,20 @@ namespace FGEngine
 	class VulkanInstance
 	{
 	public:
+		// headless without a window, there is no surface then
 		VulkanInstance(GLFWwindow* nativeWindow, const VulkanInstanceParameters& parameters);
 		~VulkanInstance();
 
 	private:
 		bool IsValidationLayerSupported() const;
-		void CreateInstance(const VulkanInstanceParameters& parameters);
+		void CreateInstance(const VulkanInstanceParameters& parameters, bool bWithSurface);
 		void CreateSurface(GLFWwindow* nativeWindow);
 
 	public:
 		operator VkInstance_T*() const { return instance; }
 		VkSurfaceKHR_T* GetSurface() const { return surface; }
+		// the version the instance was created with, capped to what the engine targets
+		uint32_t GetApiVersion() const { return apiVersion; }
 
 	public:
 #ifdef NDEBUG
@@ -42,6 +45,7 @@ namespace FGEngine
 
 	private:
 		VkInstance_T* instance;
-		VkSurfaceKHR_T* surface;
+		VkSurfaceKHR_T* surface = nullptr;
+		uint32_t apiVersion;
 	};
 }
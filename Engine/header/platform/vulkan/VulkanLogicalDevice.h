@@ -8,6 +8,9 @@ namespace FGEngine
 {
 	class VulkanInstance;
 	class VulkanPhysicalDevice;
+	class VulkanMemoryAllocator;
+	class VulkanDeletionQueue;
+	class VulkanPipelineCache;
 
 	class VulkanLogicalDevice
 	{
@@ -18,12 +21,43 @@ namespace FGEngine
 		operator VkDevice () const { return device; }
 
 		VkQueue GetGraphicsQueue() const { return graphicsQueue; }
+		uint32_t GetGraphicsQueueFamily() const { return graphicsQueueFamily; }
 		VkQueue GetPresentQueue() const { return presentQueue; }
+		// the graphics queue when the device has no transfer only family or no timeline semaphores
+		VkQueue GetTransferQueue() const { return transferQueue; }
+		uint32_t GetTransferQueueFamily() const { return transferQueueFamily; }
+		bool HasDedicatedTransferQueue() const { return bDedicatedTransferQueue; }
+		// async compute, the graphics queue under the same conditions as the transfer queue
+		VkQueue GetComputeQueue() const { return computeQueue; }
+		uint32_t GetComputeQueueFamily() const { return computeQueueFamily; }
+		bool HasDedicatedComputeQueue() const { return bDedicatedComputeQueue; }
+
+		VulkanMemoryAllocator& GetAllocator() const { return *allocator; }
+		VulkanDeletionQueue& GetDeletionQueue() const { return *deletionQueue; }
+		VulkanPipelineCache& GetPipelineCache() const { return *pipelineCache; }
+
+		bool IsBindlessEnabled() const { return bBindlessEnabled; }
+		bool IsTimelineSemaphoreEnabled() const { return bTimelineSemaphoreEnabled; }
+		bool IsPipelineStatisticsEnabled() const { return bPipelineStatisticsEnabled; }
 
 	private:
 		VkDevice device;
 		VkQueue graphicsQueue;
 		VkQueue presentQueue;
+		uint32_t graphicsQueueFamily;
+		VkQueue transferQueue;
+		uint32_t transferQueueFamily;
+		bool bDedicatedTransferQueue;
+		VkQueue computeQueue;
+		uint32_t computeQueueFamily;
+		bool bDedicatedComputeQueue;
+		bool bBindlessEnabled;
+		bool bTimelineSemaphoreEnabled;
+		bool bPipelineStatisticsEnabled;
+
+		std::unique_ptr<VulkanMemoryAllocator> allocator;
+		std::unique_ptr<VulkanDeletionQueue> deletionQueue;
+		std::unique_ptr<VulkanPipelineCache> pipelineCache;
 	};
 }
 
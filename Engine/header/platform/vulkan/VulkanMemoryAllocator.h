@@ -0,0 +1,145 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanMemoryBlock;
+
+	// buffers and linear images never share a block with optimal images, which keeps bufferImageGranularity satisfied
+	enum class EVulkanResourceTiling : uint8_t
+	{
+		Linear,
+		Optimal,
+
+		Count
+	};
+
+	struct VulkanAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		// persistently mapped pointer to the start of the allocation, nullptr when not host visible
+		void* mappedData = nullptr;
+
+		uint32_t memoryTypeIndex = UINT32_MAX;
+		// nullptr for dedicated allocations
+		VulkanMemoryBlock* block = nullptr;
+		uint32_t order = 0;
+
+		bool IsValid() const { return memory != VK_NULL_HANDLE; }
+	};
+
+	struct VulkanMemoryStats
+	{
+		VkDeviceSize blockBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		VkDeviceSize dedicatedBytes = 0;
+		VkDeviceSize largestFreeRange = 0;
+		uint32_t blockCount = 0;
+		uint32_t allocationCount = 0;
+		uint32_t dedicatedCount = 0;
+		uint32_t freeRangeCount = 0;
+
+		// 0 when all free memory is one range, approaching 1 when free memory is split in many small ranges
+		float GetFragmentation() const
+		{
+			VkDeviceSize freeBytes = blockBytes - usedBytes;
+			return freeBytes > 0 ? 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(freeBytes) : 0.0f;
+		}
+	};
+
+	struct VulkanHeapBudget
+	{
+		VkDeviceSize size = 0;
+		// bytes the process may use before the OS starts paging, usage includes other allocations of the process
+		VkDeviceSize budget = 0;
+		VkDeviceSize usage = 0;
+	};
+
+	/*
+	* Device memory sub-allocator.
+	*
+	* Memory is allocated in large blocks per memory type and tiling, and carved up with a buddy allocator,
+	* so each resource costs a free-list operation instead of a vkAllocateMemory call. Host visible blocks
+	* stay mapped for their whole lifetime. Requests that are large compared to a block, or that ask for it
+	* (e.g. attachments that get recreated on resize), get a dedicated allocation.
+	*
+	* New device memory is placed on a heap that still has budget (VK_EXT_memory_budget when enabled, otherwise
+	* our own usage against a fraction of the heap size). When nothing fits, the allocation goes over budget,
+	* and device local requests fall back to host memory before giving up.
+	*/
+	class VulkanMemoryAllocator
+	{
+	public:
+		VulkanMemoryAllocator(VkPhysicalDevice inPhysicalDevice, VkDevice inDevice, bool bInMemoryBudgetSupported);
+		~VulkanMemoryAllocator();
+
+		VulkanMemoryAllocator(const VulkanMemoryAllocator&) = delete;
+		VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator&) = delete;
+
+		VulkanAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EVulkanResourceTiling tiling, bool bDedicated = false);
+		void Free(VulkanAllocation& allocation);
+
+		// allocates and binds
+		VulkanAllocation AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties);
+		VulkanAllocation AllocateImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling, bool bDedicated = false);
+
+		// re-queries the driver budgets, meant to be called once per frame
+		void UpdateBudgets();
+		VulkanHeapBudget GetHeapBudget(uint32_t heapIndex) const;
+		uint32_t GetHeapCount() const { return memoryProperties.memoryHeapCount; }
+		uint32_t GetHeapIndex(uint32_t memoryTypeIndex) const { return memoryProperties.memoryTypes[memoryTypeIndex].heapIndex; }
+		bool IsDeviceLocal(uint32_t memoryTypeIndex) const;
+
+		VulkanMemoryStats GetStats() const;
+		VulkanMemoryStats GetStats(uint32_t memoryTypeIndex) const;
+		void LogStats() const;
+
+	private:
+		struct Pool
+		{
+			std::vector<std::unique_ptr<VulkanMemoryBlock>> blocks;
+		};
+
+		bool TryAllocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EVulkanResourceTiling tiling, bool bDedicated, bool bWithinBudget, VulkanAllocation& outAllocation);
+		bool TryAllocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, EVulkanResourceTiling tiling, bool bDedicated, bool bWithinBudget, VulkanAllocation& outAllocation);
+		std::vector<uint32_t> GetMemoryTypeCandidates(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+		bool IsHostVisible(uint32_t memoryTypeIndex) const;
+		bool HasBudget(uint32_t heapIndex, VkDeviceSize size) const;
+		VulkanHeapBudget GetHeapBudgetLocked(uint32_t heapIndex) const;
+
+		// VK_NULL_HANDLE when the device is out of memory
+		VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** outMappedData);
+		void FreeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex);
+
+		void AccumulateStats(uint32_t memoryTypeIndex, VulkanMemoryStats& stats) const;
+
+	private:
+		VkDevice device;
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		VkDeviceSize bufferImageGranularity;
+		uint32_t maxAllocationCount;
+		VkPhysicalDevice physicalDevice;
+		bool bMemoryBudgetSupported;
+
+		mutable std::mutex mutex;
+		std::array<std::array<Pool, static_cast<size_t>(EVulkanResourceTiling::Count)>, VK_MAX_MEMORY_TYPES> pools;
+
+		std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> dedicatedBytes{};
+		std::array<uint32_t, VK_MAX_MEMORY_TYPES> dedicatedCount{};
+		uint32_t deviceAllocationCount = 0;
+
+		// device memory we hold per heap, and its value when the driver budget was last queried
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapAllocatedBytes{};
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> heapAllocatedBytesAtUpdate{};
+		std::array<VulkanHeapBudget, VK_MAX_MEMORY_HEAPS> heapBudgets{};
+	};
+}
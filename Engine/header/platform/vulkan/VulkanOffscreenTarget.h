@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+
+	/*
+	* What a headless renderer draws into instead of a swap chain.
+	*
+	* One color image per frame in flight, so a frame can be recorded while the one before is still on the GPU, and
+	* optionally a host visible buffer per image the frame is copied into. The data of a readback buffer is only
+	* valid once the fence of the frame that wrote it has signaled.
+	*/
+	class VulkanOffscreenTarget
+	{
+	public:
+		VulkanOffscreenTarget(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, VkExtent2D inExtent, uint32_t imageCount, bool bReadback);
+		~VulkanOffscreenTarget();
+
+		VulkanOffscreenTarget(const VulkanOffscreenTarget&) = delete;
+		VulkanOffscreenTarget& operator=(const VulkanOffscreenTarget&) = delete;
+
+		VkFormat GetImageFormat() const { return imageFormat; }
+		VkExtent2D GetExtent() const { return extent; }
+		VkImage GetImage(uint32_t index) const { return images[index]; }
+		VkImageView GetImageView(uint32_t index) const { return imageViews[index]; }
+
+		bool HasReadback() const { return !readbackBuffers.empty(); }
+		VkBuffer GetReadbackBuffer(uint32_t index) const { return readbackBuffers[index]; }
+		// tightly packed rows of the image
+		const void* GetReadbackData(uint32_t index) const { return readbackAllocations[index].mappedData; }
+		VkDeviceSize GetReadbackSize() const { return static_cast<VkDeviceSize>(extent.width) * extent.height * 4; }
+
+	public:
+		// 4 bytes per pixel, what GetReadbackSize() assumes
+		static constexpr VkFormat DefaultFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		VkFormat imageFormat = DefaultFormat;
+		VkExtent2D extent{};
+
+		std::vector<VkImage> images;
+		std::vector<VulkanAllocation> imageAllocations;
+		std::vector<VkImageView> imageViews;
+
+		// empty without readback
+		std::vector<VkBuffer> readbackBuffers;
+		std::vector<VulkanAllocation> readbackAllocations;
+	};
+}
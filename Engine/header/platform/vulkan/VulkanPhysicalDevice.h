@@ -20,16 +20,27 @@ namespace FGEngine
 		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
 		VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const;
 		VkFormat FindDepthFormat() const;
+		bool IsExtensionSupported(const char* extensionName) const;
 
 		operator VkPhysicalDevice () const { return physicalDevice; }
 		const QueueFamilyIndices GetQueueFamilyIndices() const { return queueFamilyIndices; }
 		const SwapChainSupportDetails GetSwapChainSupportDetails() const { return swapChainSupportDetails; }
 		VkSampleCountFlagBits GetMaxSampleCount() const { return maxSampleCount; }
+		uint32_t GetApiVersion() const { return apiVersion; }
+		// the Vulkan 1.2 descriptor indexing features VulkanBindlessTable relies on
+		bool IsBindlessSupported() const { return bBindlessSupported; }
+		bool IsTimelineSemaphoreSupported() const { return bTimelineSemaphoreSupported; }
+		// pipeline statistics queries that stay active across secondary command buffers
+		bool IsPipelineStatisticsSupported() const { return bPipelineStatisticsSupported; }
 
 	private:
 		VkPhysicalDevice physicalDevice;
 		QueueFamilyIndices queueFamilyIndices;
 		SwapChainSupportDetails swapChainSupportDetails;
 		VkSampleCountFlagBits maxSampleCount;
+		uint32_t apiVersion;
+		bool bBindlessSupported = false;
+		bool bTimelineSemaphoreSupported = false;
+		bool bPipelineStatisticsSupported = false;
 	};
 }
@@ -3,37 +3,103 @@
 #include "vulkan/vulkan_core.h"
 
 #include <memory>
+#include <vector>
 
 namespace FGEngine
 {
 	class VulkanLogicalDevice;
 	class VulkanShaderModule;
 
-	struct VulkanPipelineSetting
+	// everything a graphics pipeline is baked from, equal states produce interchangeable pipelines
+	struct VulkanPipelineState
 	{
 		std::shared_ptr<VulkanShaderModule> vertexShaderModule;
 		std::shared_ptr<VulkanShaderModule> fragmentShaderModule;
 
-		VkSampleCountFlagBits msaaSamples;
-		VkDescriptorSetLayout descriptorSetLayout;
-		VkRenderPass renderPass;
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+		VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+		VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+		VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+		VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		bool bDepthTest = true;
+		bool bDepthWrite = true;
+		VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+		// single color attachment
+		bool bBlend = false;
+		VkBlendFactor srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		VkBlendFactor dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+		VkBlendOp colorBlendOp = VK_BLEND_OP_ADD;
+		VkBlendFactor srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		VkBlendFactor dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		VkBlendOp alphaBlendOp = VK_BLEND_OP_ADD;
+		VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+		VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		// one per set index
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+
+		// the pipeline can be used in any render pass compatible with this one
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		uint32_t subpass = 0;
+
+		// straight alpha blending over what is already drawn, leaving the depth buffer untouched
+		void SetAlphaBlend();
+		// adds the color weighted by alpha to what is already drawn, leaving the depth buffer untouched
+		void SetAdditiveBlend();
+
+		// for lookups within a run, includes the handles of the set layouts and render pass
+		size_t Hash() const;
+		// the same in every run and build, covers what the pipeline manifest stores: shaders by file name,
+		// fixed function state, the number of set layouts and the push constant ranges
+		uint64_t PersistentHash() const;
+		bool operator==(const VulkanPipelineState& other) const;
 	};
 
 	class VulkanPipeline
 	{
 	public:
-		VulkanPipeline(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const VulkanPipelineSetting& setting);
+		VulkanPipeline(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const VulkanPipelineState& state, uint32_t inId = 0);
 		~VulkanPipeline();
 
 		operator VkPipeline () const { return graphicsPipeline; }
 
 		VkPipelineLayout GetLayout() const { return pipelineLayout; }
+		// small and stable for the lifetime of the pipeline, used to group draws by pipeline
+		uint32_t GetId() const { return id; }
 
 	private:
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
 
 		VkPipelineLayout pipelineLayout;
 		VkPipeline graphicsPipeline;
+		uint32_t id;
 	};
-}
 
+	// a single compute shader and its layout, usable on the graphics queue as well as the async compute queue
+	class VulkanComputePipeline
+	{
+	public:
+		VulkanComputePipeline(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const VulkanShaderModule& shaderModule,
+			const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges);
+		~VulkanComputePipeline();
+
+		VulkanComputePipeline(const VulkanComputePipeline&) = delete;
+		VulkanComputePipeline& operator=(const VulkanComputePipeline&) = delete;
+
+		operator VkPipeline () const { return computePipeline; }
+
+		VkPipelineLayout GetLayout() const { return pipelineLayout; }
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		VkPipelineLayout pipelineLayout;
+		VkPipeline computePipeline;
+	};
+}
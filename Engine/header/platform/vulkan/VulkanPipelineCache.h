@@ -0,0 +1,46 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+
+#include <string>
+#include <vector>
+
+namespace FGEngine
+{
+	/*
+	* VkPipelineCache persisted between runs.
+	*
+	* The cache file is loaded at startup and only handed to the driver when its header matches the vendor,
+	* device and pipeline cache UUID of the current physical device, so a driver update or a different GPU
+	* starts from an empty cache instead of feeding the driver data it would reject (or worse, misread).
+	* Save() writes the cache back through a temporary file, it is called on destruction and periodically by the renderer.
+	*/
+	class VulkanPipelineCache
+	{
+	public:
+		VulkanPipelineCache(VkPhysicalDevice physicalDevice, VkDevice inDevice, const std::string& inFilePath = DefaultFilePath);
+		~VulkanPipelineCache();
+
+		VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+		VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+		operator VkPipelineCache () const { return pipelineCache; }
+
+		// writes the cache to disk, skipped when its size has not changed since the last save
+		void Save();
+
+	public:
+		static constexpr const char* DefaultFilePath = "pipeline_cache.bin";
+
+	private:
+		bool IsCompatible(const std::vector<char>& data) const;
+
+	private:
+		VkDevice device;
+		VkPipelineCache pipelineCache;
+		std::string filePath;
+
+		VkPhysicalDeviceProperties deviceProperties;
+		size_t savedSize = 0;
+	};
+}
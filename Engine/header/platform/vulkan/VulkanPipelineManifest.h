@@ -0,0 +1,40 @@
+#pragma once
+
+#include "platform/vulkan/VulkanPipeline.h"
+
+#include <string>
+#include <vector>
+
+namespace FGEngine
+{
+	// a pipeline state as written to the manifest, shaders by file name
+	struct VulkanPipelineManifestEntry
+	{
+		std::string vertexShaderFilename;
+		std::string fragmentShaderFilename;
+		// VulkanPipelineState::PersistentHash() of the state when it was written
+		uint64_t persistentHash = 0;
+		// shader modules and render pass are left empty and the descriptor set layouts null, they only exist at runtime
+		VulkanPipelineState state;
+	};
+
+	/*
+	* List of the pipeline states created in earlier sessions.
+	*
+	* The renderer saves every compiled state on shutdown (and periodically) and pre-creates them on the next launch,
+	* so content seen before never compiles on first use. Entries are written in full rather than as hashes, a hash
+	* cannot be turned back into a pipeline. Descriptor set layouts and render pass are not stored, the renderer fills in
+	* its own, only the number of set layouts is kept so states from another descriptor mode can be told apart.
+	* Each entry starts with the persistent hash of its state, the one pipeline compile logs refer to.
+	*/
+	class VulkanPipelineManifest
+	{
+	public:
+		static bool Save(const std::string& filePath, const std::vector<VulkanPipelineState>& states);
+		// empty when the file is missing, unreadable or from another manifest version
+		static std::vector<VulkanPipelineManifestEntry> Load(const std::string& filePath);
+
+	public:
+		static constexpr uint32_t Version = 3;
+	};
+}
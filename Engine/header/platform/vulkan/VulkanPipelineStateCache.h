@@ -0,0 +1,96 @@
+#pragma once
+
+#include "platform/vulkan/VulkanPipeline.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+	class JobSystem;
+
+	/*
+	* Pipelines keyed by their VulkanPipelineState.
+	*
+	* Materials that resolve to the same state share one VkPipeline. Lookups take a shared lock, a miss inserts an
+	* empty entry under the exclusive lock and the pipeline is then created outside of it, so threads asking for
+	* different states compile in parallel while threads asking for the same one wait for the single creation.
+	*
+	* GetOrCreate() compiles on the calling thread. Request() never blocks, it queues the state for the compile
+	* threads and returns nullptr until the pipeline is ready, the caller draws with something compatible meanwhile.
+	* Every compilation is logged with its duration, the ones that happened on the caller's thread as warnings.
+	*/
+	class VulkanPipelineStateCache
+	{
+	public:
+		VulkanPipelineStateCache(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t compileThreadCount = 1);
+		~VulkanPipelineStateCache();
+
+		VulkanPipelineStateCache(const VulkanPipelineStateCache&) = delete;
+		VulkanPipelineStateCache& operator=(const VulkanPipelineStateCache&) = delete;
+
+		// creates the pipeline on first use, safe to call from any thread
+		std::shared_ptr<VulkanPipeline> GetOrCreate(const VulkanPipelineState& state);
+
+		// the pipeline if it is compiled, otherwise queues it for a compile thread and returns nullptr
+		std::shared_ptr<VulkanPipeline> Request(const VulkanPipelineState& state);
+
+		// compiles the states that are not in the cache yet across the job system, blocks until all are done
+		void Precreate(const std::vector<VulkanPipelineState>& states, JobSystem& jobSystem);
+
+		size_t GetPipelineCount() const;
+		// states of every pipeline compiled so far, what goes into the pipeline manifest
+		std::vector<VulkanPipelineState> GetCompiledStates() const;
+
+	public:
+		// synchronous compilations above this are reported as hitches
+		static constexpr double HitchThresholdMs = 2.0;
+
+	private:
+		struct Entry
+		{
+			std::once_flag created;
+			std::shared_ptr<VulkanPipeline> pipeline;
+			uint32_t id = 0;
+
+			std::atomic<bool> bReady = false;
+			std::atomic<bool> bQueued = false;
+		};
+
+		struct StateHash
+		{
+			size_t operator()(const VulkanPipelineState& state) const { return state.Hash(); }
+		};
+
+		struct CompileJob
+		{
+			VulkanPipelineState state;
+			std::shared_ptr<Entry> entry;
+		};
+
+		std::shared_ptr<Entry> FindOrInsert(const VulkanPipelineState& state);
+		void Compile(const VulkanPipelineState& state, Entry& entry, bool bBackground);
+
+		void CompileLoop();
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		mutable std::shared_mutex mutex;
+		std::unordered_map<VulkanPipelineState, std::shared_ptr<Entry>, StateHash> entries;
+
+		std::vector<std::thread> compileThreads;
+		std::mutex queueMutex;
+		std::condition_variable queueNotEmpty;
+		std::deque<CompileJob> compileQueue;
+		bool bStopping = false;
+	};
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+	class VulkanRenderGraph;
+	class VulkanGpuProfiler;
+
+	// resources are referred to by index, only meaningful for the graph that handed them out
+	struct VulkanGraphImage
+	{
+		uint32_t index = UINT32_MAX;
+		bool IsValid() const { return index != UINT32_MAX; }
+	};
+
+	struct VulkanGraphBuffer
+	{
+		uint32_t index = UINT32_MAX;
+		bool IsValid() const { return index != UINT32_MAX; }
+	};
+
+	// an image owned by the graph, sized to the extent given to Resize()
+	struct VulkanGraphImageDesc
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+		VkImageUsageFlags usage = 0;
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	};
+
+	// how a resource is touched, layout is ignored for buffers
+	struct VulkanGraphAccess
+	{
+		VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		VkAccessFlags access = 0;
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	};
+
+	// what a pass records with, render pass and framebuffer are only set for graphics passes
+	struct VulkanGraphContext
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		VkExtent2D extent{};
+	};
+
+	using VulkanGraphExecute = std::function<void(const VulkanGraphContext&)>;
+
+	// declares what a pass reads and writes, handed to the setup function of AddGraphicsPass/AddComputePass
+	class VulkanRenderGraphBuilder
+	{
+	public:
+		void WriteColor(VulkanGraphImage image, VkAttachmentLoadOp loadOp, VkClearColorValue clearColor = {});
+		void WriteDepth(VulkanGraphImage image, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearDepth = { 1.0f, 0 });
+		// resolve target of the color attachment written with the same index
+		void ResolveColor(VulkanGraphImage image);
+		// sampled in a shader of the given stages
+		void ReadImage(VulkanGraphImage image, VkPipelineStageFlags stage);
+		void ReadBuffer(VulkanGraphBuffer buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+		void WriteBuffer(VulkanGraphBuffer buffer, VkPipelineStageFlags stage, VkAccessFlags access);
+		// source of a vkCmdCopyImage*/vkCmdBlitImage
+		void CopyFromImage(VulkanGraphImage image);
+
+		// the pass records its draws into secondary command buffers executed inside the render pass
+		void UseSecondaryCommandBuffers();
+		// kept even when nothing reads what it writes
+		void SetSideEffects();
+
+	private:
+		friend class VulkanRenderGraph;
+		VulkanRenderGraphBuilder(VulkanRenderGraph& inGraph, uint32_t inPassIndex) : graph(inGraph), passIndex(inPassIndex) {}
+
+		VulkanRenderGraph& graph;
+		uint32_t passIndex;
+	};
+
+	/*
+	* Frame graph of render and compute passes.
+	*
+	* Passes are added once with a setup function declaring the resources they read and write, and an execute function
+	* recording their commands. Compile() drops passes whose results never reach an imported resource, works out the
+	* layout and access of every resource through the frame and turns it into one batched vkCmdPipelineBarrier ahead
+	* of each pass, and creates a render pass per graphics pass. Those render passes do no layout transitions of their
+	* own and only store attachments that are read later, so they stay the same across Resize().
+	*
+	* Transient images belong to the graph. Images whose lifetimes within the frame do not overlap share memory,
+	* the first use of each one waits for the last use of the image before it and starts from an undefined layout.
+	* Imported images and buffers are owned elsewhere and bound with SetImage()/SetBuffer() before Execute().
+	*/
+	class VulkanRenderGraph
+	{
+	public:
+		VulkanRenderGraph(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice);
+		~VulkanRenderGraph();
+
+		VulkanRenderGraph(const VulkanRenderGraph&) = delete;
+		VulkanRenderGraph& operator=(const VulkanRenderGraph&) = delete;
+
+		VulkanGraphImage CreateImage(const std::string& name, const VulkanGraphImageDesc& desc);
+		// in the initial state at the start of every frame and left in finalLayout, UNDEFINED to leave it as the last pass does.
+		// usage of the desc is ignored
+		VulkanGraphImage ImportImage(const std::string& name, const VulkanGraphImageDesc& desc, const VulkanGraphAccess& initial, VkImageLayout finalLayout);
+		// finalStage/finalAccess are made to wait for the last write of the frame, e.g. HOST for a buffer read back on the CPU
+		VulkanGraphBuffer ImportBuffer(const std::string& name, VkPipelineStageFlags finalStage = 0, VkAccessFlags finalAccess = 0);
+
+		void AddGraphicsPass(const std::string& name, const std::function<void(VulkanRenderGraphBuilder&)>& setup, VulkanGraphExecute&& execute);
+		// also for passes that only transfer, anything recorded outside of a render pass
+		void AddComputePass(const std::string& name, const std::function<void(VulkanRenderGraphBuilder&)>& setup, VulkanGraphExecute&& execute);
+
+		// culls passes, plans barriers and aliasing and creates the render passes, no passes can be added afterwards
+		void Compile();
+		// recreates the transient images and framebuffers, frames in flight keep the old ones until they complete
+		void Resize(VkExtent2D inExtent);
+
+		// framebuffers are cached by view, replacing imported views has to go with a Resize()
+		void SetImage(VulkanGraphImage image, VkImage vkImage, VkImageView vkImageView);
+		void SetBuffer(VulkanGraphBuffer buffer, VkBuffer vkBuffer);
+		// replaces the clear value given to WriteColor/WriteDepth in every pass clearing the image
+		void SetClearValue(VulkanGraphImage image, const VkClearValue& clearValue);
+
+		// records the compiled passes, outside of a render pass. with a profiler every pass is a scope of its own,
+		// with pipeline statistics
+		void Execute(VkCommandBuffer commandBuffer, VulkanGpuProfiler* profiler = nullptr);
+
+		// null for culled and compute passes
+		VkRenderPass GetRenderPass(const std::string& passName) const;
+
+	private:
+		friend class VulkanRenderGraphBuilder;
+
+		struct Resource
+		{
+			std::string name;
+			bool bImage = true;
+			bool bImported = false;
+			VulkanGraphImageDesc desc;
+
+			// imported only
+			VulkanGraphAccess initial;
+			VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags finalStage = 0;
+			VkAccessFlags finalAccess = 0;
+
+			// bound for the frame when imported, owned when transient
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView imageView = VK_NULL_HANDLE;
+			VkBuffer buffer = VK_NULL_HANDLE;
+
+			// transient only, live passes using it and the image whose memory it takes over
+			uint32_t firstPass = UINT32_MAX;
+			uint32_t lastPass = 0;
+			uint32_t aliasGroup = UINT32_MAX;
+			uint32_t previousAlias = UINT32_MAX;
+		};
+
+		struct Use
+		{
+			uint32_t resource;
+			VulkanGraphAccess access;
+			bool bRead;
+			bool bWrite;
+		};
+
+		struct Attachment
+		{
+			uint32_t resource = UINT32_MAX;
+			VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			VkClearValue clearValue{};
+		};
+
+		struct Barrier
+		{
+			uint32_t resource;
+			VkPipelineStageFlags srcStage;
+			VkAccessFlags srcAccess;
+			VkPipelineStageFlags dstStage;
+			VkAccessFlags dstAccess;
+			VkImageLayout oldLayout;
+			VkImageLayout newLayout;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			bool bGraphics = false;
+			bool bSecondary = false;
+			bool bSideEffects = false;
+
+			std::vector<Attachment> colors;
+			Attachment depth;
+			std::vector<uint32_t> resolves;
+			std::vector<Use> uses;
+			VulkanGraphExecute execute;
+
+			// compiled
+			bool bCulled = false;
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			std::vector<Barrier> barriers;
+		};
+
+		// where a resource is at a point of the frame, while planning barriers
+		struct ResourceState
+		{
+			VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkPipelineStageFlags writeStage = 0;
+			VkAccessFlags writeAccess = 0;
+			// reads since the last write
+			VkPipelineStageFlags readStages = 0;
+			// what already waited for the last write
+			VkPipelineStageFlags visibleStages = 0;
+			VkAccessFlags visibleAccess = 0;
+		};
+
+		void AddPass(const std::string& name, bool bGraphics, const std::function<void(VulkanRenderGraphBuilder&)>& setup, VulkanGraphExecute&& execute);
+
+		void CullPasses();
+		void AssignAliasGroups();
+		void PlanBarriers();
+		// applies use to state, appends the barrier it needs if any
+		static void PlanUse(uint32_t resource, bool bImage, const Use& use, ResourceState& state, std::vector<Barrier>& outBarriers);
+		void CreateRenderPass(Pass& pass);
+		bool IsReadAfter(uint32_t resource, uint32_t passIndex) const;
+
+		VkFramebuffer GetFramebuffer(const Pass& pass);
+		void RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers) const;
+
+		// transient images and framebuffers of the current extent, frames in flight may still use them
+		void RetireExtentResources();
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		std::vector<Resource> resources;
+		std::vector<Pass> passes;
+		// back to the imported final layouts and accesses after the last pass
+		std::vector<Barrier> finalBarriers;
+		bool bCompiled = false;
+
+		VkExtent2D extent{};
+		uint32_t aliasGroupCount = 0;
+		std::vector<VulkanAllocation> aliasAllocations;
+		// keyed by render pass and attachment views, swap chain images each get their own
+		std::map<std::vector<uint64_t>, VkFramebuffer> framebuffers;
+	};
+}
@@ -2,10 +2,21 @@
 
 #include "renderer/RendererAPI.h"
 #include "renderer/Vertex.h"
-
+#include "renderer/Camera.h"
+#include "renderer/RenderQueue.h"
+#include "renderer/Shader.h"
+#include "core/SlotMap.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+#include "platform/vulkan/VulkanPipeline.h"
+#include "platform/vulkan/VulkanUniformRing.h"
+#include "platform/vulkan/VulkanRenderGraph.h"
+
+#include <array>
 #include <vector>
 #include <optional>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 
 #define GLFW_INCLUDE_VULKAN
@@ -21,14 +32,75 @@ namespace FGEngine
 	class VulkanPhysicalDevice;
 	class VulkanLogicalDevice;
 	class VulkanSwapChain;
-	class VulkanPipeline;
+	class VulkanOffscreenTarget;
+	class VulkanGpuProfiler;
+	class VulkanPipelineStateCache;
+	class VulkanShaderModule;
 	class VulkanCommand;
-	class VulkanImageView;
+	class VulkanUploadManager;
+	class VulkanResidencyManager;
+	class VulkanCullingPass;
+	class JobSystem;
+	struct VulkanResidentResource;
 	class VulkanTextureImageView;
 	class VulkanBuffer;
-	class VulkanDescriptor;
+	class VulkanDescriptorAllocator;
+	class VulkanDescriptorLayoutCache;
+	class VulkanBindlessTable;
 
 	class Texture;
+	class Mesh;
+	class Shader;
+
+	struct VulkanMeshResource
+	{
+		Handle<VulkanBuffer> vertexBuffer;
+		Handle<VulkanBuffer> indexBuffer;
+		uint32_t indexCount = 0;
+		// local space, xyz center and w radius
+		glm::vec4 boundingSphere;
+
+		Handle<VulkanResidentResource> vertexResidency;
+		Handle<VulkanResidentResource> indexResidency;
+	};
+
+	struct VulkanTextureResource
+	{
+		Handle<VulkanTextureImageView> imageView;
+		Handle<VulkanResidentResource> residency;
+
+		// bindless slot and the image view generation written into it
+		uint32_t bindlessIndex = 0;
+		uint32_t bindlessGeneration = 0;
+	};
+
+	// per draw data in the uniform ring, matches DrawUniforms of the fragment shaders
+	struct VulkanDrawUniforms
+	{
+		alignas(16) glm::vec4 baseColor;
+	};
+
+	// matches PushConstants of TestShaderBindless.frag, only pushed with bindless
+	struct VulkanDrawConstants
+	{
+		uint32_t textureIndex;
+	};
+
+	struct VulkanMaterialResource
+	{
+		Handle<VulkanTextureResource> texture;
+		ERenderPass pass = ERenderPass::Opaque;
+		glm::vec4 baseColor = glm::vec4(1.0f);
+
+		// what the material is drawn with, the fallback of its pass until its own pipeline has compiled
+		std::shared_ptr<VulkanPipeline> pipeline;
+		VulkanPipelineState pipelineState;
+		bool bPipelineReady = false;
+
+		// transient, written by PrepareDraws for the frame it was drawn in last, unused with bindless
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		uint64_t descriptorSetFrame = UINT64_MAX;
+	};
 
 	class VulkanRendererAPI : public IRendererAPI
 	{
@@ -39,8 +111,17 @@ namespace FGEngine
 		// Inherited via IRendererAPI
 		virtual void SetClearColor(float r, float g, float b, float a) override;
 		virtual void Clear() const override;
-		virtual void Render(void* nativeWindow) override;
+		virtual void Render(void* nativeWindow, RenderQueue& renderQueue) override;
 		virtual void Resize() override;
+		virtual bool ReadLastFrame(FrameReadback& outFrame) override;
+		virtual bool GetGpuFrameStats(GpuFrameStats& outStats) const override;
+
+		virtual Handle<Texture> CreateTexture(const Texture& texture) override;
+		virtual void DestroyTexture(Handle<Texture> texture) override;
+		virtual Handle<Mesh> CreateMesh(const Mesh& mesh) override;
+		virtual void DestroyMesh(Handle<Mesh> mesh) override;
+		virtual Handle<Material> CreateMaterial(const Material& material) override;
+		virtual void DestroyMaterial(Handle<Material> material) override;
 
 		virtual std::string GetName() const override;
 		virtual std::string GetVersion() const override;
@@ -49,50 +130,117 @@ namespace FGEngine
 		static bool IsSupported();
 
 	private:
-		void CreateRenderPass();
-		void CreateColorResources();
-		void CreateDepthResources();
-		void LoadModel();
-		void CreateUniformBuffer();
+		// the frame's passes and attachments, the main pass provides the render pass every pipeline is built against
+		void BuildRenderGraph();
+		void CreateDescriptorSetLayouts();
+		void CreatePipelineStates();
+		// compiles the pipelines recorded in the manifest by earlier sessions
+		void PrecreatePipelines();
+		void SavePipelineManifest() const;
+		// one module per shader file, shared by every pipeline state using it
+		std::shared_ptr<VulkanShaderModule> LoadShaderModule(const std::string& filename, Shader::EType type);
 		void CreateSyncObjects();
 
 		void RecreateSwapChain();
+		// of the swap chain, or of the offscreen target when headless
+		VkExtent2D GetOutputExtent() const;
+		VkFormat GetOutputFormat() const;
+
+		Handle<VulkanResidentResource> RegisterResidency(Handle<VulkanBuffer> buffer);
+		Handle<VulkanResidentResource> RegisterResidency(Handle<VulkanTextureImageView> texture);
 
-		void UpdateUniformBuffer(uint32_t currentImage);
+		// swaps in the pipelines that finished compiling in the background
+		void ResolveMaterialPipelines();
+		void SortRenderQueue(RenderQueue& renderQueue) const;
+		// groups the sorted queue into instanced draws, writes their culling objects and indirect commands and the sets of their materials
+		void PrepareDraws(const RenderQueue& renderQueue, uint64_t frameNumber);
+
+		// applies the latest input snapshot plus the cursor movement since, and rewrites view/projection of the frame's uniforms
+		void LateLatchUniformBuffer(uint32_t currentImage);
 		void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		// executed by the render graph inside the main render pass
+		void RecordMainPass(const VulkanGraphContext& context);
+		// records draws [firstDraw, endDraw) into a secondary buffer inside profiler scope, called from worker threads
+		void RecordDraws(VkCommandBuffer commandBuffer, const VulkanGraphContext& context, uint32_t firstDraw, uint32_t endDraw, uint32_t scope) const;
 
 	private:
-		GLFWwindow* nativeWindow;
+		// null when headless
+		GLFWwindow* nativeWindow = nullptr;
 
 		std::shared_ptr<VulkanInstance> vulkanInstance;
 		std::shared_ptr<VulkanPhysicalDevice> physicalDevice;
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+		// exactly one of them, the offscreen target when headless
 		std::shared_ptr<VulkanSwapChain> swapChain;
-
+		std::shared_ptr<VulkanOffscreenTarget> offscreenTarget;
+
+		std::shared_ptr<VulkanRenderGraph> renderGraph;
+		VulkanGraphImage sceneColorImage;
+		// the acquired swap chain image, or the offscreen image of the frame
+		VulkanGraphImage outputImage;
+		// headless with readback only
+		VulkanGraphBuffer readbackBuffer;
+		// only in the graph without async compute, the timeline semaphore orders them otherwise
+		VulkanGraphBuffer cullDrawBuffer;
+		VulkanGraphBuffer cullInstanceBuffer;
+		// of the main pass, owned by the render graph
 		VkRenderPass renderPass;
 
-		std::shared_ptr<VulkanDescriptor> descriptor;
-
-		std::shared_ptr<VulkanPipeline> graphicsPipeline;
+		std::shared_ptr<VulkanDescriptorLayoutCache> descriptorLayoutCache;
+		std::shared_ptr<VulkanDescriptorAllocator> descriptorAllocator;
+		// set 0, the same for every material in bindless mode where textures come from the bindless table in set 1
+		VkDescriptorSetLayout materialSetLayout;
+		// null when the device lacks descriptor indexing
+		std::shared_ptr<VulkanBindlessTable> bindlessTable;
+		VkDescriptorSet frameDescriptorSet = VK_NULL_HANDLE;
+
+		std::shared_ptr<VulkanPipelineStateCache> pipelineStateCache;
+		std::unordered_map<std::string, std::shared_ptr<VulkanShaderModule>> shaderModules;
+		// what a material of each ERenderPass is drawn with
+		std::array<VulkanPipelineState, static_cast<size_t>(ERenderPass::Count)> passPipelineStates;
+		// compiled up front, stand in for material pipelines that are still compiling
+		std::array<std::shared_ptr<VulkanPipeline>, static_cast<size_t>(ERenderPass::Count)> fallbackPipelines;
+		uint32_t pendingPipelineCount = 0;
 		std::shared_ptr<VulkanCommand> command;
+		std::shared_ptr<JobSystem> jobSystem;
+		std::shared_ptr<VulkanUploadManager> uploadManager;
+		std::shared_ptr<VulkanResidencyManager> residencyManager;
+		std::shared_ptr<VulkanCullingPass> cullingPass;
+		std::shared_ptr<VulkanGpuProfiler> gpuProfiler;
+
+		// GPU resources live contiguously in slot maps and are referenced by handle
+		SlotMap<VulkanBuffer> buffers;
+		SlotMap<VulkanTextureImageView> textures;
+
+		// what the front-end handles resolve to, see HandleCast
+		SlotMap<VulkanMeshResource> meshResources;
+		SlotMap<VulkanTextureResource> textureResources;
+		SlotMap<VulkanMaterialResource> materialResources;
+
+		std::shared_ptr<VulkanUniformRing> uniformRing;
+		// the UniformBufferObject of the current frame
+		VulkanUniformAllocation frameUniforms;
+
+		// one per indirect command of the current frame, in the same order
+		struct DrawBatch
+		{
+			Handle<VulkanMeshResource> mesh;
+			Handle<VulkanMaterialResource> material;
+			// VulkanDrawUniforms in the uniform ring
+			uint32_t uniformOffset;
+			VulkanDrawConstants constants;
+		};
+		std::vector<DrawBatch> drawBatches;
+		uint32_t drawObjectCount = 0;
 
-		std::shared_ptr<VulkanBuffer> vertexBuffer;
-		std::shared_ptr<VulkanBuffer> indexBuffer;
-
-		std::vector<VkBuffer> uniformBuffers;
-		std::vector<VkDeviceMemory> uniformBuffersMemory;
-		std::vector<void*> uniformBuffersMapped;
-
+		Camera camera;
 
-		VkClearColorValue clearColor;
+		VkClearColorValue clearColor{};
 		std::vector<VkSemaphore> imageAvailableSemaphores;
 		std::vector<VkSemaphore> renderFinishedSemaphores;
 		std::vector<VkFence> inFlightFences;
-
-		std::shared_ptr<VulkanTextureImageView> textureImageView;
-
-		std::shared_ptr<VulkanImageView> colorImageView;
-		std::shared_ptr<VulkanImageView> depthImageView;
+		// deletion queue frame submitted with each in-flight fence, 0 while the slot is unused
+		std::vector<uint64_t> inFlightFrameNumbers;
 
 		VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
@@ -105,21 +253,19 @@ namespace FGEngine
 		};
 
 		const int MAX_FRAMES_IN_FLIGHT = 2;
-
-		// TODO: To move to it own class
-#pragma region Vertex Buffer
-	private:
-
-		class Model* model = nullptr;
-#pragma endregion
+		// below this a secondary costs more to hand out than to record on one thread
+		const uint32_t MIN_DRAWS_PER_SECONDARY = 32;
+		const uint64_t PIPELINE_CACHE_SAVE_INTERVAL = 3600;
+		const char* PIPELINE_MANIFEST_PATH = "pipeline_manifest.txt";
 
 #pragma region Descriptor
+		// model matrices are per instance, see VulkanInstanceData
 		struct UniformBufferObject
 		{
-			alignas(16) glm::mat4 model;
 			alignas(16) glm::mat4 view;
 			alignas(16) glm::mat4 projection;
 		};
+
 #pragma endregion
 
 	};
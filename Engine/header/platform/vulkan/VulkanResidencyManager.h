@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "core/SlotMap.h"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanLogicalDevice;
+
+	// where a resource's memory currently lives
+	struct VulkanResidency
+	{
+		uint32_t memoryTypeIndex = UINT32_MAX;
+		VkDeviceSize size = 0;
+	};
+
+	// lowers the memory cost of a resource (fewer mips, host memory, ...), updates the residency, false when nothing is left to give up
+	using VulkanDemoteFunction = std::function<bool(VulkanResidency&)>;
+
+	struct VulkanResidentResource
+	{
+		VulkanResidency residency;
+		VulkanDemoteFunction demote;
+		uint64_t lastUsedFrame = 0;
+		bool bDemotable = true;
+	};
+
+	/*
+	* Keeps device memory under the heap budgets reported by the allocator.
+	*
+	* Textures and meshes register with a demote function and are touched when drawn. Once per frame, heaps above
+	* the high watermark get their least recently used resources demoted until the projected usage drops below the
+	* low watermark. Demoted memory is released through the deletion queue, so a heap is left alone for a few frames
+	* after demoting to let the usage catch up.
+	*/
+	class VulkanResidencyManager
+	{
+	public:
+		VulkanResidencyManager(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t inFrameLatency);
+
+		Handle<VulkanResidentResource> Register(const VulkanResidency& residency, VulkanDemoteFunction&& demote);
+		void Unregister(Handle<VulkanResidentResource> handle);
+
+		void Touch(Handle<VulkanResidentResource> handle, uint64_t frame);
+
+		// refreshes the budgets and demotes resources on heaps that run out, call before recording the frame
+		void Update(uint64_t frame);
+
+	public:
+		static constexpr float HighWatermark = 0.95f;
+		static constexpr float LowWatermark = 0.85f;
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+		uint32_t frameLatency;
+
+		SlotMap<VulkanResidentResource> resources;
+		std::vector<uint64_t> heapCooldownFrames;
+	};
+}
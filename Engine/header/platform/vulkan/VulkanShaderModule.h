@@ -3,6 +3,7 @@
 #include "vulkan/vulkan_core.h"
 
 #include <memory>
+#include <string>
 
 namespace FGEngine
 {
@@ -18,12 +19,14 @@ namespace FGEngine
 		operator VkShaderModule () const { return shaderModule; }
 
 		VkPipelineShaderStageCreateInfo GetCreateInfo() const { return shaderStageCreateInfo; }
+		const std::string& GetFilename() const { return filename; }
 
 	private:
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
 
 		VkShaderModule shaderModule;
 		VkPipelineShaderStageCreateInfo shaderStageCreateInfo{};
+		std::string filename;
 	};
 }
 
@@ -23,21 +23,16 @@ namespace FGEngine
 		operator VkSwapchainKHR () const { return swapChain; }
 
 	private:
-		void CreateSwapChain(const std::shared_ptr<VulkanInstance>& vulkanInstance, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, GLFWwindow* nativeWindow);
+		void CreateSwapChain(const std::shared_ptr<VulkanInstance>& vulkanInstance, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, GLFWwindow* nativeWindow, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE);
 		void CreateImageViews();
 		void CleanUp();
 
-	public:
-		void CreateFrameBuffers(VkImageView colorImageView, VkImageView depthImageView, VkRenderPass renderPass);
-
 	public:
 		VkFormat GetImageFormat() const { return imageFormat; }
 		VkExtent2D GetExtent() const { return extent; }
-		VkFramebuffer GetFrameBuffer(uint32_t index) const
-		{
-			if (index < 0 || index >= frameBuffers.size()) return nullptr;
-			return frameBuffers[index];
-		}
+		// imported into the render graph, which owns the frame buffers
+		VkImage GetImage(uint32_t index) const { return images[index]; }
+		VkImageView GetImageView(uint32_t index) const { return imageViews[index]; }
 
 	private:
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
@@ -45,7 +40,6 @@ namespace FGEngine
 		VkSwapchainKHR swapChain;
 		std::vector<VkImage> images;
 		std::vector<VkImageView> imageViews;
-		std::vector<VkFramebuffer> frameBuffers;
 		VkFormat imageFormat;
 		VkExtent2D extent;
 	};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vulkan/vulkan_core.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
 
 #include <memory>
 
@@ -8,8 +9,7 @@ namespace FGEngine
 {
 	class VulkanPhysicalDevice;
 	class VulkanLogicalDevice;
-	class VulkanSwapChain;
-	class VulkanCommand;
+	class VulkanUploadManager;
 
 	class Texture;
 
@@ -19,27 +19,46 @@ namespace FGEngine
 		VulkanTextureImageView(
 			const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice,
 			const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice,
-			const std::shared_ptr<VulkanSwapChain>& swapChain,
-			const std::shared_ptr<VulkanCommand>& command,
+			VulkanUploadManager& uploadManager,
 			const Texture& texture);
 
 		~VulkanTextureImageView();
 
+		// stored by value in slot maps, so only movable
+		VulkanTextureImageView(const VulkanTextureImageView&) = delete;
+		VulkanTextureImageView& operator=(const VulkanTextureImageView&) = delete;
+		VulkanTextureImageView(VulkanTextureImageView&& other) noexcept;
+		VulkanTextureImageView& operator=(VulkanTextureImageView&& other) noexcept;
+
 		operator VkImageView() const { return imageView; }
 
 		VkSampler GetSampler() const { return sampler; }
+		const VulkanAllocation& GetAllocation() const { return imageAllocation; }
+		// bumped whenever the image view changes, descriptors referencing the old one need rewriting
+		uint32_t GetGeneration() const { return generation; }
+
+		// drops the top mip level to halve the memory cost, false when the texture is already small
+		bool Demote(VulkanUploadManager& uploadManager);
 
 	private:
 		void CreateTextureSampler(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice);
+		// hands image, view and memory to the deletion queue
+		void RetireImage();
+
+	private:
+		static constexpr uint32_t MinDemotedSize = 64;
 
 	private:
 		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
 
-		uint32_t mipLevels;
-		VkImage image;
-		VkDeviceMemory imageMemory;
-		VkImageView imageView;
-		VkSampler sampler;
+		uint32_t mipLevels = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t generation = 0;
+		VkImage image = VK_NULL_HANDLE;
+		VulkanAllocation imageAllocation;
+		VkImageView imageView = VK_NULL_HANDLE;
+		VkSampler sampler = VK_NULL_HANDLE;
 	};
 }
 
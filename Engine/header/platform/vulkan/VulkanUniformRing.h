@@ -0,0 +1,66 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanPhysicalDevice;
+	class VulkanLogicalDevice;
+
+	// offset is what goes into the dynamic offsets of vkCmdBindDescriptorSets
+	struct VulkanUniformAllocation
+	{
+		uint32_t offset = 0;
+		void* mappedData = nullptr;
+	};
+
+	/*
+	* Per-frame linear allocator for uniform data.
+	*
+	* One persistently mapped, host coherent buffer split into a region per frame in flight. Allocations are aligned
+	* to minUniformBufferOffsetAlignment and bound as UNIFORM_BUFFER_DYNAMIC, so one descriptor serves every
+	* allocation of the frame. A region is reset by BeginFrame(), which also grows the buffer when the frame asks for
+	* more than a region holds. Growing replaces the buffer, descriptor sets have to be written with GetBuffer() after it.
+	*/
+	class VulkanUniformRing
+	{
+	public:
+		VulkanUniformRing(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, VkDeviceSize inFrameSize = DefaultFrameSize);
+		~VulkanUniformRing();
+
+		VulkanUniformRing(const VulkanUniformRing&) = delete;
+		VulkanUniformRing& operator=(const VulkanUniformRing&) = delete;
+
+		// frame must not be in flight, true when the buffer was replaced
+		bool BeginFrame(uint32_t frame, VkDeviceSize requiredBytes);
+		VulkanUniformAllocation Allocate(uint32_t frame, VkDeviceSize size);
+
+		// what an allocation of size takes out of a region, padding included
+		VkDeviceSize GetAlignedSize(VkDeviceSize size) const;
+
+		VkBuffer GetBuffer() const { return buffer; }
+
+	public:
+		static constexpr VkDeviceSize DefaultFrameSize = 256ull * 1024;
+
+	private:
+		void CreateBuffer();
+		// frames in flight may still read it
+		void RetireBuffer();
+
+	private:
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VulkanAllocation allocation;
+		VkDeviceSize frameSize;
+		VkDeviceSize alignment;
+
+		// bytes used in each frame's region
+		std::vector<VkDeviceSize> frameHeads;
+	};
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace FGEngine
+{
+	class VulkanPhysicalDevice;
+	class VulkanLogicalDevice;
+
+	/*
+	* Batched uploads through a persistently mapped staging ring.
+	*
+	* Upload calls copy the source data into the ring and record the copy (and for images the layout
+	* transitions and mip generation) into the open batch command buffer. Flush() submits the batch with a fence,
+	* ring space is reclaimed once that fence signals, so nothing waits on the queue going idle.
+	* Uploads are only visible to work submitted to the graphics queue after the Flush() that carries them.
+	*
+	* With a dedicated transfer queue the copies from the ring run there and release the resources to the graphics
+	* queue family. A second command buffer on the graphics queue waits for the batch's timeline semaphore value,
+	* acquires the resources and does everything the transfer queue cannot, mip blits and device side copies.
+	*/
+	class VulkanUploadManager
+	{
+	public:
+		VulkanUploadManager(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, VkDeviceSize inRingSize = DefaultRingSize);
+		~VulkanUploadManager();
+
+		VulkanUploadManager(const VulkanUploadManager&) = delete;
+		VulkanUploadManager& operator=(const VulkanUploadManager&) = delete;
+
+		void UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+		// uploads mip 0 and leaves every level in SHADER_READ_ONLY_OPTIMAL, the remaining levels are blitted down from mip 0
+		void UploadImage(VkImage image, VkFormat format, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+		// device side copies, used to move resources between memory types
+		void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+		// copies mips [srcBaseMip, srcBaseMip + mipLevels) of a sampled image into mips [0, mipLevels) of dstImage, width/height are those of the dst mip 0.
+		// dstImage ends in SHADER_READ_ONLY_OPTIMAL, srcImage in TRANSFER_SRC_OPTIMAL and is not expected to be sampled again
+		void CopyImageMips(VkImage srcImage, uint32_t srcBaseMip, VkImage dstImage, uint32_t mipLevels, uint32_t width, uint32_t height);
+
+		// submits everything recorded since the last flush, no-op when nothing is pending
+		void Flush();
+
+		// blocks until every submitted batch has completed
+		void WaitIdle();
+
+		bool HasPendingUploads() const { return bRecording; }
+
+	public:
+		static constexpr VkDeviceSize DefaultRingSize = 32ull * 1024 * 1024;
+
+	private:
+		struct StagingBuffer
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VulkanAllocation allocation;
+		};
+
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+			// signaled by the graphics submission, which waits for the transfer one
+			VkFence fence = VK_NULL_HANDLE;
+
+			// ring position after the last allocation of this batch and the bytes it holds, including padding
+			VkDeviceSize ringEnd = 0;
+			VkDeviceSize ringBytes = 0;
+
+			// uploads larger than the ring get their own staging buffer, released with the batch
+			std::vector<StagingBuffer> oversizedBuffers;
+		};
+
+		struct StagingRange
+		{
+			VkBuffer buffer;
+			VkDeviceSize offset;
+			void* mappedData;
+		};
+
+		StagingRange AllocateStaging(VkDeviceSize size);
+		bool TryAllocateFromRing(VkDeviceSize size, VkDeviceSize& outOffset);
+
+		// graphics queue commands of the open batch, opens it when needed
+		VkCommandBuffer GetRecordingCommandBuffer();
+		// copies out of the ring, the graphics command buffer without a dedicated transfer queue
+		VkCommandBuffer GetTransferCommandBuffer();
+
+		// queue family ownership transfer of resources written by the transfer queue, no-op without one.
+		// the image is left in TRANSFER_DST_OPTIMAL
+		void ReleaseToGraphics(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+		void ReleaseToGraphics(VkImage image, uint32_t mipLevels);
+
+		void RetireCompletedBatches();
+		void WaitForOldestBatch();
+		void RetireBatch(Batch& batch);
+
+		void RecordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
+
+	private:
+		static constexpr uint32_t BatchCount = 3;
+
+		std::shared_ptr<VulkanLogicalDevice> logicalDevice;
+		VkPhysicalDevice physicalDevice;
+
+		VkCommandPool commandPool;
+		VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+		uint32_t graphicsQueueFamily;
+		uint32_t transferQueueFamily;
+		bool bDedicatedTransferQueue;
+
+		// counts transfer submissions, the graphics submission of a batch waits for its value
+		VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+		uint64_t timelineValue = 0;
+		std::array<Batch, BatchCount> batches;
+		// indices of submitted batches, oldest first
+		std::deque<uint32_t> submittedBatches;
+		uint32_t currentBatch = 0;
+		bool bRecording = false;
+
+		StagingBuffer ring;
+		VkDeviceSize ringSize;
+		VkDeviceSize ringAlignment;
+		VkDeviceSize ringHead = 0;
+		VkDeviceSize ringTail = 0;
+		VkDeviceSize ringUsedBytes = 0;
+	};
+}
@@ -10,16 +10,21 @@ namespace FGEngine
 {
 	class VulkanPhysicalDevice;
 	class VulkanLogicalDevice;
+	struct VulkanAllocation;
 
 	class VulkanUtil
 	{
 	public:
-		static void CreateImage(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, 
+		static void CreateImage(const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, 
 			uint32_t width, uint32_t height, uint32_t mipLevels,
 			VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-			VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
+			VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& imageAllocation, bool bDedicatedMemory = false);
 		static VkImageView CreateImageView(const std::shared_ptr<VulkanLogicalDevice>& device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 
+		// host allocation callbacks reporting to the memory tracker under the Vulkan tag, nullptr when tracking is disabled.
+		// children do not inherit the callbacks of their device, every create and its destroy has to pass them
+		static const VkAllocationCallbacks* GetAllocationCallbacks();
+
 
 		template <typename T>
 		static void VectorDestroy(void(*DestroyFunc)(VkDevice, T, const VkAllocationCallbacks*), VkDevice device, std::vector<T>& dataVector, const VkAllocationCallbacks* callback)
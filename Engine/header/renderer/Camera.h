@@ -0,0 +1,37 @@
+#pragma once
+
+#include "renderer/Vertex.h"
+
+namespace FGEngine
+{
+	struct InputSnapshot;
+
+	// Orbit camera around a target point. Left mouse drag rotates, mouse scroll zooms.
+	class Camera
+	{
+	public:
+		Camera();
+
+		// applies the input of the given snapshot once, calling again with the same snapshot frame does nothing
+		void ApplyInput(const InputSnapshot& snapshot);
+		// orbits by a cursor movement in pixels, what a left mouse drag does
+		void Rotate(const glm::dvec2& cursorDelta);
+
+		glm::mat4 GetView() const;
+		glm::mat4 GetProjection(float aspectRatio) const;
+		glm::vec3 GetPosition() const;
+		float GetFarPlane() const { return farPlane; }
+
+	private:
+		glm::vec3 target;
+		float yaw;
+		float pitch;
+		float distance;
+
+		float fieldOfView;
+		float nearPlane;
+		float farPlane;
+
+		uint64_t lastInputFrame = 0;
+	};
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core/SlotMap.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace FGEngine
+{
+	class Texture;
+
+	// passes are drawn in this order, the pass also picks the pipeline
+	enum class ERenderPass : uint8_t
+	{
+		Opaque,
+		Transparent,
+
+		Count
+	};
+
+	enum class EBlendMode : uint8_t
+	{
+		// none in the opaque pass, alpha blending in the transparent one
+		Default,
+		// adds to what is already drawn, only in the transparent pass
+		Additive
+	};
+
+	struct Material
+	{
+		Handle<Texture> texture;
+		ERenderPass pass = ERenderPass::Opaque;
+		// multiplied with the texture and the tint of every submission
+		glm::vec4 baseColor = glm::vec4(1.0f);
+
+		// overrides of the pipeline of the pass, a material with any of them is drawn with the pass pipeline until
+		// its own has compiled
+		// compiled shader files, empty for the shaders of the pass. A fragment shader reads the texture the way the
+		// one of the pass does, e.g. from the bindless table
+		std::string vertexShader;
+		std::string fragmentShader;
+		EBlendMode blendMode = EBlendMode::Default;
+		// no back face culling
+		bool bDoubleSided = false;
+	};
+}
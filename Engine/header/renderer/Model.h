@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/Core.h"
 #include "renderer/Mesh.h"
 #include "renderer/Texture.h"
 
@@ -8,7 +9,7 @@
 
 namespace FGEngine
 {
-	class Model
+	class ENGINE_API Model
 	{
 	public:
 		static Model* GenerateQuad();
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core/SlotMap.h"
+#include "renderer/Material.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace FGEngine
+{
+	class Mesh;
+
+	struct RenderItem
+	{
+		Handle<Mesh> mesh;
+		Handle<Material> material;
+		glm::mat4 transform;
+		glm::vec4 color;
+	};
+
+	struct RenderQueueEntry
+	{
+		uint64_t key;
+		uint32_t itemIndex;
+	};
+
+	/*
+	* Draws submitted for one frame.
+	*
+	* The backend gives every item a 64-bit sort key and sorts once per frame, so draws sharing a pipeline, material
+	* and mesh end up next to each other, their binds only have to be recorded once and runs of the same mesh and
+	* material become a single instanced draw.
+	* Opaque keys:      pass 4 | pipeline 12 | material 16 | mesh 12 | depth 20 (front to back)
+	* Transparent keys: pass 4 | depth 20 (back to front) | pipeline 12 | material 16 | mesh 12
+	* Ids wider than their field are truncated, that only costs some batching as the items keep the full handles.
+	*/
+	class RenderQueue
+	{
+	public:
+		void Submit(Handle<Mesh> mesh, Handle<Material> material, const glm::mat4& transform, const glm::vec4& color);
+		void Clear();
+
+		size_t Size() const { return items.size(); }
+		bool IsEmpty() const { return items.empty(); }
+
+		const std::vector<RenderItem>& GetItems() const { return items; }
+
+		// keys are indexed by submission order and only valid until Sort()
+		void SetSortKey(size_t itemIndex, uint64_t key) { entries[itemIndex].key = key; }
+		// radix sort on the keys, stable for equal keys
+		void Sort();
+		const std::vector<RenderQueueEntry>& GetSortedEntries() const { return entries; }
+
+		// depth is the normalized view distance in [0, 1]
+		static uint64_t MakeSortKey(ERenderPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+	private:
+		std::vector<RenderItem> items;
+		std::vector<RenderQueueEntry> entries;
+		std::vector<RenderQueueEntry> scratch;
+	};
+}
@@ -1,11 +1,49 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "core/Core.h"
 #include "renderer/RendererProperties.h"
+#include "renderer/RenderQueue.h"
 
 namespace FGEngine
 {
+	class Texture;
+	class Mesh;
+
+	// a rendered frame copied back to host memory, rows of tightly packed RGBA8
+	struct FrameReadback
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	// one named scope of a frame on the GPU, e.g. a render pass, a dispatch or a batch of draws
+	struct GpuScopeStats
+	{
+		std::string name;
+		// scopes are listed in the order they began, nested ones one deeper than the scope around them
+		uint32_t depth = 0;
+		double gpuTimeMs = 0.0;
+
+		// pipeline statistics, only gathered for the outermost scopes and zero when the device lacks them
+		bool bHasStatistics = false;
+		uint64_t inputPrimitives = 0;
+		uint64_t clippingPrimitives = 0;
+		uint64_t vertexInvocations = 0;
+		uint64_t fragmentInvocations = 0;
+		uint64_t computeInvocations = 0;
+	};
+
+	struct GpuFrameStats
+	{
+		uint64_t frameNumber = 0;
+		std::vector<GpuScopeStats> scopes;
+	};
+
 	class Renderer
 	{
 	public:
@@ -19,7 +57,26 @@ namespace FGEngine
 
 		static void Resize();
 
+		// the last frame submitted by Render(), waits for it to complete. only headless renderers with readback
+		// enabled have one, false otherwise
+		ENGINE_API static bool ReadLastFrame(FrameReadback& outFrame);
+		// GPU timings of the latest frame that completed, a frame or two behind Render(). false without GPU queries
+		ENGINE_API static bool GetGpuFrameStats(GpuFrameStats& outStats);
+
+		// GPU copies of assets, the source only has to live for the call
+		ENGINE_API static Handle<Texture> CreateTexture(const Texture& texture);
+		ENGINE_API static void DestroyTexture(Handle<Texture> texture);
+		ENGINE_API static Handle<Mesh> CreateMesh(const Mesh& mesh);
+		ENGINE_API static void DestroyMesh(Handle<Mesh> mesh);
+		ENGINE_API static Handle<Material> CreateMaterial(const Material& material);
+		ENGINE_API static void DestroyMaterial(Handle<Material> material);
+
+		// queues a draw for the next Render(), submit again every frame the mesh should be drawn.
+		// submissions of the same mesh and material are drawn instanced, color tints the instance
+		ENGINE_API static void Submit(Handle<Mesh> mesh, Handle<Material> material, const glm::mat4& transform, const glm::vec4& color = glm::vec4(1.0f));
+
 	private:
 		static std::unique_ptr<class IRendererAPI> s_api;
+		static RenderQueue s_renderQueue;
 	};
 }
\ No newline at end of file
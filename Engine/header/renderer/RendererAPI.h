@@ -13,8 +13,19 @@ namespace FGEngine
 		virtual void SetClearColor(float r, float g, float b, float a) = 0;
 		virtual void Clear() const = 0;
 
-		virtual void Render(void* nativeWindow) = 0;
+		// sorts and draws the queue, the caller clears it afterwards
+		virtual void Render(void* nativeWindow, RenderQueue& renderQueue) = 0;
 		virtual void Resize() = 0;
+		// only implemented by APIs that can render headless
+		virtual bool ReadLastFrame(FrameReadback& outFrame) { return false; }
+		virtual bool GetGpuFrameStats(GpuFrameStats& outStats) const { return false; }
+
+		virtual Handle<Texture> CreateTexture(const Texture& texture) = 0;
+		virtual void DestroyTexture(Handle<Texture> texture) = 0;
+		virtual Handle<Mesh> CreateMesh(const Mesh& mesh) = 0;
+		virtual void DestroyMesh(Handle<Mesh> mesh) = 0;
+		virtual Handle<Material> CreateMaterial(const Material& material) = 0;
+		virtual void DestroyMaterial(Handle<Material> material) = 0;
 
 		virtual std::string GetName() const = 0;
 		virtual std::string GetVersion() const = 0;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 struct GLFWwindow;
 
 namespace FGEngine
@@ -11,11 +13,21 @@ namespace FGEngine
 		Vulkan,
 	};
 
+	// rendering without a window into images owned by the renderer, e.g. on machines without a display
+	struct HeadlessProperties
+	{
+		uint32_t width = 1280;
+		uint32_t height = 720;
+		// copies every frame back to host memory, see Renderer::ReadLastFrame
+		bool bReadback = false;
+	};
+
 	struct RendererProperties
 	{
 	public:
 		RendererProperties() = default;
-		GLFWwindow* nativeWindow;
+		// headless when null
+		GLFWwindow* nativeWindow = nullptr;
 
 		RendererProperties(ERendererAPI rendererAPI, GLFWwindow* window) :
 			rendererAPI(rendererAPI),
@@ -23,7 +35,16 @@ namespace FGEngine
 		{
 		}
 
+		RendererProperties(ERendererAPI rendererAPI, const HeadlessProperties& headless) :
+			rendererAPI(rendererAPI),
+			headless(headless)
+		{
+		}
+
+		bool IsHeadless() const { return nativeWindow == nullptr; }
+
 	public:
 		ERendererAPI rendererAPI;
+		HeadlessProperties headless;
 	};
 }
\ No newline at end of file
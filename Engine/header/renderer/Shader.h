@@ -11,6 +11,7 @@ namespace FGEngine
 		{
 			Vertex,
 			Fragment,
+			Compute,
 		};
 
 	public:
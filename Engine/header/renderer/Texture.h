@@ -1,10 +1,12 @@
 #pragma once
 
+#include "core/Core.h"
+
 #include <string>
 
 namespace FGEngine
 {
-	class Texture
+	class ENGINE_API Texture
 	{
 	public:
 		Texture() = default;
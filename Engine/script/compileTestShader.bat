@@ -1,3 +1,7 @@
-"../tool/vulkan/glslc.exe" "../shader/TestShader.vert" -o "../../Application/shader/TestShaderVert.spv"
-"../tool/vulkan/glslc.exe" "../shader/TestShader.frag" -o "../../Application/shader/TestShaderFrag.spv"
+set GLSLC=%VULKAN_SDK%\Bin\glslc.exe
+if exist "../tool/vulkan/glslc.exe" set GLSLC=../tool/vulkan/glslc.exe
+"%GLSLC%" "../shader/TestShader.vert" -o "../../Application/shader/TestShaderVert.spv"
+"%GLSLC%" "../shader/TestShader.frag" -o "../../Application/shader/TestShaderFrag.spv"
+"%GLSLC%" "../shader/TestShaderBindless.frag" -o "../../Application/shader/TestShaderBindlessFrag.spv"
+"%GLSLC%" "../shader/CullInstances.comp" -o "../../Application/shader/CullInstancesComp.spv"
 pause
\ No newline at end of file
@@ -2,12 +2,19 @@
 
 layout(binding = 1) uniform sampler2D texSampler;
 
+// per draw, at a dynamic offset into the uniform ring
+layout(binding = 3) uniform DrawUniforms
+{
+    vec4 baseColor;
+} draw;
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec4 fragTint;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
     // outColor = vec4(fragTexCoord, 0.0, 1.0);
-    outColor = texture(texSampler, fragTexCoord);
+    outColor = texture(texSampler, fragTexCoord) * fragTint * draw.baseColor;
 }
\ No newline at end of file
@@ -2,20 +2,35 @@
 
 layout(binding = 0) uniform UniformBufferObject
 {
-    mat4 model;
     mat4 view;
     mat4 proj;
 } ubo;
 
+struct InstanceData
+{
+    mat4 model;
+    vec4 color;
+};
+
+layout(std430, binding = 2) readonly buffer InstanceBuffer
+{
+    InstanceData instances[];
+} instanceBuffer;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec4 fragTint;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    // gl_InstanceIndex includes the firstInstance of the draw
+    InstanceData instance = instanceBuffer.instances[gl_InstanceIndex];
+
+    gl_Position = ubo.proj * ubo.view * instance.model * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+    fragTint = instance.color;
 }
\ No newline at end of file
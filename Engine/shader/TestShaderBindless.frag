@@ -0,0 +1,28 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// VulkanBindlessTable
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+
+// per draw, at a dynamic offset into the uniform ring
+layout(binding = 3) uniform DrawUniforms
+{
+    vec4 baseColor;
+} draw;
+
+// VulkanDrawConstants
+layout(push_constant) uniform PushConstants
+{
+    uint textureIndex;
+} pushConstants;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec4 fragTint;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // the same for the whole draw, so no nonuniformEXT
+    outColor = texture(textures[pushConstants.textureIndex], fragTexCoord) * fragTint * draw.baseColor;
+}
@@ -2,12 +2,17 @@
 #include "core/Application.h"
 #include "core/AppLayer.h"
 #include "core/InputSubsystem.h"
+#include "core/MemoryTracker.h"
 #include "subsystem/SubsystemManager.h"
 
+#include <chrono>
+
 namespace FGEngine
 {
 Application::Application()
 {
+	ScopedMemoryTag memoryTag(EMemoryTag::Core);
+
 	bIsRunning = true;
 	window = std::unique_ptr<IWindow>(IWindow::Create());
 	window->windowDelegate.AddFunction(this, Application::OnWindowEvent);
@@ -24,16 +29,25 @@ Application::~Application()
 
 void Application::Run()
 {
-	float deltaTime = 0;	// TODO: setup delta time
+	// seconds the previous frame took, 0 for the first one
+	float deltaTime = 0;
+	auto lastFrameTime = std::chrono::steady_clock::now();
 	while (bIsRunning)
 	{
-		for (AppLayer* appLayer : layerStack)
 		{
-			appLayer->OnUpdate(deltaTime);
+			ScopedMemoryTag memoryTag(EMemoryTag::Layer);
+			for (AppLayer* appLayer : layerStack)
+			{
+				appLayer->OnUpdate(deltaTime);
+			}
 		}
 
 		window->OnUpdate(deltaTime);
 		inputSubsystem->ProcessQueue();
+
+		auto frameTime = std::chrono::steady_clock::now();
+		deltaTime = std::chrono::duration<float>(frameTime - lastFrameTime).count();
+		lastFrameTime = frameTime;
 	}
 }
 
@@ -86,6 +100,7 @@ void Application::OnWindowEvent(const std::shared_ptr<IWindowEvent>& windowEvent
 	case EWindowEventType::KeyReleased:
 	case EWindowEventType::KeyRepeated:
 	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Input);
 		inputSubsystem->AddQueue(windowEvent);
 	}
 	break;
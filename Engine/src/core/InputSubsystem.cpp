@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "core/InputSubsystem.h"
 #include "core/Logger.h"
+#include "core/MemoryTracker.h"
 #include "event/KeyboardEvent.h"
 #include "event/MouseEvent.h"
 
@@ -172,8 +173,10 @@ static EKeyState WindowEventTypeToEKeyState(EWindowEventType windowEventType)
 
 void InputSubsystem::ProcessQueue()
 {
-	mouseScroll = glm::vec2{};
-	cursorPreviousPosition = cursorPosition;
+	ScopedMemoryTag memoryTag(EMemoryTag::Input);
+
+	state.mouseScroll = glm::dvec2{};
+	glm::dvec2 cursorPreviousPosition = state.cursorPosition;
 
 	for (const std::shared_ptr<IWindowEvent>& windowEvent : queueEvents)
 	{
@@ -186,7 +189,7 @@ void InputSubsystem::ProcessQueue()
 			auto keyEvent = std::static_pointer_cast<KeyButtonEvent>(windowEvent);
 			EKey key = GLFWKeyToEKey(keyEvent->GetButton());
 			EKeyState keyState = WindowEventTypeToEKeyState(windowEvent->GetEventType());
-			keyStates[(size_t)key] = keyState;
+			state.keyStates[(size_t)key] = keyState;
 
 			inputKeyDelegate.Broadcast(key, keyState);
 		}
@@ -198,7 +201,7 @@ void InputSubsystem::ProcessQueue()
 			auto keyEvent = std::static_pointer_cast<MouseButtonEvent>(windowEvent);
 			EMouseButton button = GLFWMouseButtonToEMouseButton(keyEvent->GetButton());
 			EKeyState mouseState = WindowEventTypeToEKeyState(windowEvent->GetEventType());
-			mouseStates[(size_t)button] = mouseState;
+			state.mouseStates[(size_t)button] = mouseState;
 
 			inputMouseDelegate.Broadcast(button, mouseState);
 		}
@@ -206,15 +209,15 @@ void InputSubsystem::ProcessQueue()
 		case EWindowEventType::MouseScrolled:
 		{
 			auto mouseEvent = std::static_pointer_cast<MouseScrolledEvent>(windowEvent);
-			mouseScroll.x += mouseEvent->GetOffsetX();
-			mouseScroll.y += mouseEvent->GetOffsetY();
+			state.mouseScroll.x += mouseEvent->GetOffsetX();
+			state.mouseScroll.y += mouseEvent->GetOffsetY();
 		}
 		break;
 		case EWindowEventType::CursorPosition:
 		{
 			auto mouseEvent = std::static_pointer_cast<CursorPositionEvent>(windowEvent);
-			cursorPosition.x = mouseEvent->GetPositionX();
-			cursorPosition.y = mouseEvent->GetPositionY();
+			state.cursorPosition.x = mouseEvent->GetPositionX();
+			state.cursorPosition.y = mouseEvent->GetPositionY();
 		}
 		break;
 		case EWindowEventType::CursorEnterChanged:
@@ -230,16 +233,21 @@ void InputSubsystem::ProcessQueue()
 	}
 	queueEvents.clear();
 
-	cursorDelta = cursorPosition - cursorPreviousPosition;
-	if (cursorDelta.x != 0 || cursorDelta.y != 0)
+	state.cursorDelta = state.cursorPosition - cursorPreviousPosition;
+	state.frame++;
+
+	// publish before broadcasting, so listeners that kick off jobs already see this frame's input
+	snapshotBuffer.Publish(state);
+
+	if (state.cursorDelta.x != 0 || state.cursorDelta.y != 0)
 	{
-		inputCursorPositionDelegate.Broadcast(cursorPosition);
-		inputCursorMoveDelegate.Broadcast(cursorDelta);
+		inputCursorPositionDelegate.Broadcast(state.cursorPosition);
+		inputCursorMoveDelegate.Broadcast(state.cursorDelta);
 	}
 
-	if (mouseScroll.x != 0 || mouseScroll.y != 0)
+	if (state.mouseScroll.x != 0 || state.mouseScroll.y != 0)
 	{
-		inputMouseScrollDelegate.Broadcast(mouseScroll);
+		inputMouseScrollDelegate.Broadcast(state.mouseScroll);
 	}
 }
 
@@ -250,41 +258,41 @@ void InputSubsystem::AddQueue(const std::shared_ptr<IWindowEvent>& windowEvent)
 
 bool InputSubsystem::IsKeyPressed(EKey key) const
 {
-	return keyStates[(size_t)key] == EKeyState::Pressed;
+	return state.IsKeyPressed(key);
 }
 
 bool InputSubsystem::IsKeyReleased(EKey key) const
 {
-	return keyStates[(size_t)key] == EKeyState::Released;
+	return state.IsKeyReleased(key);
 }
 
 bool InputSubsystem::IsKeyRepeated(EKey key) const
 {
-	return keyStates[(size_t)key] == EKeyState::Repeated;
+	return state.IsKeyRepeated(key);
 }
 
 bool InputSubsystem::IsMouseButtonPressed(EMouseButton button) const
 {
-	return mouseStates[(size_t)button] == EKeyState::Pressed;
+	return state.IsMouseButtonPressed(button);
 }
 
 bool InputSubsystem::IsMouseButtonReleased(EMouseButton button) const
 {
-	return mouseStates[(size_t)button] == EKeyState::Released;
+	return state.IsMouseButtonReleased(button);
 }
 
 glm::dvec2 InputSubsystem::GetMouseScroll() const
 {
-	return mouseScroll;
+	return state.mouseScroll;
 }
 
 glm::dvec2 InputSubsystem::GetCursorPosition() const
 {
-	return cursorPosition;
+	return state.cursorPosition;
 }
 
 glm::dvec2 InputSubsystem::GetCursorDelta() const
 {
-	return cursorDelta;
+	return state.cursorDelta;
 }
 }
\ No newline at end of file
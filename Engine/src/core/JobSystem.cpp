@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "core/JobSystem.h"
+
+#include <algorithm>
+
+namespace FGEngine
+{
+	JobSystem::JobSystem(uint32_t workerCount)
+	{
+		if (workerCount == 0)
+		{
+			workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		}
+
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			workers.emplace_back(&JobSystem::WorkerLoop, this);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			bStopping = true;
+		}
+		workAvailable.notify_all();
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t index)>& inJob)
+	{
+		if (count == 0) return;
+
+		// not worth waking anyone
+		if (count == 1 || workers.empty())
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				inJob(i);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &inJob;
+			jobCount = count;
+			completedCount = 0;
+			nextIndex = 0;
+		}
+		workAvailable.notify_all();
+
+		RunJobs();
+
+		// workers still inside RunJobs() would otherwise see the next loop's state
+		std::unique_lock<std::mutex> lock(mutex);
+		workDone.wait(lock, [this]() { return completedCount == jobCount && activeWorkerCount == 0; });
+		job = nullptr;
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				// joining is only possible while indices are left, so a finished loop never has late workers
+				workAvailable.wait(lock, [this]() { return bStopping || (job && nextIndex < jobCount); });
+				if (bStopping) return;
+
+				activeWorkerCount++;
+			}
+
+			RunJobs();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				activeWorkerCount--;
+			}
+			workDone.notify_all();
+		}
+	}
+
+	void JobSystem::RunJobs()
+	{
+		uint32_t index;
+		while ((index = nextIndex.fetch_add(1)) < jobCount)
+		{
+			(*job)(index);
+
+			if (completedCount.fetch_add(1) + 1 == jobCount)
+			{
+				// the caller checks the count under the mutex, taking it here avoids a lost wakeup
+				std::lock_guard<std::mutex> lock(mutex);
+				workDone.notify_all();
+			}
+		}
+	}
+}
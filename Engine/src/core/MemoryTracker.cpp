@@ -0,0 +1,460 @@
+#include "pch.h"
+#include "core/MemoryTracker.h"
+#include "core/Logger.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#if defined(_MSC_VER) && ENABLE_MEMORY_TRACKING
+// the statics of this file are constructed ahead of the engine's others and so destroyed after them, see LeakReport
+#pragma warning(disable: 4073)
+#pragma init_seg(lib)
+#endif
+
+namespace FGEngine
+{
+#pragma region Helper
+	// the registry must not allocate through operator new, or every tracked allocation would recurse into itself
+	template<typename T>
+	struct MallocAllocator
+	{
+		using value_type = T;
+
+		MallocAllocator() = default;
+		template<typename U>
+		MallocAllocator(const MallocAllocator<U>&) noexcept {}
+
+		T* allocate(size_t count)
+		{
+			void* ptr = std::malloc(count * sizeof(T));
+			if (!ptr) throw std::bad_alloc();
+			return static_cast<T*>(ptr);
+		}
+
+		void deallocate(T* ptr, size_t)
+		{
+			std::free(ptr);
+		}
+
+		template<typename U>
+		bool operator==(const MallocAllocator<U>&) const { return true; }
+	};
+
+	struct AllocationRecord
+	{
+		size_t size;
+		EMemoryTag tag;
+		bool bAligned;
+	};
+
+	static bool NeedsAlignedAllocation(size_t alignment)
+	{
+		return alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+	}
+
+	static void* RawAllocate(size_t size, size_t alignment)
+	{
+		if (size == 0) size = 1;
+
+		if (!NeedsAlignedAllocation(alignment))
+		{
+			return std::malloc(size);
+		}
+
+#ifdef _WIN32
+		return _aligned_malloc(size, alignment);
+#else
+		void* ptr = nullptr;
+		return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+	}
+
+	static void RawFree(void* ptr, bool bAligned)
+	{
+#ifdef _WIN32
+		if (bAligned)
+		{
+			_aligned_free(ptr);
+			return;
+		}
+#endif
+		std::free(ptr);
+	}
+
+	struct TagCounters
+	{
+		std::atomic<size_t> currentBytes = 0;
+		std::atomic<size_t> currentCount = 0;
+		std::atomic<size_t> peakBytes = 0;
+		std::atomic<size_t> totalBytes = 0;
+		std::atomic<size_t> totalCount = 0;
+		std::atomic<size_t> budgetBytes = 0;
+		std::atomic<bool> bOverBudget = false;
+	};
+
+	class AllocationRegistry
+	{
+	public:
+		// never destroyed, memory is still freed while static objects are torn down
+		static AllocationRegistry& Get()
+		{
+			alignas(AllocationRegistry) static unsigned char storage[sizeof(AllocationRegistry)];
+			static AllocationRegistry* instance = new (storage) AllocationRegistry();
+			return *instance;
+		}
+
+		void Add(void* ptr, const AllocationRecord& record)
+		{
+			Shard& shard = GetShard(ptr);
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				shard.records[ptr] = record;
+			}
+			OnAllocated(record.tag, record.size);
+		}
+
+		bool Remove(void* ptr, AllocationRecord& outRecord)
+		{
+			Shard& shard = GetShard(ptr);
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				auto it = shard.records.find(ptr);
+				if (it == shard.records.end()) return false;
+
+				outRecord = it->second;
+				shard.records.erase(it);
+			}
+			OnFreed(outRecord.tag, outRecord.size);
+			return true;
+		}
+
+		template<typename Func>
+		void ForEach(Func&& func)
+		{
+			for (Shard& shard : shards)
+			{
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				for (const auto& [ptr, record] : shard.records)
+				{
+					func(ptr, record);
+				}
+			}
+		}
+
+		TagCounters& GetCounters(EMemoryTag tag)
+		{
+			return counters[static_cast<size_t>(tag)];
+		}
+
+	private:
+		void OnAllocated(EMemoryTag tag, size_t size)
+		{
+			TagCounters& tagCounters = GetCounters(tag);
+			size_t currentBytes = tagCounters.currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			tagCounters.currentCount.fetch_add(1, std::memory_order_relaxed);
+			tagCounters.totalBytes.fetch_add(size, std::memory_order_relaxed);
+			tagCounters.totalCount.fetch_add(1, std::memory_order_relaxed);
+
+			size_t peakBytes = tagCounters.peakBytes.load(std::memory_order_relaxed);
+			while (currentBytes > peakBytes && !tagCounters.peakBytes.compare_exchange_weak(peakBytes, currentBytes, std::memory_order_relaxed))
+			{
+			}
+
+			size_t budgetBytes = tagCounters.budgetBytes.load(std::memory_order_relaxed);
+			if (budgetBytes > 0 && currentBytes > budgetBytes && !tagCounters.bOverBudget.exchange(true))
+			{
+				LogWarning("Memory tag %s went over its budget (%zu / %zu bytes)", MemoryTracker::GetTagName(tag), currentBytes, budgetBytes);
+			}
+		}
+
+		void OnFreed(EMemoryTag tag, size_t size)
+		{
+			TagCounters& tagCounters = GetCounters(tag);
+			tagCounters.currentBytes.fetch_sub(size, std::memory_order_relaxed);
+			tagCounters.currentCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+	private:
+		static constexpr size_t ShardCount = 64;
+
+		struct Shard
+		{
+			std::mutex mutex;
+			std::unordered_map<void*, AllocationRecord, std::hash<void*>, std::equal_to<void*>,
+				MallocAllocator<std::pair<void* const, AllocationRecord>>> records;
+		};
+
+		Shard& GetShard(void* ptr)
+		{
+			// allocations are at least 16 bytes aligned, the low bits carry no information
+			return shards[(reinterpret_cast<uintptr_t>(ptr) >> 4) % ShardCount];
+		}
+
+		std::array<Shard, ShardCount> shards;
+		std::array<TagCounters, static_cast<size_t>(EMemoryTag::Count)> counters;
+	};
+
+	static constexpr uint32_t MaxTagDepth = 32;
+	static thread_local EMemoryTag tagStack[MaxTagDepth];
+	static thread_local uint32_t tagDepth = 0;
+
+	static void FreeInternal(void* ptr, bool bAlignedHint)
+	{
+		if (!ptr) return;
+
+		AllocationRecord record;
+		if (AllocationRegistry::Get().Remove(ptr, record))
+		{
+			RawFree(ptr, record.bAligned);
+		}
+		else
+		{
+			// allocated by another module or before tracking started
+			RawFree(ptr, bAlignedHint);
+		}
+	}
+#pragma endregion
+
+	void* MemoryTracker::Allocate(size_t size, size_t alignment)
+	{
+		return Allocate(size, alignment, GetCurrentTag());
+	}
+
+	void* MemoryTracker::Allocate(size_t size, size_t alignment, EMemoryTag tag)
+	{
+		void* ptr = RawAllocate(size, alignment);
+		if (ptr)
+		{
+			AllocationRegistry::Get().Add(ptr, { size, tag, NeedsAlignedAllocation(alignment) });
+		}
+		return ptr;
+	}
+
+	void* MemoryTracker::Reallocate(void* ptr, size_t size, size_t alignment)
+	{
+		return Reallocate(ptr, size, alignment, GetCurrentTag());
+	}
+
+	void* MemoryTracker::Reallocate(void* ptr, size_t size, size_t alignment, EMemoryTag tag)
+	{
+		if (!ptr)
+		{
+			return Allocate(size, alignment, tag);
+		}
+
+		if (size == 0)
+		{
+			Free(ptr);
+			return nullptr;
+		}
+
+		AllocationRegistry& registry = AllocationRegistry::Get();
+
+		AllocationRecord record;
+		bool bTracked = registry.Remove(ptr, record);
+		if (bTracked)
+		{
+			// a reallocation keeps the tag of the original allocation
+			tag = record.tag;
+		}
+
+		if (!NeedsAlignedAllocation(alignment) && (!bTracked || !record.bAligned))
+		{
+			void* newPtr = std::realloc(ptr, size);
+			if (!newPtr)
+			{
+				if (bTracked) registry.Add(ptr, record);
+				return nullptr;
+			}
+
+			registry.Add(newPtr, { size, tag, false });
+			return newPtr;
+		}
+
+		Check(bTracked, "Unable to reallocate untracked aligned memory %p", ptr);
+
+		void* newPtr = Allocate(size, alignment, tag);
+		if (!newPtr)
+		{
+			registry.Add(ptr, record);
+			return nullptr;
+		}
+
+		memcpy(newPtr, ptr, record.size < size ? record.size : size);
+		RawFree(ptr, record.bAligned);
+		return newPtr;
+	}
+
+	void MemoryTracker::Free(void* ptr)
+	{
+		FreeInternal(ptr, false);
+	}
+
+	void MemoryTracker::PushTag(EMemoryTag tag)
+	{
+		if (tagDepth < MaxTagDepth)
+		{
+			tagStack[tagDepth] = tag;
+		}
+		tagDepth++;
+	}
+
+	void MemoryTracker::PopTag()
+	{
+		Check(tagDepth > 0, "Memory tag stack underflow");
+		tagDepth--;
+	}
+
+	EMemoryTag MemoryTracker::GetCurrentTag()
+	{
+		if (tagDepth == 0) return EMemoryTag::Untagged;
+		return tagStack[(tagDepth < MaxTagDepth ? tagDepth : MaxTagDepth) - 1];
+	}
+
+	MemoryTagStats MemoryTracker::GetStats(EMemoryTag tag)
+	{
+		TagCounters& counters = AllocationRegistry::Get().GetCounters(tag);
+
+		MemoryTagStats stats;
+		stats.currentBytes = counters.currentBytes.load(std::memory_order_relaxed);
+		stats.currentCount = counters.currentCount.load(std::memory_order_relaxed);
+		stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+		stats.totalBytes = counters.totalBytes.load(std::memory_order_relaxed);
+		stats.totalCount = counters.totalCount.load(std::memory_order_relaxed);
+		stats.budgetBytes = counters.budgetBytes.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void MemoryTracker::SetBudget(EMemoryTag tag, size_t bytes)
+	{
+		TagCounters& counters = AllocationRegistry::Get().GetCounters(tag);
+		counters.budgetBytes.store(bytes, std::memory_order_relaxed);
+		counters.bOverBudget.store(false, std::memory_order_relaxed);
+	}
+
+	bool MemoryTracker::IsWithinBudget()
+	{
+		for (size_t i = 0; i < static_cast<size_t>(EMemoryTag::Count); i++)
+		{
+			MemoryTagStats stats = GetStats(static_cast<EMemoryTag>(i));
+			if (stats.budgetBytes > 0 && stats.peakBytes > stats.budgetBytes)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void MemoryTracker::Report()
+	{
+		LogInfo("Memory report:");
+		for (size_t i = 0; i < static_cast<size_t>(EMemoryTag::Count); i++)
+		{
+			EMemoryTag tag = static_cast<EMemoryTag>(i);
+			MemoryTagStats stats = GetStats(tag);
+			if (stats.totalCount == 0) continue;
+
+			LogInfo("  %-10s current %zu bytes (%zu allocs), peak %zu bytes, total %zu bytes (%zu allocs)",
+				GetTagName(tag), stats.currentBytes, stats.currentCount, stats.peakBytes, stats.totalBytes, stats.totalCount);
+
+			if (stats.budgetBytes > 0 && stats.peakBytes > stats.budgetBytes)
+			{
+				LogError("  %-10s peak is over budget (%zu / %zu bytes)", GetTagName(tag), stats.peakBytes, stats.budgetBytes);
+			}
+		}
+	}
+
+	size_t MemoryTracker::ReportLeaks()
+	{
+		size_t leakCount = 0;
+		for (size_t i = 0; i < static_cast<size_t>(EMemoryTag::Count); i++)
+		{
+			EMemoryTag tag = static_cast<EMemoryTag>(i);
+			MemoryTagStats stats = GetStats(tag);
+			if (stats.currentCount == 0) continue;
+
+			LogWarning("Leaked %zu allocations (%zu bytes) tagged %s", stats.currentCount, stats.currentBytes, GetTagName(tag));
+			leakCount += stats.currentCount;
+		}
+
+		static constexpr size_t MaxListedLeaks = 16;
+		size_t listedCount = 0;
+		AllocationRegistry::Get().ForEach([&listedCount](void* ptr, const AllocationRecord& record)
+			{
+				if (listedCount++ < MaxListedLeaks)
+				{
+					LogWarning("  %p %zu bytes [%s]", ptr, record.size, GetTagName(record.tag));
+				}
+			});
+
+		return leakCount;
+	}
+
+	const char* MemoryTracker::GetTagName(EMemoryTag tag)
+	{
+		switch (tag)
+		{
+		case EMemoryTag::Untagged: return "Untagged";
+		case EMemoryTag::Core: return "Core";
+		case EMemoryTag::Layer: return "Layer";
+		case EMemoryTag::Input: return "Input";
+		case EMemoryTag::Asset: return "Asset";
+		case EMemoryTag::Renderer: return "Renderer";
+		case EMemoryTag::Vulkan: return "Vulkan";
+		}
+		return "Unknown";
+	}
+}
+
+#if ENABLE_MEMORY_TRACKING
+#pragma region LeakReport
+// reporting from main() would count everything the engine's statics (render queue, subsystems, pools) still hold.
+// this runs once they are gone, the application's statics go even earlier when the executable exits
+struct LeakReport
+{
+	~LeakReport()
+	{
+		FGEngine::MemoryTracker::ReportLeaks();
+	}
+};
+static LeakReport s_leakReport;
+#pragma endregion
+
+#pragma region Global Operators
+static void* TrackedNew(size_t size, size_t alignment)
+{
+	void* ptr = FGEngine::MemoryTracker::Allocate(size, alignment);
+	if (!ptr) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new(size_t size) { return TrackedNew(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size) { return TrackedNew(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(size_t size, std::align_val_t alignment) { return TrackedNew(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return TrackedNew(size, static_cast<size_t>(alignment)); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return FGEngine::MemoryTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return FGEngine::MemoryTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return FGEngine::MemoryTracker::Allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return FGEngine::MemoryTracker::Allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { FGEngine::FreeInternal(ptr, false); }
+void operator delete[](void* ptr) noexcept { FGEngine::FreeInternal(ptr, false); }
+void operator delete(void* ptr, size_t) noexcept { FGEngine::FreeInternal(ptr, false); }
+void operator delete[](void* ptr, size_t) noexcept { FGEngine::FreeInternal(ptr, false); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { FGEngine::FreeInternal(ptr, false); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { FGEngine::FreeInternal(ptr, false); }
+
+void operator delete(void* ptr, std::align_val_t alignment) noexcept { FGEngine::FreeInternal(ptr, FGEngine::NeedsAlignedAllocation(static_cast<size_t>(alignment))); }
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept { FGEngine::FreeInternal(ptr, FGEngine::NeedsAlignedAllocation(static_cast<size_t>(alignment))); }
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept { FGEngine::FreeInternal(ptr, FGEngine::NeedsAlignedAllocation(static_cast<size_t>(alignment))); }
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept { FGEngine::FreeInternal(ptr, FGEngine::NeedsAlignedAllocation(static_cast<size_t>(alignment))); }
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { FGEngine::FreeInternal(ptr, FGEngine::NeedsAlignedAllocation(static_cast<size_t>(alignment))); }
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { FGEngine::FreeInternal(ptr, FGEngine::NeedsAlignedAllocation(static_cast<size_t>(alignment))); }
+#pragma endregion
+#endif // ENABLE_MEMORY_TRACKING
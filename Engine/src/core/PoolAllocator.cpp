@@ -0,0 +1,279 @@
+#include "pch.h"
+#include "core/PoolAllocator.h"
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <mutex>
+
+namespace FGEngine
+{
+#pragma region Helper
+static constexpr uint32_t ThreadCacheCapacity = 32;
+static constexpr uint32_t MaxThreadCachedResources = 4;
+
+static size_t GetSizeClassIndex(size_t bytes, size_t alignment)
+{
+	// blocks are aligned to their own size, so an over-aligned request just needs a bigger class
+	size_t size = std::max({ bytes, alignment, PoolMemoryResource::MinBlockSize });
+	if (size > PoolMemoryResource::MaxBlockSize) return PoolMemoryResource::SizeClassCount;
+
+	return std::bit_width(size - 1) - std::bit_width(PoolMemoryResource::MinBlockSize - 1);
+}
+
+// keeps track of live resources, so exiting threads only hand their cached blocks back to resources that still exist
+class ResourceRegistry
+{
+public:
+	static ResourceRegistry& Get()
+	{
+		alignas(ResourceRegistry) static unsigned char storage[sizeof(ResourceRegistry)];
+		static ResourceRegistry* instance = new (storage) ResourceRegistry();
+		return *instance;
+	}
+
+	uint64_t Register(PoolMemoryResource* resource)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		uint64_t id = nextId++;
+		liveResources.emplace_back(id, resource);
+		return id;
+	}
+
+	void Unregister(uint64_t id)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::erase_if(liveResources, [id](const auto& pair) { return pair.first == id; });
+	}
+
+	// caller must hold GetMutex()
+	bool IsAlive(uint64_t id) const
+	{
+		return std::any_of(liveResources.begin(), liveResources.end(), [id](const auto& pair) { return pair.first == id; });
+	}
+
+	std::mutex& GetMutex() { return mutex; }
+
+private:
+	std::mutex mutex;
+	std::vector<std::pair<uint64_t, PoolMemoryResource*>> liveResources;
+	uint64_t nextId = 1;
+};
+
+struct ThreadCache
+{
+	struct Entry
+	{
+		uint64_t resourceId = 0;
+		PoolMemoryResource* resource = nullptr;
+		std::array<uint32_t, PoolMemoryResource::SizeClassCount> counts{};
+		std::array<std::array<void*, ThreadCacheCapacity>, PoolMemoryResource::SizeClassCount> blocks;
+	};
+
+	~ThreadCache();
+
+	Entry* Find(PoolMemoryResource* resource, uint64_t resourceId);
+
+	std::array<Entry, MaxThreadCachedResources> entries;
+};
+
+// trivially destructible, so it can still be read while the thread's cache is being torn down
+static thread_local bool bThreadCacheDestroyed = false;
+static thread_local ThreadCache threadCache;
+
+ThreadCache::~ThreadCache()
+{
+	bThreadCacheDestroyed = true;
+
+	ResourceRegistry& registry = ResourceRegistry::Get();
+	std::lock_guard<std::mutex> lock(registry.GetMutex());
+	for (Entry& entry : entries)
+	{
+		if (entry.resourceId == 0 || !registry.IsAlive(entry.resourceId)) continue;
+
+		for (size_t i = 0; i < PoolMemoryResource::SizeClassCount; i++)
+		{
+			entry.resource->ReturnBlocks(i, entry.blocks[i].data(), entry.counts[i]);
+		}
+	}
+}
+
+ThreadCache::Entry* ThreadCache::Find(PoolMemoryResource* resource, uint64_t resourceId)
+{
+	for (Entry& entry : entries)
+	{
+		if (entry.resourceId == resourceId) return &entry;
+	}
+
+	// take an empty entry or one of a resource that has been destroyed since
+	ResourceRegistry& registry = ResourceRegistry::Get();
+	std::lock_guard<std::mutex> lock(registry.GetMutex());
+	for (Entry& entry : entries)
+	{
+		if (entry.resourceId == 0 || !registry.IsAlive(entry.resourceId))
+		{
+			entry.resourceId = resourceId;
+			entry.resource = resource;
+			entry.counts.fill(0);
+			return &entry;
+		}
+	}
+
+	return nullptr;
+}
+#pragma endregion
+
+struct PoolMemoryResource::SizeClass
+{
+	explicit SizeClass(size_t blockSize)
+		: pool(blockSize, blockSize, std::max<size_t>(4096 / blockSize, 16))
+	{
+	}
+
+	std::mutex mutex;
+	FixedSizePool pool;
+};
+
+PoolMemoryResource::PoolMemoryResource(std::pmr::memory_resource* inUpstream)
+	: upstream(inUpstream)
+{
+	sizeClasses = static_cast<SizeClass*>(::operator new(sizeof(SizeClass) * SizeClassCount, std::align_val_t(alignof(SizeClass))));
+	for (size_t i = 0; i < SizeClassCount; i++)
+	{
+		new (&sizeClasses[i]) SizeClass(MinBlockSize << i);
+	}
+
+	id = ResourceRegistry::Get().Register(this);
+}
+
+PoolMemoryResource::~PoolMemoryResource()
+{
+	FlushThreadCache();
+	ResourceRegistry::Get().Unregister(id);
+
+	for (size_t i = 0; i < SizeClassCount; i++)
+	{
+		Ensure(sizeClasses[i].pool.GetAllocatedCount() == 0, "Pool memory resource destroyed with %zu live blocks of %zu bytes",
+			sizeClasses[i].pool.GetAllocatedCount(), sizeClasses[i].pool.GetBlockSize());
+		sizeClasses[i].~SizeClass();
+	}
+	::operator delete(sizeClasses, std::align_val_t(alignof(SizeClass)));
+}
+
+void PoolMemoryResource::FlushThreadCache()
+{
+	if (bThreadCacheDestroyed) return;
+
+	for (ThreadCache::Entry& entry : threadCache.entries)
+	{
+		if (entry.resourceId != id) continue;
+
+		for (size_t i = 0; i < SizeClassCount; i++)
+		{
+			ReturnBlocks(i, entry.blocks[i].data(), entry.counts[i]);
+			entry.counts[i] = 0;
+		}
+		entry.resourceId = 0;
+		entry.resource = nullptr;
+	}
+}
+
+PoolMemoryResource& PoolMemoryResource::GetDefault()
+{
+	alignas(PoolMemoryResource) static unsigned char storage[sizeof(PoolMemoryResource)];
+	static PoolMemoryResource* instance = new (storage) PoolMemoryResource();
+	return *instance;
+}
+
+void* PoolMemoryResource::do_allocate(size_t bytes, size_t alignment)
+{
+	size_t sizeClassIndex = GetSizeClassIndex(bytes, alignment);
+	if (sizeClassIndex >= SizeClassCount)
+	{
+		return upstream->allocate(bytes, alignment);
+	}
+
+	if (!bThreadCacheDestroyed)
+	{
+		if (ThreadCache::Entry* entry = threadCache.Find(this, id))
+		{
+			uint32_t& count = entry->counts[sizeClassIndex];
+			if (count == 0)
+			{
+				RefillCache(sizeClassIndex, entry->blocks[sizeClassIndex].data(), count);
+			}
+			return entry->blocks[sizeClassIndex][--count];
+		}
+	}
+
+	return AllocateFromSizeClass(sizeClassIndex);
+}
+
+void PoolMemoryResource::do_deallocate(void* ptr, size_t bytes, size_t alignment)
+{
+	size_t sizeClassIndex = GetSizeClassIndex(bytes, alignment);
+	if (sizeClassIndex >= SizeClassCount)
+	{
+		upstream->deallocate(ptr, bytes, alignment);
+		return;
+	}
+
+	if (!bThreadCacheDestroyed)
+	{
+		if (ThreadCache::Entry* entry = threadCache.Find(this, id))
+		{
+			uint32_t& count = entry->counts[sizeClassIndex];
+			if (count == ThreadCacheCapacity)
+			{
+				// keep the other half around for the next allocations of this thread
+				ReturnBlocks(sizeClassIndex, entry->blocks[sizeClassIndex].data() + ThreadCacheCapacity / 2, ThreadCacheCapacity / 2);
+				count = ThreadCacheCapacity / 2;
+			}
+			entry->blocks[sizeClassIndex][count++] = ptr;
+			return;
+		}
+	}
+
+	DeallocateToSizeClass(sizeClassIndex, ptr);
+}
+
+bool PoolMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+void* PoolMemoryResource::AllocateFromSizeClass(size_t sizeClassIndex)
+{
+	SizeClass& sizeClass = sizeClasses[sizeClassIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.mutex);
+	return sizeClass.pool.Allocate();
+}
+
+void PoolMemoryResource::DeallocateToSizeClass(size_t sizeClassIndex, void* ptr)
+{
+	SizeClass& sizeClass = sizeClasses[sizeClassIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.mutex);
+	sizeClass.pool.Deallocate(ptr);
+}
+
+void PoolMemoryResource::RefillCache(size_t sizeClassIndex, void** blocks, uint32_t& count)
+{
+	SizeClass& sizeClass = sizeClasses[sizeClassIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.mutex);
+	while (count < ThreadCacheCapacity / 2)
+	{
+		blocks[count++] = sizeClass.pool.Allocate();
+	}
+}
+
+void PoolMemoryResource::ReturnBlocks(size_t sizeClassIndex, void** blocks, uint32_t count)
+{
+	SizeClass& sizeClass = sizeClasses[sizeClassIndex];
+	std::lock_guard<std::mutex> lock(sizeClass.mutex);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		sizeClass.pool.Deallocate(blocks[i]);
+	}
+}
+}
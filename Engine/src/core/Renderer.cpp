@@ -3,13 +3,16 @@
 #include "renderer/RendererAPI.h"
 
 #include "core/Logger.h"
+#include "core/MemoryTracker.h"
 
 namespace FGEngine
 {
 	std::unique_ptr<IRendererAPI> Renderer::s_api;
+	RenderQueue Renderer::s_renderQueue;
 
 	void Renderer::Init(const RendererProperties& rendererProperties)
 	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
 		s_api = std::unique_ptr<IRendererAPI>(IRendererAPI::Create(rendererProperties));
 		if (s_api.get())
 		{
@@ -35,10 +38,63 @@ namespace FGEngine
 
 	void Renderer::Render(void* nativeWindow)
 	{
-		s_api->Render(nativeWindow);
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
+		s_api->Render(nativeWindow, s_renderQueue);
+		s_renderQueue.Clear();
 	}
 	void Renderer::Resize()
 	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
 		s_api->Resize();
 	}
+
+	bool Renderer::ReadLastFrame(FrameReadback& outFrame)
+	{
+		return s_api && s_api->ReadLastFrame(outFrame);
+	}
+
+	bool Renderer::GetGpuFrameStats(GpuFrameStats& outStats)
+	{
+		return s_api && s_api->GetGpuFrameStats(outStats);
+	}
+
+	Handle<Texture> Renderer::CreateTexture(const Texture& texture)
+	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
+		return s_api->CreateTexture(texture);
+	}
+
+	// layers may release their resources after the renderer has shut down, the API already freed everything by then
+	void Renderer::DestroyTexture(Handle<Texture> texture)
+	{
+		if (s_api) s_api->DestroyTexture(texture);
+	}
+
+	Handle<Mesh> Renderer::CreateMesh(const Mesh& mesh)
+	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
+		return s_api->CreateMesh(mesh);
+	}
+
+	void Renderer::DestroyMesh(Handle<Mesh> mesh)
+	{
+		if (s_api) s_api->DestroyMesh(mesh);
+	}
+
+	Handle<Material> Renderer::CreateMaterial(const Material& material)
+	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
+		return s_api->CreateMaterial(material);
+	}
+
+	void Renderer::DestroyMaterial(Handle<Material> material)
+	{
+		if (s_api) s_api->DestroyMaterial(material);
+	}
+
+	void Renderer::Submit(Handle<Mesh> mesh, Handle<Material> material, const glm::mat4& transform, const glm::vec4& color)
+	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Renderer);
+		s_renderQueue.Submit(mesh, material, transform, color);
+	}
 }
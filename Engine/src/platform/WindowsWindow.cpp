@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "platform/WindowsWindow.h"
 #include "core/Logger.h"
+#include "core/PoolAllocator.h"
 #include "event/MouseEvent.h"
 #include "event/KeyboardEvent.h"
 #include "renderer/Renderer.h"
@@ -65,32 +66,32 @@ void WindowsWindow::Init(const WindowProperties& windowProperties)
 			auto* data = (WindowData*)glfwGetWindowUserPointer(glWindow);
 			data->width = width;
 			data->height = height;
-			data->windowDelegate.Broadcast(std::make_shared<WindowResizeEvent>(width, height));
+			data->windowDelegate.Broadcast(MakePooledShared<WindowResizeEvent>(width, height));
 		});
 
 	glfwSetWindowCloseCallback(nativeWindow, [](GLFWwindow* window)
 		{
 			auto* data = (WindowData*)glfwGetWindowUserPointer(window);
-			data->windowDelegate.Broadcast(std::make_shared<WindowClosedEvent>());
+			data->windowDelegate.Broadcast(MakePooledShared<WindowClosedEvent>());
 		});
 
 	glfwSetWindowFocusCallback(nativeWindow, [](GLFWwindow* glWindow, int focused)
 		{
 			auto* data = (WindowData*)glfwGetWindowUserPointer(glWindow);
-			data->windowDelegate.Broadcast(std::make_shared<WindowFocusChangedEvent>(focused));
+			data->windowDelegate.Broadcast(MakePooledShared<WindowFocusChangedEvent>(focused));
 		});
 
 
 	glfwSetCursorPosCallback(nativeWindow, [](GLFWwindow* glWindow, double xpos, double ypos)
 		{
 			auto* data = (WindowData*)glfwGetWindowUserPointer(glWindow);
-			data->windowDelegate.Broadcast(std::make_shared<CursorPositionEvent>(xpos, ypos));
+			data->windowDelegate.Broadcast(MakePooledShared<CursorPositionEvent>(xpos, ypos));
 		});
 
 	glfwSetCursorEnterCallback(nativeWindow, [](GLFWwindow* glWindow, int entered)
 		{
 			auto* data = (WindowData*)glfwGetWindowUserPointer(glWindow);
-			data->windowDelegate.Broadcast(std::make_shared<CursorEnterChangedEvent>(entered));
+			data->windowDelegate.Broadcast(MakePooledShared<CursorEnterChangedEvent>(entered));
 		});
 
 	glfwSetMouseButtonCallback(nativeWindow, [](GLFWwindow* glWindow, int button, int action, int mods)
@@ -99,10 +100,10 @@ void WindowsWindow::Init(const WindowProperties& windowProperties)
 			switch (action)
 			{
 			case GLFW_PRESS:
-				data->windowDelegate.Broadcast(std::make_shared<MousePressedEvent>(button, mods));
+				data->windowDelegate.Broadcast(MakePooledShared<MousePressedEvent>(button, mods));
 				break;
 			case GLFW_RELEASE:
-				data->windowDelegate.Broadcast(std::make_shared<MouseReleasedEvent>(button, mods));
+				data->windowDelegate.Broadcast(MakePooledShared<MouseReleasedEvent>(button, mods));
 				break;
 			}
 		});
@@ -110,7 +111,7 @@ void WindowsWindow::Init(const WindowProperties& windowProperties)
 	glfwSetScrollCallback(nativeWindow, [](GLFWwindow* glWindow, double xoffset, double yoffset)
 		{
 			auto* data = (WindowData*)glfwGetWindowUserPointer(glWindow);
-			data->windowDelegate.Broadcast(std::make_shared<MouseScrolledEvent>(xoffset, yoffset));
+			data->windowDelegate.Broadcast(MakePooledShared<MouseScrolledEvent>(xoffset, yoffset));
 		});
 
 	glfwSetKeyCallback(nativeWindow, [](GLFWwindow* glWindow, int key, int scancode, int action, int mods)
@@ -119,13 +120,13 @@ void WindowsWindow::Init(const WindowProperties& windowProperties)
 			switch (action)
 			{
 			case GLFW_PRESS:
-				data->windowDelegate.Broadcast(std::make_shared<KeyPressedEvent>(key, mods));
+				data->windowDelegate.Broadcast(MakePooledShared<KeyPressedEvent>(key, mods));
 				break;
 			case GLFW_RELEASE:
-				data->windowDelegate.Broadcast(std::make_shared<KeyReleasedEvent>(key, mods));
+				data->windowDelegate.Broadcast(MakePooledShared<KeyReleasedEvent>(key, mods));
 				break;
 			case GLFW_REPEAT:
-				data->windowDelegate.Broadcast(std::make_shared<KeyRepeatedEvent>(key, mods));
+				data->windowDelegate.Broadcast(MakePooledShared<KeyRepeatedEvent>(key, mods));
 				break;
 			}
 		});
@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "platform/openGL/OpenGLRendererAPI.h"
+#include "renderer/RenderQueue.h"
+
+#include "core/Logger.h"
 
 #include "GLFW/glfw3.h"
 
@@ -30,12 +33,48 @@ namespace FGEngine
 		return glGetString(GL_VERSION) != nullptr; // NOTE: this may not work, as it is not verified!
 	}
 
-	void OpenGLRendererAPI::Render(void* nativeWindow)
+	void OpenGLRendererAPI::Render(void* nativeWindow, RenderQueue& renderQueue)
 	{
+		// the OpenGL path only clears and swaps, submissions would silently vanish
+		Ensure(renderQueue.IsEmpty(), "OpenGL renderer dropped %zu submissions, it does not draw yet", renderQueue.Size());
 		glfwSwapBuffers((GLFWwindow*)nativeWindow);
 	}
 
 	void OpenGLRendererAPI::Resize()
 	{
 	}
+
+	// the OpenGL renderer has no GPU resources, nothing can be created and only invalid handles destroyed
+	Handle<Texture> OpenGLRendererAPI::CreateTexture(const Texture& texture)
+	{
+		NoEntry("OpenGL renderer does not support textures");
+		return Handle<Texture>();
+	}
+
+	void OpenGLRendererAPI::DestroyTexture(Handle<Texture> texture)
+	{
+		Ensure(!texture.IsValid(), "OpenGL renderer asked to destroy texture %u it never created", texture.GetValue());
+	}
+
+	Handle<Mesh> OpenGLRendererAPI::CreateMesh(const Mesh& mesh)
+	{
+		NoEntry("OpenGL renderer does not support meshes");
+		return Handle<Mesh>();
+	}
+
+	void OpenGLRendererAPI::DestroyMesh(Handle<Mesh> mesh)
+	{
+		Ensure(!mesh.IsValid(), "OpenGL renderer asked to destroy mesh %u it never created", mesh.GetValue());
+	}
+
+	Handle<Material> OpenGLRendererAPI::CreateMaterial(const Material& material)
+	{
+		NoEntry("OpenGL renderer does not support materials");
+		return Handle<Material>();
+	}
+
+	void OpenGLRendererAPI::DestroyMaterial(Handle<Material> material)
+	{
+		Ensure(!material.IsValid(), "OpenGL renderer asked to destroy material %u it never created", material.GetValue());
+	}
 }
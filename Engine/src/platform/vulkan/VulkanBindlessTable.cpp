@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanBindlessTable.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+#include <algorithm>
+
+namespace FGEngine
+{
+	VulkanBindlessTable::VulkanBindlessTable(VkPhysicalDevice physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t maxTextures)
+	{
+		logicalDevice = inLogicalDevice;
+		Check(logicalDevice->IsBindlessEnabled(), "Bindless table created on a device without descriptor indexing");
+
+		// update after bind descriptors have their own, usually much higher, limits
+		VkPhysicalDeviceVulkan12Properties properties12{};
+		properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &properties12;
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+		// a combined image sampler counts against the sampled image and the sampler limits
+		textureSlots.capacity = std::min({ maxTextures,
+			properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+			properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+			properties12.maxDescriptorSetUpdateAfterBindSamplers });
+
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = textureSlots.capacity;
+		binding.stageFlags = StageFlags;
+
+		const VkDescriptorBindingFlags bindingFlags =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo{};
+		bindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsCreateInfo.bindingCount = 1;
+		bindingFlagsCreateInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.pNext = &bindingFlagsCreateInfo;
+		layoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutCreateInfo.bindingCount = 1;
+		layoutCreateInfo.pBindings = &binding;
+
+		VkResult result = vkCreateDescriptorSetLayout(*logicalDevice, &layoutCreateInfo, VulkanUtil::GetAllocationCallbacks(), &setLayout);
+		Check(result == VK_SUCCESS, "Failed to create bindless descriptor set layout. Vulkan error: %d", result);
+
+		VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureSlots.capacity };
+
+		VkDescriptorPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolCreateInfo.poolSizeCount = 1;
+		poolCreateInfo.pPoolSizes = &poolSize;
+		poolCreateInfo.maxSets = 1;
+
+		result = vkCreateDescriptorPool(*logicalDevice, &poolCreateInfo, VulkanUtil::GetAllocationCallbacks(), &descriptorPool);
+		Check(result == VK_SUCCESS, "Failed to create bindless descriptor pool. Vulkan error: %d", result);
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = descriptorPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &setLayout;
+
+		result = vkAllocateDescriptorSets(*logicalDevice, &allocateInfo, &descriptorSet);
+		Check(result == VK_SUCCESS, "Failed to allocate bindless descriptor set. Vulkan error: %d", result);
+
+		LogInfo("Bindless table with %u texture slots", textureSlots.capacity);
+	}
+
+	VulkanBindlessTable::~VulkanBindlessTable()
+	{
+		// frees the set along with the pool
+		vkDestroyDescriptorPool(*logicalDevice, descriptorPool, VulkanUtil::GetAllocationCallbacks());
+		vkDestroyDescriptorSetLayout(*logicalDevice, setLayout, VulkanUtil::GetAllocationCallbacks());
+	}
+
+	uint32_t VulkanBindlessTable::RegisterTexture(VkImageView imageView, VkSampler sampler)
+	{
+		uint32_t index = AllocateSlot(textureSlots, "texture");
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = sampler;
+
+		VkWriteDescriptorSet writeDescriptorSet{};
+		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writeDescriptorSet.dstSet = descriptorSet;
+		writeDescriptorSet.dstBinding = 0;
+		writeDescriptorSet.dstArrayElement = index;
+		writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writeDescriptorSet.descriptorCount = 1;
+		writeDescriptorSet.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(*logicalDevice, 1, &writeDescriptorSet, 0, nullptr);
+		return index;
+	}
+
+	void VulkanBindlessTable::ReleaseTexture(uint32_t index)
+	{
+		ReleaseSlot(textureSlots, index);
+	}
+
+	uint32_t VulkanBindlessTable::AllocateSlot(SlotList& slots, const char* kind)
+	{
+		if (!slots.freeIndices.empty())
+		{
+			uint32_t index = slots.freeIndices.back();
+			slots.freeIndices.pop_back();
+			return index;
+		}
+
+		Check(slots.nextIndex < slots.capacity, "Bindless table is out of %s slots (%u)", kind, slots.capacity);
+		return slots.nextIndex++;
+	}
+
+	void VulkanBindlessTable::ReleaseSlot(SlotList& slots, uint32_t index)
+	{
+		// the slot stays readable by the frames in flight, the table outlives the queue's last collect
+		logicalDevice->GetDeletionQueue().Retire(
+			[&slots, index]()
+			{
+				slots.freeIndices.push_back(index);
+			});
+	}
+}
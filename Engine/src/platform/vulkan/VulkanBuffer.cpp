@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "platform/vulkan/VulkanBuffer.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanUtil.h"
 
 namespace FGEngine
 {
@@ -10,15 +12,78 @@ namespace FGEngine
 
 	VulkanBuffer::~VulkanBuffer()
 	{
-		vkDestroyBuffer(*logicalDevice, buffer, nullptr);
-		vkFreeMemory(*logicalDevice, bufferMemory, nullptr);
+		if (!logicalDevice) return;
+
+		Retire();
+	}
+
+	VulkanBuffer::VulkanBuffer(VulkanBuffer&& other) noexcept :
+		logicalDevice(std::move(other.logicalDevice)),
+		buffer(std::exchange(other.buffer, VK_NULL_HANDLE)),
+		allocation(std::exchange(other.allocation, VulkanAllocation())),
+		size(std::exchange(other.size, 0)),
+		usage(std::exchange(other.usage, 0))
+	{
+	}
+
+	VulkanBuffer& VulkanBuffer::operator=(VulkanBuffer&& other) noexcept
+	{
+		if (this != &other)
+		{
+			std::swap(logicalDevice, other.logicalDevice);
+			std::swap(buffer, other.buffer);
+			std::swap(allocation, other.allocation);
+			std::swap(size, other.size);
+			std::swap(usage, other.usage);
+		}
+		return *this;
+	}
+
+	bool VulkanBuffer::Demote(VulkanUploadManager& uploadManager)
+	{
+		VulkanMemoryAllocator& allocator = logicalDevice->GetAllocator();
+		if (buffer == VK_NULL_HANDLE || !allocator.IsDeviceLocal(allocation.memoryTypeIndex)) return false;
+
+		VkBuffer hostBuffer;
+		VulkanAllocation hostAllocation;
+		CreateBuffer(logicalDevice, size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, hostBuffer, hostAllocation);
+
+		// unified memory devices have no host heap to move to
+		if (allocator.IsDeviceLocal(hostAllocation.memoryTypeIndex))
+		{
+			vkDestroyBuffer(*logicalDevice, hostBuffer, VulkanUtil::GetAllocationCallbacks());
+			allocator.Free(hostAllocation);
+			return false;
+		}
+
+		uploadManager.CopyBuffer(buffer, hostBuffer, size);
+
+		Retire();
+		buffer = hostBuffer;
+		allocation = hostAllocation;
+		return true;
+	}
+
+	void VulkanBuffer::Retire()
+	{
+		if (buffer == VK_NULL_HANDLE) return;
+
+		// frames in flight may still read the buffer
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), allocator = &logicalDevice->GetAllocator(), buffer = buffer, allocation = allocation]() mutable
+			{
+				vkDestroyBuffer(device, buffer, VulkanUtil::GetAllocationCallbacks());
+				allocator->Free(allocation);
+			});
+
+		buffer = VK_NULL_HANDLE;
+		allocation = VulkanAllocation();
 	}
 
 	void VulkanBuffer::CreateBuffer(
-		const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice,
 		const std::shared_ptr<VulkanLogicalDevice>& logicalDevice,
 		VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-		VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+		VkBuffer& buffer, VulkanAllocation& allocation, bool bSharedWithCompute)
 	{
 		VkBufferCreateInfo bufferCreateInfo{};
 		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -27,22 +92,17 @@ namespace FGEngine
 		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 		bufferCreateInfo.flags = 0;
 
-		VkResult result = vkCreateBuffer(*logicalDevice, &bufferCreateInfo, nullptr, &buffer);
-		Check(result == VK_SUCCESS, "Failed to create vertex buffer. Vulkan error: %d", result);
-
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(*logicalDevice, buffer, &memoryRequirements);
+		uint32_t queueFamilyIndices[] = { logicalDevice->GetGraphicsQueueFamily(), logicalDevice->GetComputeQueueFamily() };
+		if (bSharedWithCompute && logicalDevice->HasDedicatedComputeQueue())
+		{
+			bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			bufferCreateInfo.queueFamilyIndexCount = 2;
+			bufferCreateInfo.pQueueFamilyIndices = queueFamilyIndices;
+		}
 
-		VkMemoryAllocateInfo allocateInfo{};
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = physicalDevice->FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-
-		// NOTE: shouldn't do allocation for each individual buffer, instead should create a custom allocator
-		// ref: https://vulkan-tutorial.com/Vertex_buffers/Staging_buffer#:~:text=more%20complex%20geometry.-,Conclusion,-It%20should%20be
-		result = vkAllocateMemory(*logicalDevice, &allocateInfo, nullptr, &bufferMemory);
-		Check(result == VK_SUCCESS, "Failed to allocate vertex buffer memory. Vulkan error: %d", result);
+		VkResult result = vkCreateBuffer(*logicalDevice, &bufferCreateInfo, VulkanUtil::GetAllocationCallbacks(), &buffer);
+		Check(result == VK_SUCCESS, "Failed to create vertex buffer. Vulkan error: %d", result);
 
-		vkBindBufferMemory(*logicalDevice, buffer, bufferMemory, 0);
+		allocation = logicalDevice->GetAllocator().AllocateBuffer(buffer, properties);
 	}
 }
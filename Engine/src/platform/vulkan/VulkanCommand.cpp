@@ -2,20 +2,34 @@
 #include "platform/vulkan/VulkanCommand.h"
 #include "platform/vulkan/VulkanPhysicalDevice.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanUtil.h"
 
 namespace FGEngine
 {
-	VulkanCommand::VulkanCommand(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t bufferCount)
+	VulkanCommand::VulkanCommand(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t bufferCount, uint32_t inSecondaryCount)
 	{
 		logicalDevice = inLogicalDevice;
 
 		CreateCommandPool(physicalDevice, logicalDevice);
 		CreateCommandBuffers(logicalDevice, bufferCount);
+		CreateSecondaryCommandBuffers(physicalDevice, bufferCount, inSecondaryCount);
 	}
 
 	VulkanCommand::~VulkanCommand()
 	{
-		vkDestroyCommandPool(*logicalDevice, commandPool, nullptr);
+		for (VkCommandPool secondaryCommandPool : secondaryCommandPools)
+		{
+			vkDestroyCommandPool(*logicalDevice, secondaryCommandPool, VulkanUtil::GetAllocationCallbacks());
+		}
+		vkDestroyCommandPool(*logicalDevice, commandPool, VulkanUtil::GetAllocationCallbacks());
+	}
+
+	void VulkanCommand::ResetSecondaryBuffers(uint32_t index)
+	{
+		for (uint32_t i = 0; i < secondaryCount; i++)
+		{
+			vkResetCommandPool(*logicalDevice, secondaryCommandPools[index * secondaryCount + i], 0);
+		}
 	}
 
 	void VulkanCommand::CreateCommandPool(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& logicalDevice)
@@ -27,7 +41,7 @@ namespace FGEngine
 		createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 		createInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
 
-		VkResult result = vkCreateCommandPool(*logicalDevice, &createInfo, nullptr, &commandPool);
+		VkResult result = vkCreateCommandPool(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &commandPool);
 		Check(result == VK_SUCCESS, "Failed to create command pool. Vulkan error: %d", result);
 	}
 
@@ -45,75 +59,31 @@ namespace FGEngine
 		Check(result == VK_SUCCESS, "Failed to allocate command buffers. Vulkan error: %d", result);
 	}
 
-	VkCommandBuffer VulkanCommand::BeginSingleTimeCommands()
+	void VulkanCommand::CreateSecondaryCommandBuffers(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, uint32_t bufferCount, uint32_t inSecondaryCount)
 	{
-		VkCommandBufferAllocateInfo allocateInfo{};
-		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocateInfo.commandPool = commandPool;
-		allocateInfo.commandBufferCount = 1;
-
-		VkCommandBuffer commandBuffer;
-		vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, &commandBuffer);
-
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-		vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-		return commandBuffer;
-	}
+		secondaryCount = inSecondaryCount;
+		secondaryCommandPools.resize(bufferCount * secondaryCount);
+		secondaryCommandBuffers.resize(bufferCount * secondaryCount);
 
-	void VulkanCommand::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
-	{
-		vkEndCommandBuffer(commandBuffer);
-
-		VkSubmitInfo submitInfo{};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(logicalDevice->GetGraphicsQueue());
-
-		vkFreeCommandBuffers(*logicalDevice, commandPool, 1, &commandBuffer);
-	}
-
-	void VulkanCommand::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
-	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
-		{
-			VkBufferCopy copyRegion{};
-			copyRegion.srcOffset = 0;
-			copyRegion.dstOffset = 0;
-			copyRegion.size = size;
-
-			vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-		}
-		EndSingleTimeCommands(commandBuffer);
-	}
+		// pools are reset as a whole every frame instead of resetting single buffers
+		VkCommandPoolCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		createInfo.queueFamilyIndex = physicalDevice->GetQueueFamilyIndices().graphicsFamily.value();
 
-	void VulkanCommand::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
-	{
-		VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+		for (size_t i = 0; i < secondaryCommandPools.size(); i++)
 		{
-			VkBufferImageCopy region{};
-			region.bufferOffset = 0;
-			region.bufferRowLength = 0;
-			region.bufferImageHeight = 0;
-
-			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			region.imageSubresource.mipLevel = 0;
-			region.imageSubresource.baseArrayLayer = 0;
-			region.imageSubresource.layerCount = 1;
+			VkResult result = vkCreateCommandPool(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &secondaryCommandPools[i]);
+			Check(result == VK_SUCCESS, "Failed to create secondary command pool. Vulkan error: %d", result);
 
-			region.imageOffset = { 0,0,0 };
-			region.imageExtent = { width, height, 1 };
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = secondaryCommandPools[i];
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandBufferCount = 1;
 
-			vkCmdCopyBufferToImage(commandBuffer, buffer, image,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			result = vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, &secondaryCommandBuffers[i]);
+			Check(result == VK_SUCCESS, "Failed to allocate secondary command buffer. Vulkan error: %d", result);
 		}
-		EndSingleTimeCommands(commandBuffer);
 	}
 }
@@ -0,0 +1,362 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanCullingPass.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanPipeline.h"
+#include "platform/vulkan/VulkanShaderModule.h"
+#include "platform/vulkan/VulkanBuffer.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "renderer/Shader.h"
+#include "core/Logger.h"
+
+#include <array>
+
+namespace FGEngine
+{
+	VulkanCullingPass::VulkanCullingPass(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, VkBuffer uniformBuffer, uint64_t inUniformBufferObjectSize)
+	{
+		logicalDevice = inLogicalDevice;
+		uniformBufferObjectSize = inUniformBufferObjectSize;
+		bAsyncCompute = logicalDevice->HasDedicatedComputeQueue();
+
+		CreateDescriptorSetLayout();
+		CreatePipeline();
+
+		frames.resize(frameCount);
+		instanceBuffers.resize(frameCount);
+		CreateDescriptorPool();
+
+		std::vector<VkDescriptorSetLayout> layouts(frames.size(), descriptorSetLayout);
+		std::vector<VkDescriptorSet> descriptorSets(frames.size());
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = descriptorPool;
+		allocateInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+		allocateInfo.pSetLayouts = layouts.data();
+
+		VkResult result = vkAllocateDescriptorSets(*logicalDevice, &allocateInfo, descriptorSets.data());
+		Check(result == VK_SUCCESS, "Failed to allocate culling descriptor sets. Vulkan error: %d", result);
+
+		for (uint32_t i = 0; i < frames.size(); i++)
+		{
+			frames[i].uniformBuffer = uniformBuffer;
+			frames[i].descriptorSet = descriptorSets[i];
+
+			CreateObjectBuffers(i, InitialObjectCapacity);
+			CreateDrawBuffer(i, InitialDrawCapacity);
+			WriteDescriptorSet(i);
+		}
+
+		if (bAsyncCompute)
+		{
+			CreateComputeCommands();
+		}
+	}
+
+	VulkanCullingPass::~VulkanCullingPass()
+	{
+		for (uint32_t i = 0; i < frames.size(); i++)
+		{
+			RetireBuffer(frames[i].objectBuffer.buffer, frames[i].objectBuffer.allocation);
+			RetireBuffer(frames[i].drawBuffer.buffer, frames[i].drawBuffer.allocation);
+			RetireBuffer(instanceBuffers[i], frames[i].instanceAllocation);
+		}
+
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), descriptorPool = descriptorPool, descriptorSetLayout = descriptorSetLayout, commandPool = commandPool, timelineSemaphore = timelineSemaphore]()
+			{
+				vkDestroyDescriptorPool(device, descriptorPool, VulkanUtil::GetAllocationCallbacks());
+				vkDestroyDescriptorSetLayout(device, descriptorSetLayout, VulkanUtil::GetAllocationCallbacks());
+				if (commandPool != VK_NULL_HANDLE)
+				{
+					vkDestroyCommandPool(device, commandPool, VulkanUtil::GetAllocationCallbacks());
+					vkDestroySemaphore(device, timelineSemaphore, VulkanUtil::GetAllocationCallbacks());
+				}
+			});
+	}
+
+	bool VulkanCullingPass::Reserve(uint32_t frame, uint32_t objectCount, uint32_t drawCount)
+	{
+		Frame& frameData = frames[frame];
+
+		bool bObjectsGrown = false;
+		if (objectCount > frameData.objectCapacity)
+		{
+			uint32_t capacity = frameData.objectCapacity;
+			while (capacity < objectCount) capacity *= 2;
+
+			RetireBuffer(frameData.objectBuffer.buffer, frameData.objectBuffer.allocation);
+			RetireBuffer(instanceBuffers[frame], frameData.instanceAllocation);
+			CreateObjectBuffers(frame, capacity);
+			bObjectsGrown = true;
+		}
+
+		bool bDrawsGrown = false;
+		if (drawCount > frameData.drawCapacity)
+		{
+			uint32_t capacity = frameData.drawCapacity;
+			while (capacity < drawCount) capacity *= 2;
+
+			RetireBuffer(frameData.drawBuffer.buffer, frameData.drawBuffer.allocation);
+			CreateDrawBuffer(frame, capacity);
+			bDrawsGrown = true;
+		}
+
+		if (bObjectsGrown || bDrawsGrown)
+		{
+			WriteDescriptorSet(frame);
+		}
+		return bObjectsGrown;
+	}
+
+	void VulkanCullingPass::SetUniformBuffer(uint32_t frame, VkBuffer uniformBuffer)
+	{
+		if (frames[frame].uniformBuffer == uniformBuffer) return;
+
+		frames[frame].uniformBuffer = uniformBuffer;
+		WriteDescriptorSet(frame);
+	}
+
+	VulkanCullObject* VulkanCullingPass::GetObjects(uint32_t frame) const
+	{
+		return static_cast<VulkanCullObject*>(frames[frame].objectBuffer.allocation.mappedData);
+	}
+
+	VkDrawIndexedIndirectCommand* VulkanCullingPass::GetDraws(uint32_t frame) const
+	{
+		return static_cast<VkDrawIndexedIndirectCommand*>(frames[frame].drawBuffer.allocation.mappedData);
+	}
+
+	void VulkanCullingPass::Dispatch(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t objectCount, uint32_t uniformOffset)
+	{
+		Check(!bAsyncCompute, "Culling runs on the async compute queue, use Submit()");
+		if (objectCount == 0) return;
+
+		// the render graph places the barrier up to the indirect draws
+		RecordCulling(commandBuffer, frame, objectCount, uniformOffset);
+	}
+
+	uint64_t VulkanCullingPass::Submit(uint32_t frame, uint32_t objectCount, uint32_t uniformOffset)
+	{
+		Check(bAsyncCompute, "No async compute queue, use Dispatch()");
+		if (objectCount == 0) return 0;
+
+		// the graphics submission that waited for the last use of this buffer has completed
+		VkCommandBuffer commandBuffer = frames[frame].commandBuffer;
+		vkResetCommandBuffer(commandBuffer, 0);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		Check(result == VK_SUCCESS, "Failed to begin recording culling command buffer. Vulkan error: %d", result);
+
+		// the semaphore makes the results visible to the graphics queue, no barrier needed
+		RecordCulling(commandBuffer, frame, objectCount, uniformOffset);
+
+		result = vkEndCommandBuffer(commandBuffer);
+		Check(result == VK_SUCCESS, "Failed to record culling command buffer. Vulkan error: %d", result);
+
+		timelineValue++;
+
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.signalSemaphoreValueCount = 1;
+		timelineSubmitInfo.pSignalSemaphoreValues = &timelineValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineSubmitInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+		result = vkQueueSubmit(logicalDevice->GetComputeQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+		Check(result == VK_SUCCESS, "Failed to submit culling command buffer. Vulkan error: %d", result);
+
+		return timelineValue;
+	}
+
+	void VulkanCullingPass::RecordCulling(VkCommandBuffer commandBuffer, uint32_t frame, uint32_t objectCount, uint32_t uniformOffset)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, *pipeline);
+		vkCmdBindDescriptorSets(commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetLayout(), 0,
+			1, &frames[frame].descriptorSet,
+			1, &uniformOffset);
+		vkCmdPushConstants(commandBuffer, pipeline->GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &objectCount);
+		vkCmdDispatch(commandBuffer, (objectCount + WorkgroupSize - 1) / WorkgroupSize, 1, 1);
+	}
+
+	void VulkanCullingPass::CreateDescriptorSetLayout()
+	{
+		std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+		for (uint32_t i = 0; i < bindings.size(); i++)
+		{
+			bindings[i].binding = i;
+			bindings[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindings[i].descriptorCount = 1;
+			bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+			bindings[i].pImmutableSamplers = nullptr;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutCreateInfo.pBindings = bindings.data();
+
+		VkResult result = vkCreateDescriptorSetLayout(*logicalDevice, &layoutCreateInfo, VulkanUtil::GetAllocationCallbacks(), &descriptorSetLayout);
+		Check(result == VK_SUCCESS, "Failed to create culling descriptor set layout. Vulkan error: %d", result);
+	}
+
+	void VulkanCullingPass::CreateDescriptorPool()
+	{
+		uint32_t frameCount = static_cast<uint32_t>(frames.size());
+
+		std::array<VkDescriptorPoolSize, 2> poolSizes{};
+		poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		poolSizes[0].descriptorCount = frameCount;
+		poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		poolSizes[1].descriptorCount = frameCount * 3;
+
+		VkDescriptorPoolCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		createInfo.pPoolSizes = poolSizes.data();
+		createInfo.maxSets = frameCount;
+
+		VkResult result = vkCreateDescriptorPool(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &descriptorPool);
+		Check(result == VK_SUCCESS, "Failed to create culling descriptor pool. Vulkan error: %d", result);
+	}
+
+	void VulkanCullingPass::CreatePipeline()
+	{
+		Shader computeShader("shader/CullInstancesComp.spv", Shader::EType::Compute);
+		VulkanShaderModule shaderModule(logicalDevice, computeShader);
+
+		// the object count
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(uint32_t);
+
+		pipeline = std::make_unique<VulkanComputePipeline>(logicalDevice, shaderModule, std::vector<VkDescriptorSetLayout>{ descriptorSetLayout }, std::vector<VkPushConstantRange>{ pushConstantRange });
+	}
+
+	void VulkanCullingPass::CreateComputeCommands()
+	{
+		VkCommandPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolCreateInfo.queueFamilyIndex = logicalDevice->GetComputeQueueFamily();
+
+		VkResult result = vkCreateCommandPool(*logicalDevice, &poolCreateInfo, VulkanUtil::GetAllocationCallbacks(), &commandPool);
+		Check(result == VK_SUCCESS, "Failed to create culling command pool. Vulkan error: %d", result);
+
+		std::vector<VkCommandBuffer> commandBuffers(frames.size());
+
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		result = vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, commandBuffers.data());
+		Check(result == VK_SUCCESS, "Failed to allocate culling command buffers. Vulkan error: %d", result);
+
+		for (uint32_t i = 0; i < frames.size(); i++)
+		{
+			frames[i].commandBuffer = commandBuffers[i];
+		}
+
+		VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+		semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		semaphoreTypeCreateInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreCreateInfo{};
+		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+		result = vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, VulkanUtil::GetAllocationCallbacks(), &timelineSemaphore);
+		Check(result == VK_SUCCESS, "Failed to create culling timeline semaphore. Vulkan error: %d", result);
+
+		LogInfo("Culling runs on the async compute queue");
+	}
+
+	void VulkanCullingPass::CreateObjectBuffers(uint32_t frame, uint32_t capacity)
+	{
+		Frame& frameData = frames[frame];
+		frameData.objectCapacity = capacity;
+
+		VulkanBuffer::CreateBuffer(
+			logicalDevice,
+			sizeof(VulkanCullObject) * capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frameData.objectBuffer.buffer, frameData.objectBuffer.allocation, true);
+
+		// only written and read by the GPU, every object can be visible
+		VulkanBuffer::CreateBuffer(
+			logicalDevice,
+			sizeof(VulkanInstanceData) * capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			instanceBuffers[frame], frameData.instanceAllocation, true);
+	}
+
+	void VulkanCullingPass::CreateDrawBuffer(uint32_t frame, uint32_t capacity)
+	{
+		Frame& frameData = frames[frame];
+		frameData.drawCapacity = capacity;
+
+		VulkanBuffer::CreateBuffer(
+			logicalDevice,
+			sizeof(VkDrawIndexedIndirectCommand) * capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			frameData.drawBuffer.buffer, frameData.drawBuffer.allocation, true);
+	}
+
+	void VulkanCullingPass::WriteDescriptorSet(uint32_t frame)
+	{
+		const Frame& frameData = frames[frame];
+
+		std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+		bufferInfos[0] = { frameData.uniformBuffer, 0, uniformBufferObjectSize };
+		bufferInfos[1] = { frameData.objectBuffer.buffer, 0, VK_WHOLE_SIZE };
+		bufferInfos[2] = { frameData.drawBuffer.buffer, 0, VK_WHOLE_SIZE };
+		bufferInfos[3] = { instanceBuffers[frame], 0, VK_WHOLE_SIZE };
+
+		std::array<VkWriteDescriptorSet, 4> writeDescriptorSets{};
+		for (uint32_t i = 0; i < writeDescriptorSets.size(); i++)
+		{
+			writeDescriptorSets[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writeDescriptorSets[i].dstSet = frameData.descriptorSet;
+			writeDescriptorSets[i].dstBinding = i;
+			writeDescriptorSets[i].dstArrayElement = 0;
+			writeDescriptorSets[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writeDescriptorSets[i].descriptorCount = 1;
+			writeDescriptorSets[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		vkUpdateDescriptorSets(*logicalDevice,
+			static_cast<uint32_t>(writeDescriptorSets.size()),
+			writeDescriptorSets.data(),
+			0, nullptr);
+	}
+
+	void VulkanCullingPass::RetireBuffer(VkBuffer buffer, const VulkanAllocation& allocation)
+	{
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), allocator = &logicalDevice->GetAllocator(), buffer = buffer, allocation = allocation]() mutable
+			{
+				vkDestroyBuffer(device, buffer, VulkanUtil::GetAllocationCallbacks());
+				allocator->Free(allocation);
+			});
+	}
+}
@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+
+#include "core/Logger.h"
+
+namespace FGEngine
+{
+	VulkanDeletionQueue::~VulkanDeletionQueue()
+	{
+		Ensure(entries.empty(), "Deletion queue destroyed with %zu pending resources", entries.size());
+	}
+
+	void VulkanDeletionQueue::Retire(std::function<void()>&& deleter)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		entries.push_back({ currentFrame, std::move(deleter) });
+	}
+
+	uint64_t VulkanDeletionQueue::EndFrame()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return currentFrame++;
+	}
+
+	void VulkanDeletionQueue::Collect(uint64_t completedFrame)
+	{
+		std::vector<std::function<void()>> deleters;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			while (!entries.empty() && entries.front().frame <= completedFrame)
+			{
+				deleters.push_back(std::move(entries.front().deleter));
+				entries.pop_front();
+			}
+		}
+
+		// outside the lock, a deleter may release something that retires more resources
+		for (std::function<void()>& deleter : deleters)
+		{
+			deleter();
+		}
+	}
+
+	void VulkanDeletionQueue::Flush()
+	{
+		while (GetPendingCount() > 0)
+		{
+			Collect(UINT64_MAX);
+		}
+	}
+
+	uint64_t VulkanDeletionQueue::GetCurrentFrame() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return currentFrame;
+	}
+
+	size_t VulkanDeletionQueue::GetPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size();
+	}
+}
@@ -0,0 +1,159 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanDescriptorAllocator.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <array>
+
+namespace FGEngine
+{
+	VulkanDescriptorAllocator::VulkanDescriptorAllocator(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, uint32_t initialSetsPerPool)
+	{
+		logicalDevice = inLogicalDevice;
+		frames.resize(frameCount);
+		setsPerPool = initialSetsPerPool;
+	}
+
+	VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+	{
+		for (Frame& frame : frames)
+		{
+			for (VkDescriptorPool pool : frame.usedPools)
+			{
+				vkDestroyDescriptorPool(*logicalDevice, pool, VulkanUtil::GetAllocationCallbacks());
+			}
+			for (VkDescriptorPool pool : frame.freePools)
+			{
+				vkDestroyDescriptorPool(*logicalDevice, pool, VulkanUtil::GetAllocationCallbacks());
+			}
+		}
+	}
+
+	VkDescriptorSet VulkanDescriptorAllocator::Allocate(uint32_t frame, VkDescriptorSetLayout layout)
+	{
+		Frame& frameData = frames[frame];
+		if (frameData.currentPool == VK_NULL_HANDLE)
+		{
+			frameData.currentPool = NextPool(frameData);
+		}
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = frameData.currentPool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &layout;
+
+		VkDescriptorSet descriptorSet;
+		VkResult result = vkAllocateDescriptorSets(*logicalDevice, &allocateInfo, &descriptorSet);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+		{
+			// a fresh pool always fits a single set
+			frameData.currentPool = NextPool(frameData);
+			allocateInfo.descriptorPool = frameData.currentPool;
+			result = vkAllocateDescriptorSets(*logicalDevice, &allocateInfo, &descriptorSet);
+		}
+		Check(result == VK_SUCCESS, "Failed to allocate descriptor set. Vulkan error: %d", result);
+
+		return descriptorSet;
+	}
+
+	void VulkanDescriptorAllocator::ResetFrame(uint32_t frame)
+	{
+		Frame& frameData = frames[frame];
+		for (VkDescriptorPool pool : frameData.usedPools)
+		{
+			vkResetDescriptorPool(*logicalDevice, pool, 0);
+			frameData.freePools.push_back(pool);
+		}
+		frameData.usedPools.clear();
+		frameData.currentPool = VK_NULL_HANDLE;
+	}
+
+	VkDescriptorPool VulkanDescriptorAllocator::NextPool(Frame& frame)
+	{
+		VkDescriptorPool pool;
+		if (!frame.freePools.empty())
+		{
+			pool = frame.freePools.back();
+			frame.freePools.pop_back();
+		}
+		else
+		{
+			pool = CreatePool(setsPerPool);
+			setsPerPool = std::min(setsPerPool * 2, MaxSetsPerPool);
+		}
+
+		frame.usedPools.push_back(pool);
+		return pool;
+	}
+
+	VkDescriptorPool VulkanDescriptorAllocator::CreatePool(uint32_t setCount)
+	{
+		// descriptors per set of each type, sized for the material sets with headroom for other layouts
+		std::array<VkDescriptorPoolSize, 4> poolSizes{};
+		poolSizes[0] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, setCount * 2 };
+		poolSizes[1] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, setCount * 2 };
+		poolSizes[2] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount * 4 };
+		poolSizes[3] = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, setCount * 2 };
+
+		VkDescriptorPoolCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		createInfo.flags = 0;
+		createInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		createInfo.pPoolSizes = poolSizes.data();
+		createInfo.maxSets = setCount;
+
+		VkDescriptorPool pool;
+		VkResult result = vkCreateDescriptorPool(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &pool);
+		Check(result == VK_SUCCESS, "Failed to create descriptor pool. Vulkan error: %d", result);
+
+		return pool;
+	}
+
+	VulkanDescriptorWriter& VulkanDescriptorWriter::WriteBuffer(uint32_t binding, VkDescriptorType type, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		VkDescriptorBufferInfo& bufferInfo = bufferInfos.emplace_back();
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+
+		VkWriteDescriptorSet& write = writes.emplace_back();
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstBinding = binding;
+		write.dstArrayElement = 0;
+		write.descriptorType = type;
+		write.descriptorCount = 1;
+		write.pBufferInfo = &bufferInfo;
+		return *this;
+	}
+
+	VulkanDescriptorWriter& VulkanDescriptorWriter::WriteImage(uint32_t binding, VkDescriptorType type, VkImageView imageView, VkSampler sampler, VkImageLayout imageLayout)
+	{
+		VkDescriptorImageInfo& imageInfo = imageInfos.emplace_back();
+		imageInfo.imageLayout = imageLayout;
+		imageInfo.imageView = imageView;
+		imageInfo.sampler = sampler;
+
+		VkWriteDescriptorSet& write = writes.emplace_back();
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstBinding = binding;
+		write.dstArrayElement = 0;
+		write.descriptorType = type;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfo;
+		return *this;
+	}
+
+	void VulkanDescriptorWriter::Update(VkDevice device, VkDescriptorSet descriptorSet)
+	{
+		for (VkWriteDescriptorSet& write : writes)
+		{
+			write.dstSet = descriptorSet;
+		}
+
+		vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+}
@@ -0,0 +1,84 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanDescriptorLayoutCache.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace FGEngine
+{
+	VulkanDescriptorLayoutCache::VulkanDescriptorLayoutCache(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice)
+	{
+		logicalDevice = inLogicalDevice;
+	}
+
+	VulkanDescriptorLayoutCache::~VulkanDescriptorLayoutCache()
+	{
+		for (const auto& [key, layout] : layouts)
+		{
+			vkDestroyDescriptorSetLayout(*logicalDevice, layout, VulkanUtil::GetAllocationCallbacks());
+		}
+	}
+
+	VkDescriptorSetLayout VulkanDescriptorLayoutCache::GetOrCreate(std::vector<VkDescriptorSetLayoutBinding> bindings)
+	{
+		std::sort(bindings.begin(), bindings.end(),
+			[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+			{
+				return a.binding < b.binding;
+			});
+
+		LayoutKey key{ std::move(bindings) };
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = layouts.find(key);
+		if (it != layouts.end())
+		{
+			return it->second;
+		}
+
+		for (const VkDescriptorSetLayoutBinding& binding : key.bindings)
+		{
+			Check(binding.pImmutableSamplers == nullptr, "Immutable samplers are not supported by the descriptor layout cache");
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.bindingCount = static_cast<uint32_t>(key.bindings.size());
+		layoutCreateInfo.pBindings = key.bindings.data();
+
+		VkDescriptorSetLayout layout;
+		VkResult result = vkCreateDescriptorSetLayout(*logicalDevice, &layoutCreateInfo, VulkanUtil::GetAllocationCallbacks(), &layout);
+		Check(result == VK_SUCCESS, "Failed to create descriptor set layout. Vulkan error: %d", result);
+
+		layouts.emplace(std::move(key), layout);
+		return layout;
+	}
+
+	bool VulkanDescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const
+	{
+		return std::equal(bindings.begin(), bindings.end(), other.bindings.begin(), other.bindings.end(),
+			[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+			{
+				return a.binding == b.binding
+					&& a.descriptorType == b.descriptorType
+					&& a.descriptorCount == b.descriptorCount
+					&& a.stageFlags == b.stageFlags;
+			});
+	}
+
+	size_t VulkanDescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const
+	{
+		size_t seed = key.bindings.size();
+		for (const VkDescriptorSetLayoutBinding& binding : key.bindings)
+		{
+			// packs the fields that take part in the comparison
+			size_t packed = binding.binding | (static_cast<size_t>(binding.descriptorType) << 8) | (static_cast<size_t>(binding.stageFlags) << 16);
+			seed ^= std::hash<size_t>()(packed ^ (static_cast<size_t>(binding.descriptorCount) << 24)) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+		return seed;
+	}
+}
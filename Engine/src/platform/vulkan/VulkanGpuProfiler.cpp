@@ -0,0 +1,232 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanGpuProfiler.h"
+#include "platform/vulkan/VulkanPhysicalDevice.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+namespace FGEngine
+{
+	// results come in the order of the flag bits
+	static constexpr VkQueryPipelineStatisticFlags ProfilerStatisticFlags =
+		VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+	static constexpr uint32_t ProfilerStatisticCount = 5;
+
+	VulkanGpuProfiler::VulkanGpuProfiler(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, uint32_t inMaxScopes)
+	{
+		logicalDevice = inLogicalDevice;
+		maxScopes = inMaxScopes;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(*physicalDevice, &properties);
+		timestampPeriod = properties.limits.timestampPeriod;
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(*physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(*physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		// 0 valid bits means the graphics queue writes no timestamps at all
+		uint32_t validBits = queueFamilies[logicalDevice->GetGraphicsQueueFamily()].timestampValidBits;
+		bTimestamps = validBits > 0 && timestampPeriod > 0.0f;
+		timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+		statisticFlags = logicalDevice->IsPipelineStatisticsEnabled() ? ProfilerStatisticFlags : 0;
+
+		LogInfo("GPU profiler: timestamps %s, pipeline statistics %s",
+			bTimestamps ? "on" : "off", statisticFlags != 0 ? "on" : "off");
+
+		frames.resize(frameCount);
+		for (Frame& frame : frames)
+		{
+			if (bTimestamps)
+			{
+				VkQueryPoolCreateInfo queryPoolCreateInfo{};
+				queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+				queryPoolCreateInfo.queryCount = maxScopes * 2;
+
+				VkResult result = vkCreateQueryPool(*logicalDevice, &queryPoolCreateInfo, VulkanUtil::GetAllocationCallbacks(), &frame.timestampPool);
+				Check(result == VK_SUCCESS, "Failed to create timestamp query pool. Vulkan error: %d", result);
+			}
+
+			if (statisticFlags != 0)
+			{
+				VkQueryPoolCreateInfo queryPoolCreateInfo{};
+				queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				queryPoolCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+				queryPoolCreateInfo.queryCount = maxScopes;
+				queryPoolCreateInfo.pipelineStatistics = statisticFlags;
+
+				VkResult result = vkCreateQueryPool(*logicalDevice, &queryPoolCreateInfo, VulkanUtil::GetAllocationCallbacks(), &frame.statisticsPool);
+				Check(result == VK_SUCCESS, "Failed to create pipeline statistics query pool. Vulkan error: %d", result);
+			}
+		}
+	}
+
+	VulkanGpuProfiler::~VulkanGpuProfiler()
+	{
+		std::vector<VkQueryPool> queryPools;
+		for (const Frame& frame : frames)
+		{
+			if (frame.timestampPool) queryPools.push_back(frame.timestampPool);
+			if (frame.statisticsPool) queryPools.push_back(frame.statisticsPool);
+		}
+
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), queryPools = std::move(queryPools)]()
+			{
+				for (VkQueryPool queryPool : queryPools)
+				{
+					vkDestroyQueryPool(device, queryPool, VulkanUtil::GetAllocationCallbacks());
+				}
+			});
+	}
+
+	void VulkanGpuProfiler::Collect(uint32_t frame)
+	{
+		Frame& collected = frames[frame];
+		if (!collected.bPending) return;
+		collected.bPending = false;
+
+		const uint32_t scopeCount = static_cast<uint32_t>(collected.scopes.size());
+		std::vector<uint64_t> timestamps(scopeCount * 2);
+		if (bTimestamps && scopeCount > 0)
+		{
+			// no wait flag, the fence of the frame has signaled so everything it wrote is available
+			VkResult result = vkGetQueryPoolResults(*logicalDevice, collected.timestampPool, 0, scopeCount * 2,
+				timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if (result == VK_NOT_READY) return;
+			Check(result == VK_SUCCESS, "Failed to read timestamp queries. Vulkan error: %d", result);
+		}
+
+		GpuFrameStats stats;
+		stats.frameNumber = collected.frameNumber;
+		stats.scopes.reserve(scopeCount);
+		for (uint32_t i = 0; i < scopeCount; i++)
+		{
+			const Scope& scope = collected.scopes[i];
+
+			GpuScopeStats scopeStats;
+			scopeStats.name = scope.name;
+			scopeStats.depth = scope.depth;
+			if (bTimestamps)
+			{
+				uint64_t ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask;
+				scopeStats.gpuTimeMs = ticks * static_cast<double>(timestampPeriod) / 1000000.0;
+			}
+
+			if (scope.bStatistics && statisticFlags != 0)
+			{
+				uint64_t values[ProfilerStatisticCount];
+				VkResult result = vkGetQueryPoolResults(*logicalDevice, collected.statisticsPool, i, 1,
+					sizeof(values), values, sizeof(values), VK_QUERY_RESULT_64_BIT);
+				if (result == VK_SUCCESS)
+				{
+					scopeStats.bHasStatistics = true;
+					scopeStats.inputPrimitives = values[0];
+					scopeStats.vertexInvocations = values[1];
+					scopeStats.clippingPrimitives = values[2];
+					scopeStats.fragmentInvocations = values[3];
+					scopeStats.computeInvocations = values[4];
+				}
+			}
+
+			stats.scopes.push_back(std::move(scopeStats));
+		}
+
+		lastFrameStats = std::move(stats);
+	}
+
+	void VulkanGpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber)
+	{
+		Check(openScopes.empty(), "GPU profiler scope %s still open at the start of a frame", frames[currentFrame].scopes[openScopes.back()].name.c_str());
+
+		currentFrame = frame;
+		Frame& recorded = frames[frame];
+		recorded.scopes.clear();
+		recorded.frameNumber = frameNumber;
+		recorded.bPending = IsEnabled();
+
+		if (recorded.timestampPool)
+		{
+			vkCmdResetQueryPool(commandBuffer, recorded.timestampPool, 0, maxScopes * 2);
+		}
+		if (recorded.statisticsPool)
+		{
+			vkCmdResetQueryPool(commandBuffer, recorded.statisticsPool, 0, maxScopes);
+		}
+	}
+
+	uint32_t VulkanGpuProfiler::AddScope(const std::string& name)
+	{
+		if (!IsEnabled()) return UINT32_MAX;
+
+		Frame& recorded = frames[currentFrame];
+		if (recorded.scopes.size() >= maxScopes)
+		{
+			if (!bOutOfScopesLogged)
+			{
+				LogWarning("GPU profiler out of scopes, %s and later scopes of a frame are not measured", name.c_str());
+				bOutOfScopesLogged = true;
+			}
+			return UINT32_MAX;
+		}
+
+		recorded.scopes.push_back({ name, static_cast<uint32_t>(openScopes.size()), false });
+		return static_cast<uint32_t>(recorded.scopes.size() - 1);
+	}
+
+	void VulkanGpuProfiler::WriteBegin(VkCommandBuffer commandBuffer, uint32_t scope) const
+	{
+		if (scope == UINT32_MAX || !bTimestamps) return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frames[currentFrame].timestampPool, scope * 2);
+	}
+
+	void VulkanGpuProfiler::WriteEnd(VkCommandBuffer commandBuffer, uint32_t scope) const
+	{
+		if (scope == UINT32_MAX || !bTimestamps) return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[currentFrame].timestampPool, scope * 2 + 1);
+	}
+
+	uint32_t VulkanGpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const std::string& name, bool bStatistics)
+	{
+		uint32_t scope = AddScope(name);
+		if (scope == UINT32_MAX) return scope;
+
+		openScopes.push_back(scope);
+		WriteBegin(commandBuffer, scope);
+
+		if (bStatistics && statisticFlags != 0)
+		{
+			Check(!bStatisticsOpen, "GPU profiler scope %s gathers statistics inside another scope that does", name.c_str());
+
+			frames[currentFrame].scopes[scope].bStatistics = true;
+			vkCmdBeginQuery(commandBuffer, frames[currentFrame].statisticsPool, scope, 0);
+			bStatisticsOpen = true;
+		}
+		return scope;
+	}
+
+	void VulkanGpuProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t scope)
+	{
+		if (scope == UINT32_MAX) return;
+
+		Check(!openScopes.empty() && openScopes.back() == scope, "GPU profiler scopes ended out of order");
+		openScopes.pop_back();
+
+		if (frames[currentFrame].scopes[scope].bStatistics)
+		{
+			vkCmdEndQuery(commandBuffer, frames[currentFrame].statisticsPool, scope);
+			bStatisticsOpen = false;
+		}
+		WriteEnd(commandBuffer, scope);
+	}
+}
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "platform/vulkan/VulkanInstance.h"
+#include "platform/vulkan/VulkanUtil.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include "GLFW/glfw3.h"
@@ -8,14 +9,20 @@ namespace FGEngine
 {
 	VulkanInstance::VulkanInstance(GLFWwindow* nativeWindow, const VulkanInstanceParameters& parameters)
 	{
-		CreateInstance(parameters);
-		CreateSurface(nativeWindow);
+		CreateInstance(parameters, nativeWindow != nullptr);
+		if (nativeWindow)
+		{
+			CreateSurface(nativeWindow);
+		}
 	}
 
 	VulkanInstance::~VulkanInstance()
 	{
-		vkDestroySurfaceKHR(instance, surface, nullptr);
-		vkDestroyInstance(instance, nullptr);
+		if (surface)
+		{
+			vkDestroySurfaceKHR(instance, surface, VulkanUtil::GetAllocationCallbacks());
+		}
+		vkDestroyInstance(instance, VulkanUtil::GetAllocationCallbacks());
 	}
 
 	bool VulkanInstance::IsValidationLayerSupported() const
@@ -48,7 +55,7 @@ namespace FGEngine
 		return true;
 	}
 
-	void VulkanInstance::CreateInstance(const VulkanInstanceParameters& parameters)
+	void VulkanInstance::CreateInstance(const VulkanInstanceParameters& parameters, bool bWithSurface)
 	{
 		if (bEnableValidationLayers)
 		{
@@ -61,14 +68,26 @@ namespace FGEngine
 		appInfo.applicationVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);	// TODO: should include this in the setting?
 		appInfo.pEngineName = parameters.engineName.c_str();
 		appInfo.engineVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);		// TODO: should include this in the setting?
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// 1.0 loaders don't export vkEnumerateInstanceVersion
+		apiVersion = VK_API_VERSION_1_0;
+		auto FN_vkEnumerateInstanceVersion = PFN_vkEnumerateInstanceVersion(vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+		if (FN_vkEnumerateInstanceVersion)
+		{
+			FN_vkEnumerateInstanceVersion(&apiVersion);
+		}
+		apiVersion = std::min(apiVersion, static_cast<uint32_t>(VK_API_VERSION_1_2));
+		appInfo.apiVersion = apiVersion;
 
 		VkInstanceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 		createInfo.pApplicationInfo = &appInfo;
 
+		// headless needs no window system extensions, glfw may not even be initialised then
 		uint32_t glfwExtensionCount = 0;
-		createInfo.ppEnabledExtensionNames = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		if (bWithSurface)
+		{
+			createInfo.ppEnabledExtensionNames = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		}
 		createInfo.enabledExtensionCount = glfwExtensionCount;
 
 		uint32_t layerCount = 0;
@@ -79,7 +98,7 @@ namespace FGEngine
 		}
 		createInfo.enabledLayerCount = layerCount;
 
-		VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
+		VkResult result = vkCreateInstance(&createInfo, VulkanUtil::GetAllocationCallbacks(), &instance);
 		if (result != VK_SUCCESS)
 		{
 			LogAssert("Failed to create vulkan instance. Vulkan error: %d", result);
@@ -94,7 +113,7 @@ namespace FGEngine
 	{
 		Check(nativeWindow, "No window supplied!");
 
-		VkResult result = glfwCreateWindowSurface(instance, nativeWindow, nullptr, &surface);
+		VkResult result = glfwCreateWindowSurface(instance, nativeWindow, VulkanUtil::GetAllocationCallbacks(), &surface);
 		Check(result == VK_SUCCESS, "Failed to create surface! Vulkan error: %d", result);
 	}
 }
@@ -2,6 +2,10 @@
 #include "platform/vulkan/VulkanLogicalDevice.h"
 #include "platform/vulkan/VulkanInstance.h"
 #include "platform/vulkan/VulkanPhysicalDevice.h"
+#include "platform/vulkan/VulkanUtil.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanPipelineCache.h"
 
 #include <set>
 
@@ -14,11 +18,21 @@ namespace FGEngine
 	{
 		QueueFamilyIndices queueFamilyIndices = physicalDevice->GetQueueFamilyIndices();
 
+		// uploads signal the graphics queue through a timeline semaphore, without one they stay on the graphics queue
+		bDedicatedTransferQueue = queueFamilyIndices.transferFamily.has_value() && physicalDevice->IsTimelineSemaphoreSupported();
+		transferQueueFamily = bDedicatedTransferQueue ? queueFamilyIndices.transferFamily.value() : queueFamilyIndices.graphicsFamily.value();
+		// the same goes for compute work handed to the graphics queue
+		bDedicatedComputeQueue = queueFamilyIndices.computeFamily.has_value() && physicalDevice->IsTimelineSemaphoreSupported();
+		computeQueueFamily = bDedicatedComputeQueue ? queueFamilyIndices.computeFamily.value() : queueFamilyIndices.graphicsFamily.value();
+		graphicsQueueFamily = queueFamilyIndices.graphicsFamily.value();
+
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 		std::set<uint32_t> uniqueQueueFamilyIndices
 		{
 			queueFamilyIndices.graphicsFamily.value(),
 				queueFamilyIndices.presentFamily.value(),
+				transferQueueFamily,
+				computeQueueFamily,
 		};
 
 		float queuePriority = 1.0f;
@@ -34,8 +48,31 @@ namespace FGEngine
 
 		VkPhysicalDeviceFeatures deviceFeatures{};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		// for the GPU profiler, whose statistics queries span the secondaries of a render pass
+		bPipelineStatisticsEnabled = physicalDevice->IsPipelineStatisticsSupported();
+		deviceFeatures.pipelineStatisticsQuery = bPipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;
+		deviceFeatures.inheritedQueries = bPipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;
+
+		// everything the bindless table needs, chained in only when the device has all of it
+		bBindlessEnabled = physicalDevice->IsBindlessSupported();
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		if (bBindlessEnabled)
+		{
+			// a push constant index is dynamically uniform, which the 1.0 feature covers
+			deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+			features12.descriptorIndexing = VK_TRUE;
+			features12.runtimeDescriptorArray = VK_TRUE;
+			features12.descriptorBindingPartiallyBound = VK_TRUE;
+			features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+			features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		}
+		bTimelineSemaphoreEnabled = physicalDevice->IsTimelineSemaphoreSupported();
+		features12.timelineSemaphore = bTimelineSemaphoreEnabled ? VK_TRUE : VK_FALSE;
 
 		VkDeviceCreateInfo  createInfo{};
+		createInfo.pNext = bBindlessEnabled || bTimelineSemaphoreEnabled ? &features12 : nullptr;
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
@@ -53,15 +90,40 @@ namespace FGEngine
 			createInfo.enabledLayerCount = 0;
 		}
 
-		VkResult result = vkCreateDevice(*physicalDevice, &createInfo, nullptr, &device);
+		VkResult result = vkCreateDevice(*physicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &device);
 		Check(result == VK_SUCCESS, "Failed to create logical device. Vulkan error: %d", result);
 
 		vkGetDeviceQueue(device, queueFamilyIndices.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, queueFamilyIndices.presentFamily.value(), 0, &presentQueue);
+		vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+		vkGetDeviceQueue(device, computeQueueFamily, 0, &computeQueue);
+
+		// budget queries go through vkGetPhysicalDeviceMemoryProperties2, core since 1.1
+		bool bMemoryBudgetSupported =
+			std::find_if(deviceExtensions.begin(), deviceExtensions.end(),
+				[](const char* extension)
+				{
+					return strcmp(extension, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+				}) != deviceExtensions.end()
+			&& vulkanInstance->GetApiVersion() >= VK_API_VERSION_1_1
+			&& physicalDevice->GetApiVersion() >= VK_API_VERSION_1_1;
+
+		allocator = std::make_unique<VulkanMemoryAllocator>(*physicalDevice, device, bMemoryBudgetSupported);
+		deletionQueue = std::make_unique<VulkanDeletionQueue>();
+		pipelineCache = std::make_unique<VulkanPipelineCache>(*physicalDevice, device);
 	}
 
 	VulkanLogicalDevice::~VulkanLogicalDevice()
 	{
-		vkDestroyDevice(device, nullptr);
+		// retired resources may still free memory, so they go before the allocator
+		vkDeviceWaitIdle(device);
+		deletionQueue->Flush();
+		deletionQueue.reset();
+
+		// saves the cache to disk
+		pipelineCache.reset();
+
+		allocator.reset();
+		vkDestroyDevice(device, VulkanUtil::GetAllocationCallbacks());
 	}
 }
@@ -0,0 +1,551 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include <algorithm>
+#include <bit>
+#include <set>
+
+namespace FGEngine
+{
+#pragma region Helper
+	static constexpr VkDeviceSize MinAllocationSize = 256;
+	static constexpr VkDeviceSize DefaultBlockSize = 64ull * 1024 * 1024;
+	static constexpr VkDeviceSize SmallHeapSize = 1024ull * 1024 * 1024;
+
+	static uint32_t GetOrder(VkDeviceSize size)
+	{
+		VkDeviceSize roundedSize = std::bit_ceil(std::max(size, MinAllocationSize));
+		return static_cast<uint32_t>(std::countr_zero(roundedSize) - std::countr_zero(MinAllocationSize));
+	}
+
+	static VkDeviceSize GetOrderSize(uint32_t order)
+	{
+		return MinAllocationSize << order;
+	}
+#pragma endregion
+
+#pragma region VulkanMemoryBlock
+	// one VkDeviceMemory split with a buddy allocator, every range of order n is aligned to its own size
+	class VulkanMemoryBlock
+	{
+	public:
+		VulkanMemoryBlock(VkDeviceMemory inMemory, VkDeviceSize inSize, void* inMappedData, uint32_t inMemoryTypeIndex, EVulkanResourceTiling inTiling)
+			: memory(inMemory)
+			, size(inSize)
+			, mappedData(inMappedData)
+			, memoryTypeIndex(inMemoryTypeIndex)
+			, tiling(inTiling)
+		{
+			orderCount = GetOrder(size) + 1;
+			freeLists.resize(orderCount);
+			freeLists[orderCount - 1].insert(0);
+		}
+
+		bool Allocate(uint32_t order, VkDeviceSize& outOffset)
+		{
+			if (order >= orderCount) return false;
+
+			uint32_t currentOrder = order;
+			while (currentOrder < orderCount && freeLists[currentOrder].empty())
+			{
+				currentOrder++;
+			}
+			if (currentOrder >= orderCount) return false;
+
+			// lowest address first keeps allocations packed at the start of the block
+			VkDeviceSize offset = *freeLists[currentOrder].begin();
+			freeLists[currentOrder].erase(freeLists[currentOrder].begin());
+
+			while (currentOrder > order)
+			{
+				currentOrder--;
+				freeLists[currentOrder].insert(offset + GetOrderSize(currentOrder));
+			}
+
+			usedBytes += GetOrderSize(order);
+			allocationCount++;
+			outOffset = offset;
+			return true;
+		}
+
+		void Free(VkDeviceSize offset, uint32_t order)
+		{
+			usedBytes -= GetOrderSize(order);
+			allocationCount--;
+
+			while (order + 1 < orderCount)
+			{
+				VkDeviceSize buddyOffset = offset ^ GetOrderSize(order);
+				auto it = freeLists[order].find(buddyOffset);
+				if (it == freeLists[order].end()) break;
+
+				freeLists[order].erase(it);
+				offset = std::min(offset, buddyOffset);
+				order++;
+			}
+			freeLists[order].insert(offset);
+		}
+
+		VkDeviceSize GetLargestFreeRange() const
+		{
+			for (uint32_t order = orderCount; order > 0; order--)
+			{
+				if (!freeLists[order - 1].empty()) return GetOrderSize(order - 1);
+			}
+			return 0;
+		}
+
+		uint32_t GetFreeRangeCount() const
+		{
+			uint32_t count = 0;
+			for (const std::set<VkDeviceSize>& freeList : freeLists)
+			{
+				count += static_cast<uint32_t>(freeList.size());
+			}
+			return count;
+		}
+
+		VkDeviceMemory GetMemory() const { return memory; }
+		VkDeviceSize GetSize() const { return size; }
+		void* GetMappedData() const { return mappedData; }
+		uint32_t GetMemoryTypeIndex() const { return memoryTypeIndex; }
+		EVulkanResourceTiling GetTiling() const { return tiling; }
+		VkDeviceSize GetUsedBytes() const { return usedBytes; }
+		uint32_t GetAllocationCount() const { return allocationCount; }
+		bool IsEmpty() const { return allocationCount == 0; }
+
+	private:
+		VkDeviceMemory memory;
+		VkDeviceSize size;
+		void* mappedData;
+		uint32_t memoryTypeIndex;
+		EVulkanResourceTiling tiling;
+
+		uint32_t orderCount;
+		std::vector<std::set<VkDeviceSize>> freeLists;
+
+		VkDeviceSize usedBytes = 0;
+		uint32_t allocationCount = 0;
+	};
+#pragma endregion
+
+#pragma region VulkanMemoryAllocator
+	VulkanMemoryAllocator::VulkanMemoryAllocator(VkPhysicalDevice inPhysicalDevice, VkDevice inDevice, bool bInMemoryBudgetSupported)
+		: device(inDevice)
+		, physicalDevice(inPhysicalDevice)
+		, bMemoryBudgetSupported(bInMemoryBudgetSupported)
+	{
+		vkGetPhysicalDeviceMemoryProperties(inPhysicalDevice, &memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(inPhysicalDevice, &properties);
+		bufferImageGranularity = properties.limits.bufferImageGranularity;
+		maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		UpdateBudgets();
+	}
+
+	VulkanMemoryAllocator::~VulkanMemoryAllocator()
+	{
+		VulkanMemoryStats stats = GetStats();
+		Ensure(stats.allocationCount == 0 && stats.dedicatedCount == 0, "Vulkan memory allocator destroyed with %u allocations and %u dedicated allocations alive",
+			stats.allocationCount, stats.dedicatedCount);
+
+		for (auto& tilingPools : pools)
+		{
+			for (Pool& pool : tilingPools)
+			{
+				for (const std::unique_ptr<VulkanMemoryBlock>& block : pool.blocks)
+				{
+					FreeDeviceMemory(block->GetMemory(), block->GetSize(), block->GetMemoryTypeIndex());
+				}
+				pool.blocks.clear();
+			}
+		}
+	}
+
+	VulkanAllocation VulkanMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EVulkanResourceTiling tiling, bool bDedicated)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VulkanAllocation allocation;
+		if (TryAllocate(requirements, properties, tiling, bDedicated, true, allocation))
+		{
+			return allocation;
+		}
+
+		if (TryAllocate(requirements, properties, tiling, bDedicated, false, allocation))
+		{
+			LogWarning("Allocated %llu bytes over the budget of heap %u", requirements.size, GetHeapIndex(allocation.memoryTypeIndex));
+			return allocation;
+		}
+
+		// slower to access, but better than failing the resource
+		if (properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+		{
+			VkMemoryPropertyFlags fallbackProperties = properties & ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			if (TryAllocate(requirements, fallbackProperties, tiling, bDedicated, false, allocation))
+			{
+				LogWarning("Out of device local memory, %llu bytes placed in memory type %u instead", requirements.size, allocation.memoryTypeIndex);
+				return allocation;
+			}
+		}
+
+		NoEntry("Out of device memory allocating %llu bytes", requirements.size);
+		return allocation;
+	}
+
+	void VulkanMemoryAllocator::Free(VulkanAllocation& allocation)
+	{
+		if (!allocation.IsValid()) return;
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (!allocation.block)
+		{
+			dedicatedBytes[allocation.memoryTypeIndex] -= allocation.size;
+			dedicatedCount[allocation.memoryTypeIndex]--;
+			FreeDeviceMemory(allocation.memory, allocation.size, allocation.memoryTypeIndex);
+			allocation = VulkanAllocation();
+			return;
+		}
+
+		VulkanMemoryBlock* block = allocation.block;
+		block->Free(allocation.offset, allocation.order);
+		allocation = VulkanAllocation();
+
+		if (!block->IsEmpty()) return;
+
+		// keep one empty block around per pool, so a free/allocate pattern doesn't hit the driver every time
+		Pool& pool = pools[block->GetMemoryTypeIndex()][static_cast<size_t>(block->GetTiling())];
+		size_t emptyBlockCount = std::count_if(pool.blocks.begin(), pool.blocks.end(),
+			[](const std::unique_ptr<VulkanMemoryBlock>& candidate)
+			{
+				return candidate->IsEmpty();
+			});
+		if (emptyBlockCount <= 1) return;
+
+		FreeDeviceMemory(block->GetMemory(), block->GetSize(), block->GetMemoryTypeIndex());
+		std::erase_if(pool.blocks,
+			[block](const std::unique_ptr<VulkanMemoryBlock>& candidate)
+			{
+				return candidate.get() == block;
+			});
+	}
+
+	VulkanAllocation VulkanMemoryAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties)
+	{
+		VkMemoryRequirements memoryRequirements;
+		vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+		VulkanAllocation allocation = Allocate(memoryRequirements, properties, EVulkanResourceTiling::Linear);
+
+		VkResult result = vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+		Check(result == VK_SUCCESS, "Failed to bind buffer memory. Vulkan error: %d", result);
+
+		return allocation;
+	}
+
+	VulkanAllocation VulkanMemoryAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties, VkImageTiling tiling, bool bDedicated)
+	{
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(device, image, &memoryRequirements);
+
+		EVulkanResourceTiling resourceTiling = tiling == VK_IMAGE_TILING_OPTIMAL ? EVulkanResourceTiling::Optimal : EVulkanResourceTiling::Linear;
+		VulkanAllocation allocation = Allocate(memoryRequirements, properties, resourceTiling, bDedicated);
+
+		VkResult result = vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+		Check(result == VK_SUCCESS, "Failed to bind image memory. Vulkan error: %d", result);
+
+		return allocation;
+	}
+
+	void VulkanMemoryAllocator::UpdateBudgets()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			heapBudgets[i].size = memoryProperties.memoryHeaps[i].size;
+			heapAllocatedBytesAtUpdate[i] = heapAllocatedBytes[i];
+		}
+
+		if (bMemoryBudgetSupported)
+		{
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+			budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+			VkPhysicalDeviceMemoryProperties2 memoryProperties2{};
+			memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			memoryProperties2.pNext = &budgetProperties;
+
+			vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memoryProperties2);
+
+			for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+			{
+				heapBudgets[i].budget = std::min(budgetProperties.heapBudget[i], heapBudgets[i].size);
+				heapBudgets[i].usage = budgetProperties.heapUsage[i];
+			}
+		}
+		else
+		{
+			// without the extension we only know about our own memory, so leave room for everyone else
+			for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+			{
+				heapBudgets[i].budget = heapBudgets[i].size / 10 * 8;
+				heapBudgets[i].usage = heapAllocatedBytes[i];
+			}
+		}
+	}
+
+	VulkanHeapBudget VulkanMemoryAllocator::GetHeapBudget(uint32_t heapIndex) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return GetHeapBudgetLocked(heapIndex);
+	}
+
+	bool VulkanMemoryAllocator::IsDeviceLocal(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	}
+
+	VulkanMemoryStats VulkanMemoryAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VulkanMemoryStats stats;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			AccumulateStats(i, stats);
+		}
+		return stats;
+	}
+
+	VulkanMemoryStats VulkanMemoryAllocator::GetStats(uint32_t memoryTypeIndex) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		VulkanMemoryStats stats;
+		AccumulateStats(memoryTypeIndex, stats);
+		return stats;
+	}
+
+	void VulkanMemoryAllocator::LogStats() const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			VulkanMemoryStats stats = GetStats(i);
+			if (stats.blockCount == 0 && stats.dedicatedCount == 0) continue;
+
+			LogInfo("Vulkan memory type %u: %u blocks, %llu / %llu bytes used by %u allocations, %u dedicated (%llu bytes), %u free ranges, fragmentation %.2f",
+				i, stats.blockCount, stats.usedBytes, stats.blockBytes, stats.allocationCount,
+				stats.dedicatedCount, stats.dedicatedBytes, stats.freeRangeCount, stats.GetFragmentation());
+		}
+
+		for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+		{
+			VulkanHeapBudget budget = GetHeapBudget(i);
+			LogInfo("Vulkan memory heap %u: %llu / %llu bytes of budget used, heap size %llu%s",
+				i, budget.usage, budget.budget, budget.size, bMemoryBudgetSupported ? "" : " (estimated)");
+		}
+	}
+
+	bool VulkanMemoryAllocator::TryAllocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, EVulkanResourceTiling tiling, bool bDedicated, bool bWithinBudget, VulkanAllocation& outAllocation)
+	{
+		for (uint32_t memoryTypeIndex : GetMemoryTypeCandidates(requirements.memoryTypeBits, properties))
+		{
+			if (TryAllocateFromType(requirements, memoryTypeIndex, tiling, bDedicated, bWithinBudget, outAllocation))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool VulkanMemoryAllocator::TryAllocateFromType(const VkMemoryRequirements& requirements, uint32_t memoryTypeIndex, EVulkanResourceTiling tiling, bool bDedicated, bool bWithinBudget, VulkanAllocation& outAllocation)
+	{
+		uint32_t heapIndex = GetHeapIndex(memoryTypeIndex);
+
+		VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+		if (bDedicated || requirements.size > blockSize / 2)
+		{
+			if (bWithinBudget && !HasBudget(heapIndex, requirements.size)) return false;
+
+			void* mappedData = nullptr;
+			VkDeviceMemory memory = AllocateDeviceMemory(requirements.size, memoryTypeIndex, &mappedData);
+			if (memory == VK_NULL_HANDLE) return false;
+
+			outAllocation = VulkanAllocation();
+			outAllocation.memory = memory;
+			outAllocation.offset = 0;
+			outAllocation.size = requirements.size;
+			outAllocation.mappedData = mappedData;
+			outAllocation.memoryTypeIndex = memoryTypeIndex;
+
+			dedicatedBytes[memoryTypeIndex] += requirements.size;
+			dedicatedCount[memoryTypeIndex]++;
+			return true;
+		}
+
+		// buddy ranges never share a granularity page when the granularity is below the smallest range
+		if (bufferImageGranularity <= MinAllocationSize)
+		{
+			tiling = EVulkanResourceTiling::Linear;
+		}
+
+		uint32_t order = GetOrder(std::max(requirements.size, requirements.alignment));
+		Pool& pool = pools[memoryTypeIndex][static_cast<size_t>(tiling)];
+
+		// existing blocks are already paid for, only new blocks are checked against the budget
+		VkDeviceSize offset = 0;
+		VulkanMemoryBlock* block = nullptr;
+		for (const std::unique_ptr<VulkanMemoryBlock>& candidate : pool.blocks)
+		{
+			if (candidate->Allocate(order, offset))
+			{
+				block = candidate.get();
+				break;
+			}
+		}
+
+		if (!block)
+		{
+			if (bWithinBudget && !HasBudget(heapIndex, blockSize)) return false;
+
+			void* mappedData = nullptr;
+			VkDeviceMemory memory = AllocateDeviceMemory(blockSize, memoryTypeIndex, &mappedData);
+			if (memory == VK_NULL_HANDLE) return false;
+
+			pool.blocks.push_back(std::make_unique<VulkanMemoryBlock>(memory, blockSize, mappedData, memoryTypeIndex, tiling));
+
+			block = pool.blocks.back().get();
+			bool bAllocated = block->Allocate(order, offset);
+			Check(bAllocated, "Failed to sub-allocate %llu bytes from a new block", requirements.size);
+		}
+
+		outAllocation = VulkanAllocation();
+		outAllocation.memory = block->GetMemory();
+		outAllocation.offset = offset;
+		outAllocation.size = requirements.size;
+		outAllocation.mappedData = block->GetMappedData() ? static_cast<uint8_t*>(block->GetMappedData()) + offset : nullptr;
+		outAllocation.memoryTypeIndex = memoryTypeIndex;
+		outAllocation.block = block;
+		outAllocation.order = order;
+		return true;
+	}
+
+	std::vector<uint32_t> VulkanMemoryAllocator::GetMemoryTypeCandidates(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		std::vector<uint32_t> candidates;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if (!(typeFilter & (1 << i))) continue;
+
+			if ((memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				candidates.push_back(i);
+			}
+		}
+
+		// when device local isn't asked for, keep host memory first so it isn't taken from the device heaps
+		if (!(properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+		{
+			std::stable_partition(candidates.begin(), candidates.end(),
+				[this](uint32_t memoryTypeIndex)
+				{
+					return !IsDeviceLocal(memoryTypeIndex);
+				});
+		}
+
+		return candidates;
+	}
+
+	VkDeviceSize VulkanMemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+	{
+		// small heaps (e.g. the host visible device local window) get smaller blocks so one block can't take most of it
+		VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+		if (heapSize >= SmallHeapSize) return DefaultBlockSize;
+
+		return std::max(std::bit_floor(heapSize / 8), MinAllocationSize);
+	}
+
+	bool VulkanMemoryAllocator::IsHostVisible(uint32_t memoryTypeIndex) const
+	{
+		return memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	}
+
+	bool VulkanMemoryAllocator::HasBudget(uint32_t heapIndex, VkDeviceSize size) const
+	{
+		VulkanHeapBudget budget = GetHeapBudgetLocked(heapIndex);
+		return budget.usage + size <= budget.budget;
+	}
+
+	VulkanHeapBudget VulkanMemoryAllocator::GetHeapBudgetLocked(uint32_t heapIndex) const
+	{
+		// the driver figures are only refreshed by UpdateBudgets, account for what we did since
+		VulkanHeapBudget budget = heapBudgets[heapIndex];
+		budget.usage = budget.usage + heapAllocatedBytes[heapIndex] > heapAllocatedBytesAtUpdate[heapIndex]
+			? budget.usage + heapAllocatedBytes[heapIndex] - heapAllocatedBytesAtUpdate[heapIndex]
+			: 0;
+		return budget;
+	}
+
+	VkDeviceMemory VulkanMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** outMappedData)
+	{
+		Check(deviceAllocationCount < maxAllocationCount, "Reached maxMemoryAllocationCount (%u)", maxAllocationCount);
+
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = size;
+		allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory;
+		VkResult result = vkAllocateMemory(device, &allocateInfo, VulkanUtil::GetAllocationCallbacks(), &memory);
+		if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY)
+		{
+			LogWarning("Memory type %u is out of memory for %llu bytes", memoryTypeIndex, size);
+			return VK_NULL_HANDLE;
+		}
+		Check(result == VK_SUCCESS, "Failed to allocate %llu bytes of device memory. Vulkan error: %d", size, result);
+		deviceAllocationCount++;
+		heapAllocatedBytes[GetHeapIndex(memoryTypeIndex)] += size;
+
+		*outMappedData = nullptr;
+		if (IsHostVisible(memoryTypeIndex))
+		{
+			result = vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, outMappedData);
+			Check(result == VK_SUCCESS, "Failed to map device memory. Vulkan error: %d", result);
+		}
+
+		return memory;
+	}
+
+	void VulkanMemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex)
+	{
+		// freeing implicitly unmaps
+		vkFreeMemory(device, memory, VulkanUtil::GetAllocationCallbacks());
+		deviceAllocationCount--;
+		heapAllocatedBytes[GetHeapIndex(memoryTypeIndex)] -= size;
+	}
+
+	void VulkanMemoryAllocator::AccumulateStats(uint32_t memoryTypeIndex, VulkanMemoryStats& stats) const
+	{
+		for (const Pool& pool : pools[memoryTypeIndex])
+		{
+			for (const std::unique_ptr<VulkanMemoryBlock>& block : pool.blocks)
+			{
+				stats.blockBytes += block->GetSize();
+				stats.usedBytes += block->GetUsedBytes();
+				stats.largestFreeRange = std::max(stats.largestFreeRange, block->GetLargestFreeRange());
+				stats.blockCount++;
+				stats.allocationCount += block->GetAllocationCount();
+				stats.freeRangeCount += block->GetFreeRangeCount();
+			}
+		}
+
+		stats.dedicatedBytes += dedicatedBytes[memoryTypeIndex];
+		stats.dedicatedCount += dedicatedCount[memoryTypeIndex];
+	}
+#pragma endregion
+}
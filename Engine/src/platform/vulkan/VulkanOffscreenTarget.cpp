@@ -0,0 +1,66 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanOffscreenTarget.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanBuffer.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+namespace FGEngine
+{
+	VulkanOffscreenTarget::VulkanOffscreenTarget(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, VkExtent2D inExtent, uint32_t imageCount, bool bReadback)
+	{
+		Check(inExtent.width > 0 && inExtent.height > 0, "Offscreen target of %ux%u pixels", inExtent.width, inExtent.height);
+
+		logicalDevice = inLogicalDevice;
+		extent = inExtent;
+
+		images.resize(imageCount);
+		imageAllocations.resize(imageCount);
+		imageViews.resize(imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			// the main pass resolves into it, the readback copies out of it
+			VulkanUtil::CreateImage(logicalDevice, extent.width, extent.height, 1, VK_SAMPLE_COUNT_1_BIT, imageFormat,
+				VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, images[i], imageAllocations[i], true);
+			imageViews[i] = VulkanUtil::CreateImageView(logicalDevice, images[i], imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+		}
+
+		if (!bReadback) return;
+
+		readbackBuffers.resize(imageCount);
+		readbackAllocations.resize(imageCount);
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			VulkanBuffer::CreateBuffer(
+				logicalDevice,
+				GetReadbackSize(),
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				readbackBuffers[i], readbackAllocations[i]);
+		}
+	}
+
+	VulkanOffscreenTarget::~VulkanOffscreenTarget()
+	{
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), allocator = &logicalDevice->GetAllocator(),
+			images = std::move(images), imageAllocations = std::move(imageAllocations), imageViews = std::move(imageViews),
+			readbackBuffers = std::move(readbackBuffers), readbackAllocations = std::move(readbackAllocations)]() mutable
+			{
+				for (size_t i = 0; i < images.size(); i++)
+				{
+					vkDestroyImageView(device, imageViews[i], VulkanUtil::GetAllocationCallbacks());
+					vkDestroyImage(device, images[i], VulkanUtil::GetAllocationCallbacks());
+					allocator->Free(imageAllocations[i]);
+				}
+				for (size_t i = 0; i < readbackBuffers.size(); i++)
+				{
+					vkDestroyBuffer(device, readbackBuffers[i], VulkanUtil::GetAllocationCallbacks());
+					allocator->Free(readbackAllocations[i]);
+				}
+			});
+	}
+}
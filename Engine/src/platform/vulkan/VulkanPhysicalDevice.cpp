@@ -35,28 +35,46 @@ namespace FGEngine
 		std::vector<VkQueueFamilyProperties> properties(queueFamilyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, properties.data());
 
+		// every family is visited, the transfer and compute families tend to come after the graphics one
 		int i = 0;
 		for (const VkQueueFamilyProperties& property : properties)
 		{
-			if (property.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			if ((property.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !queueFamilyIndices.graphicsFamily.has_value())
 			{
 				queueFamilyIndices.graphicsFamily = i;
 			}
 
-			VkBool32 bHasPresentSupport;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &bHasPresentSupport);
-			if (bHasPresentSupport)
+			VkBool32 bHasPresentSupport = VK_FALSE;
+			if (surface != VK_NULL_HANDLE)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &bHasPresentSupport);
+			}
+			if (bHasPresentSupport && !queueFamilyIndices.presentFamily.has_value())
 			{
 				queueFamilyIndices.presentFamily = i;
 			}
 
-			if (queueFamilyIndices.IsComplete())
+			bool bTransferOnly = (property.queueFlags & VK_QUEUE_TRANSFER_BIT)
+				&& !(property.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+			if (bTransferOnly && !queueFamilyIndices.transferFamily.has_value())
 			{
-				break;
+				queueFamilyIndices.transferFamily = i;
+			}
+
+			bool bAsyncCompute = (property.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(property.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+			if (bAsyncCompute && !queueFamilyIndices.computeFamily.has_value())
+			{
+				queueFamilyIndices.computeFamily = i;
 			}
 			i++;
 		}
 
+		// headless, nothing is presented. the graphics queue stands in so the present queue stays valid
+		if (surface == VK_NULL_HANDLE)
+		{
+			queueFamilyIndices.presentFamily = queueFamilyIndices.graphicsFamily;
+		}
+
 		return queueFamilyIndices;
 	}
 
@@ -113,8 +131,9 @@ namespace FGEngine
 
 		bool bExtensionSupported = IsDeviceExtensionsSupported(device, deviceExtensions);
 
-		bool bSwapChainAdequate = false;
-		if (bExtensionSupported)
+		// headless needs no swap chain
+		bool bSwapChainAdequate = surface == VK_NULL_HANDLE;
+		if (bExtensionSupported && surface != VK_NULL_HANDLE)
 		{
 			SwapChainSupportDetails supportDetails = QuerySwapChainSupport(device, surface);
 			bSwapChainAdequate = !supportDetails.surfaceFormats.empty() && !supportDetails.presentModes.empty();
@@ -212,13 +231,47 @@ namespace FGEngine
 		VkPhysicalDeviceProperties properties;
 		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
 		LogInfo("Device Name: %s", properties.deviceName);
+		apiVersion = properties.apiVersion;
+
+		// vkGetPhysicalDeviceFeatures2 needs a 1.1 instance, the features themselves 1.2
+		if (vulkanInstance->GetApiVersion() >= VK_API_VERSION_1_2 && apiVersion >= VK_API_VERSION_1_2)
+		{
+			VkPhysicalDeviceVulkan12Features features12{};
+			features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &features12;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+			bBindlessSupported = features12.descriptorIndexing
+				&& features12.runtimeDescriptorArray
+				&& features12.descriptorBindingPartiallyBound
+				&& features12.descriptorBindingUpdateUnusedWhilePending
+				&& features12.descriptorBindingSampledImageUpdateAfterBind
+				&& features12.shaderSampledImageArrayNonUniformIndexing
+				// the bindless shaders index the texture array with a push constant
+				&& features.features.shaderSampledImageArrayDynamicIndexing;
+			bTimelineSemaphoreSupported = features12.timelineSemaphore;
+		}
+
+		VkPhysicalDeviceFeatures features;
+		vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+		bPipelineStatisticsSupported = features.pipelineStatisticsQuery && features.inheritedQueries;
+
+		LogInfo("Bindless descriptors: %s", bBindlessSupported ? "supported" : "not supported");
+		LogInfo("Timeline semaphores: %s", bTimelineSemaphoreSupported ? "supported" : "not supported");
+		LogInfo("Pipeline statistics: %s", bPipelineStatisticsSupported ? "supported" : "not supported");
 
 		Refresh(vulkanInstance);
 	}
 
 	void VulkanPhysicalDevice::Refresh(const std::shared_ptr<VulkanInstance>& vulkanInstance)
 	{
-		swapChainSupportDetails = QuerySwapChainSupport(physicalDevice, vulkanInstance->GetSurface());
+		if (vulkanInstance->GetSurface())
+		{
+			swapChainSupportDetails = QuerySwapChainSupport(physicalDevice, vulkanInstance->GetSurface());
+		}
 		queueFamilyIndices = FindQueueFamilies(physicalDevice, vulkanInstance->GetSurface());
 		maxSampleCount = GetMaxUsableSampleCount(physicalDevice);
 	}
@@ -241,6 +294,11 @@ namespace FGEngine
 		NoEntry("Failed to find suitable memory type");
 	}
 
+	bool VulkanPhysicalDevice::IsExtensionSupported(const char* extensionName) const
+	{
+		return IsDeviceExtensionsSupported(physicalDevice, { extensionName });
+	}
+
 	VkFormat VulkanPhysicalDevice::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const
 	{
 		for (VkFormat format : candidates)
@@ -1,34 +1,239 @@
 #include "pch.h"
 #include "platform/vulkan/VulkanPipeline.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanPipelineCache.h"
 #include "platform/vulkan/VulkanShaderModule.h"
 #include "platform/vulkan/VulkanUtil.h"
 
+#include <algorithm>
+#include <functional>
 
 namespace FGEngine
 {
-    VulkanPipeline::VulkanPipeline(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const VulkanPipelineSetting& setting)
+	template<typename T>
+	static void HashCombine(size_t& seed, const T& value)
+	{
+		seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
+
+	// FNV-1a, std::hash may differ between standard library versions
+	static void PersistentHashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+	}
+
+	template<typename T>
+	static void PersistentHashValue(uint64_t& hash, const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only plain values hash the same in every run");
+		PersistentHashBytes(hash, &value, sizeof(T));
+	}
+
+	static void PersistentHashString(uint64_t& hash, const std::string& value)
+	{
+		PersistentHashValue(hash, static_cast<uint64_t>(value.size()));
+		PersistentHashBytes(hash, value.data(), value.size());
+	}
+
+	void VulkanPipelineState::SetAlphaBlend()
+	{
+		bDepthWrite = false;
+		bBlend = true;
+		srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendOp = VK_BLEND_OP_ADD;
+		srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		alphaBlendOp = VK_BLEND_OP_ADD;
+	}
+
+	void VulkanPipelineState::SetAdditiveBlend()
+	{
+		SetAlphaBlend();
+		dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	}
+
+	size_t VulkanPipelineState::Hash() const
+	{
+		size_t seed = 0;
+		HashCombine(seed, vertexShaderModule->GetFilename());
+		HashCombine(seed, fragmentShaderModule->GetFilename());
+
+		for (const VkVertexInputBindingDescription& binding : vertexBindings)
+		{
+			HashCombine(seed, binding.binding);
+			HashCombine(seed, binding.stride);
+			HashCombine(seed, binding.inputRate);
+		}
+		for (const VkVertexInputAttributeDescription& attribute : vertexAttributes)
+		{
+			HashCombine(seed, attribute.location);
+			HashCombine(seed, attribute.binding);
+			HashCombine(seed, attribute.format);
+			HashCombine(seed, attribute.offset);
+		}
+		HashCombine(seed, topology);
+
+		HashCombine(seed, polygonMode);
+		HashCombine(seed, cullMode);
+		HashCombine(seed, frontFace);
+
+		HashCombine(seed, bDepthTest);
+		HashCombine(seed, bDepthWrite);
+		HashCombine(seed, depthCompareOp);
+
+		HashCombine(seed, bBlend);
+		HashCombine(seed, srcColorBlendFactor);
+		HashCombine(seed, dstColorBlendFactor);
+		HashCombine(seed, colorBlendOp);
+		HashCombine(seed, srcAlphaBlendFactor);
+		HashCombine(seed, dstAlphaBlendFactor);
+		HashCombine(seed, alphaBlendOp);
+		HashCombine(seed, colorWriteMask);
+
+		HashCombine(seed, msaaSamples);
+
+		for (VkDescriptorSetLayout setLayout : descriptorSetLayouts)
+		{
+			HashCombine(seed, setLayout);
+		}
+		for (const VkPushConstantRange& range : pushConstantRanges)
+		{
+			HashCombine(seed, range.stageFlags);
+			HashCombine(seed, range.offset);
+			HashCombine(seed, range.size);
+		}
+
+		HashCombine(seed, renderPass);
+		HashCombine(seed, subpass);
+		return seed;
+	}
+
+	uint64_t VulkanPipelineState::PersistentHash() const
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		PersistentHashString(hash, vertexShaderModule->GetFilename());
+		PersistentHashString(hash, fragmentShaderModule->GetFilename());
+
+		PersistentHashValue(hash, static_cast<uint64_t>(vertexBindings.size()));
+		for (const VkVertexInputBindingDescription& binding : vertexBindings)
+		{
+			PersistentHashValue(hash, binding.binding);
+			PersistentHashValue(hash, binding.stride);
+			PersistentHashValue(hash, binding.inputRate);
+		}
+		PersistentHashValue(hash, static_cast<uint64_t>(vertexAttributes.size()));
+		for (const VkVertexInputAttributeDescription& attribute : vertexAttributes)
+		{
+			PersistentHashValue(hash, attribute.location);
+			PersistentHashValue(hash, attribute.binding);
+			PersistentHashValue(hash, attribute.format);
+			PersistentHashValue(hash, attribute.offset);
+		}
+		PersistentHashValue(hash, topology);
+
+		PersistentHashValue(hash, polygonMode);
+		PersistentHashValue(hash, cullMode);
+		PersistentHashValue(hash, frontFace);
+
+		PersistentHashValue(hash, bDepthTest);
+		PersistentHashValue(hash, bDepthWrite);
+		PersistentHashValue(hash, depthCompareOp);
+
+		PersistentHashValue(hash, bBlend);
+		PersistentHashValue(hash, srcColorBlendFactor);
+		PersistentHashValue(hash, dstColorBlendFactor);
+		PersistentHashValue(hash, colorBlendOp);
+		PersistentHashValue(hash, srcAlphaBlendFactor);
+		PersistentHashValue(hash, dstAlphaBlendFactor);
+		PersistentHashValue(hash, alphaBlendOp);
+		PersistentHashValue(hash, colorWriteMask);
+
+		PersistentHashValue(hash, msaaSamples);
+
+		// the layouts themselves are recreated every run, only their number says something about the state
+		PersistentHashValue(hash, static_cast<uint64_t>(descriptorSetLayouts.size()));
+		PersistentHashValue(hash, static_cast<uint64_t>(pushConstantRanges.size()));
+		for (const VkPushConstantRange& range : pushConstantRanges)
+		{
+			PersistentHashValue(hash, range.stageFlags);
+			PersistentHashValue(hash, range.offset);
+			PersistentHashValue(hash, range.size);
+		}
+
+		PersistentHashValue(hash, subpass);
+		return hash;
+	}
+
+	bool VulkanPipelineState::operator==(const VulkanPipelineState& other) const
+	{
+		auto bindingEqual = [](const VkVertexInputBindingDescription& a, const VkVertexInputBindingDescription& b)
+			{
+				return a.binding == b.binding && a.stride == b.stride && a.inputRate == b.inputRate;
+			};
+		auto attributeEqual = [](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b)
+			{
+				return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+			};
+		auto rangeEqual = [](const VkPushConstantRange& a, const VkPushConstantRange& b)
+			{
+				return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+			};
+
+		// shader modules compare by source file, so a shader loaded twice is still one state
+		return vertexShaderModule->GetFilename() == other.vertexShaderModule->GetFilename()
+			&& fragmentShaderModule->GetFilename() == other.fragmentShaderModule->GetFilename()
+			&& std::equal(vertexBindings.begin(), vertexBindings.end(), other.vertexBindings.begin(), other.vertexBindings.end(), bindingEqual)
+			&& std::equal(vertexAttributes.begin(), vertexAttributes.end(), other.vertexAttributes.begin(), other.vertexAttributes.end(), attributeEqual)
+			&& topology == other.topology
+			&& polygonMode == other.polygonMode
+			&& cullMode == other.cullMode
+			&& frontFace == other.frontFace
+			&& bDepthTest == other.bDepthTest
+			&& bDepthWrite == other.bDepthWrite
+			&& depthCompareOp == other.depthCompareOp
+			&& bBlend == other.bBlend
+			&& srcColorBlendFactor == other.srcColorBlendFactor
+			&& dstColorBlendFactor == other.dstColorBlendFactor
+			&& colorBlendOp == other.colorBlendOp
+			&& srcAlphaBlendFactor == other.srcAlphaBlendFactor
+			&& dstAlphaBlendFactor == other.dstAlphaBlendFactor
+			&& alphaBlendOp == other.alphaBlendOp
+			&& colorWriteMask == other.colorWriteMask
+			&& msaaSamples == other.msaaSamples
+			&& descriptorSetLayouts == other.descriptorSetLayouts
+			&& std::equal(pushConstantRanges.begin(), pushConstantRanges.end(), other.pushConstantRanges.begin(), other.pushConstantRanges.end(), rangeEqual)
+			&& renderPass == other.renderPass
+			&& subpass == other.subpass;
+	}
+
+    VulkanPipeline::VulkanPipeline(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const VulkanPipelineState& state, uint32_t inId)
     {
         logicalDevice = inLogicalDevice;
+        id = inId;
 
 		VkPipelineShaderStageCreateInfo shaderStages[] = {
-			setting.vertexShaderModule->GetCreateInfo(),
-			setting.fragmentShaderModule->GetCreateInfo()
+			state.vertexShaderModule->GetCreateInfo(),
+			state.fragmentShaderModule->GetCreateInfo()
 		};
 
-		auto bindingDescription = VertexHelper::GetBindingDescription();
-		auto attributeDescription = VertexHelper::GetAttributeDescriptions();
-
 		VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo{};
 		vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputCreateInfo.vertexBindingDescriptionCount = 1;
-		vertexInputCreateInfo.pVertexBindingDescriptions = &bindingDescription;
-		vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescription.size());
-		vertexInputCreateInfo.pVertexAttributeDescriptions = attributeDescription.data();
+		vertexInputCreateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(state.vertexBindings.size());
+		vertexInputCreateInfo.pVertexBindingDescriptions = state.vertexBindings.data();
+		vertexInputCreateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.vertexAttributes.size());
+		vertexInputCreateInfo.pVertexAttributeDescriptions = state.vertexAttributes.data();
 
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo{};
 		inputAssemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssemblyCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssemblyCreateInfo.topology = state.topology;
 		inputAssemblyCreateInfo.primitiveRestartEnable = VK_FALSE;
 
 		std::vector<VkDynamicState> dynamicStates {
@@ -50,16 +255,16 @@ namespace FGEngine
 		rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 		rasterizerCreateInfo.depthClampEnable = VK_FALSE;
 		rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;
-		rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL; // TODO: experiment with other mode to see how they look like, but they will need to enable a gpu feature
+		rasterizerCreateInfo.polygonMode = state.polygonMode; // modes other than fill need the fillModeNonSolid device feature
 		rasterizerCreateInfo.lineWidth = 1.0f;
-		rasterizerCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizerCreateInfo.cullMode = state.cullMode;
+		rasterizerCreateInfo.frontFace = state.frontFace;
 		rasterizerCreateInfo.depthBiasEnable = VK_FALSE;
 
 		VkPipelineMultisampleStateCreateInfo multisampleCreateInfo{};
 		multisampleCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 		multisampleCreateInfo.sampleShadingEnable = VK_FALSE;
-		multisampleCreateInfo.rasterizationSamples = setting.msaaSamples;
+		multisampleCreateInfo.rasterizationSamples = state.msaaSamples;
 		multisampleCreateInfo.minSampleShading = 1.0f;
 		multisampleCreateInfo.pSampleMask = nullptr;
 		multisampleCreateInfo.alphaToCoverageEnable = VK_FALSE;
@@ -67,9 +272,9 @@ namespace FGEngine
 
 		VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo{};
 		depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencilCreateInfo.depthTestEnable = VK_TRUE;
-		depthStencilCreateInfo.depthWriteEnable = VK_TRUE;
-		depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+		depthStencilCreateInfo.depthTestEnable = state.bDepthTest ? VK_TRUE : VK_FALSE;
+		depthStencilCreateInfo.depthWriteEnable = state.bDepthWrite ? VK_TRUE : VK_FALSE;
+		depthStencilCreateInfo.depthCompareOp = state.depthCompareOp;
 		depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;
 		depthStencilCreateInfo.minDepthBounds = 0.0f;
 		depthStencilCreateInfo.maxDepthBounds = 1.0f;
@@ -78,14 +283,14 @@ namespace FGEngine
 		depthStencilCreateInfo.back = {};
 
 		VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.colorWriteMask = state.colorWriteMask;
+		colorBlendAttachment.blendEnable = state.bBlend ? VK_TRUE : VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = state.srcColorBlendFactor;
+		colorBlendAttachment.dstColorBlendFactor = state.dstColorBlendFactor;
+		colorBlendAttachment.colorBlendOp = state.colorBlendOp;
+		colorBlendAttachment.srcAlphaBlendFactor = state.srcAlphaBlendFactor;
+		colorBlendAttachment.dstAlphaBlendFactor = state.dstAlphaBlendFactor;
+		colorBlendAttachment.alphaBlendOp = state.alphaBlendOp;
 
 		VkPipelineColorBlendStateCreateInfo colorBlendCreateInfo{};
 		colorBlendCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
@@ -100,12 +305,12 @@ namespace FGEngine
 
 		VkPipelineLayoutCreateInfo layoutCreateInfo{};
 		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		layoutCreateInfo.setLayoutCount = 1;
-		layoutCreateInfo.pSetLayouts = &setting.descriptorSetLayout; // TODO: probably should not be passing descriptor set layout like that..
-		layoutCreateInfo.pushConstantRangeCount = 0;
-		layoutCreateInfo.pPushConstantRanges = nullptr;
+		layoutCreateInfo.setLayoutCount = static_cast<uint32_t>(state.descriptorSetLayouts.size());
+		layoutCreateInfo.pSetLayouts = state.descriptorSetLayouts.data();
+		layoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(state.pushConstantRanges.size());
+		layoutCreateInfo.pPushConstantRanges = state.pushConstantRanges.data();
 
-		VkResult result = vkCreatePipelineLayout(*logicalDevice, &layoutCreateInfo, nullptr, &pipelineLayout);
+		VkResult result = vkCreatePipelineLayout(*logicalDevice, &layoutCreateInfo, VulkanUtil::GetAllocationCallbacks(), &pipelineLayout);
 		Check(result == VK_SUCCESS, "Failed to create pipeline layout. Vulkan error: %d", result);
 
 		VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
@@ -121,18 +326,58 @@ namespace FGEngine
 		pipelineCreateInfo.pColorBlendState = &colorBlendCreateInfo;
 		pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
 		pipelineCreateInfo.layout = pipelineLayout;
-		pipelineCreateInfo.renderPass = setting.renderPass;
-		pipelineCreateInfo.subpass = 0;
+		pipelineCreateInfo.renderPass = state.renderPass;
+		pipelineCreateInfo.subpass = state.subpass;
 		pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 		pipelineCreateInfo.basePipelineIndex = -1;
 
-		result = vkCreateGraphicsPipelines(*logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline);
+		result = vkCreateGraphicsPipelines(*logicalDevice, logicalDevice->GetPipelineCache(), 1, &pipelineCreateInfo, VulkanUtil::GetAllocationCallbacks(), &graphicsPipeline);
 		Check(result == VK_SUCCESS, "Failed to create graphics pipeline. Vulkan error: %d", result);
     }
 
     VulkanPipeline::~VulkanPipeline()
     {
-        vkDestroyPipeline(*logicalDevice, graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(*logicalDevice, pipelineLayout, nullptr);
+        logicalDevice->GetDeletionQueue().Retire(
+            [device = static_cast<VkDevice>(*logicalDevice), graphicsPipeline = graphicsPipeline, pipelineLayout = pipelineLayout]()
+            {
+                vkDestroyPipeline(device, graphicsPipeline, VulkanUtil::GetAllocationCallbacks());
+                vkDestroyPipelineLayout(device, pipelineLayout, VulkanUtil::GetAllocationCallbacks());
+            });
     }
+
+	VulkanComputePipeline::VulkanComputePipeline(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const VulkanShaderModule& shaderModule,
+		const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges)
+	{
+		logicalDevice = inLogicalDevice;
+
+		VkPipelineLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+		layoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
+		layoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		layoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		VkResult result = vkCreatePipelineLayout(*logicalDevice, &layoutCreateInfo, VulkanUtil::GetAllocationCallbacks(), &pipelineLayout);
+		Check(result == VK_SUCCESS, "Failed to create compute pipeline layout. Vulkan error: %d", result);
+
+		VkComputePipelineCreateInfo pipelineCreateInfo{};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.stage = shaderModule.GetCreateInfo();
+		pipelineCreateInfo.layout = pipelineLayout;
+		pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCreateInfo.basePipelineIndex = -1;
+
+		result = vkCreateComputePipelines(*logicalDevice, logicalDevice->GetPipelineCache(), 1, &pipelineCreateInfo, VulkanUtil::GetAllocationCallbacks(), &computePipeline);
+		Check(result == VK_SUCCESS, "Failed to create compute pipeline. Vulkan error: %d", result);
+	}
+
+	VulkanComputePipeline::~VulkanComputePipeline()
+	{
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), computePipeline = computePipeline, pipelineLayout = pipelineLayout]()
+			{
+				vkDestroyPipeline(device, computePipeline, VulkanUtil::GetAllocationCallbacks());
+				vkDestroyPipelineLayout(device, pipelineLayout, VulkanUtil::GetAllocationCallbacks());
+			});
+	}
 }
\ No newline at end of file
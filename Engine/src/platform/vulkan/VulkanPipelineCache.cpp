@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanPipelineCache.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace FGEngine
+{
+	static std::vector<char> ReadCacheFile(const std::string& filePath)
+	{
+		std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			return {};
+		}
+
+		size_t fileSize = (size_t)file.tellg();
+		std::vector<char> buffer(fileSize);
+
+		file.seekg(0);
+		file.read(buffer.data(), fileSize);
+		if (!file)
+		{
+			return {};
+		}
+
+		return buffer;
+	}
+
+	VulkanPipelineCache::VulkanPipelineCache(VkPhysicalDevice physicalDevice, VkDevice inDevice, const std::string& inFilePath)
+	{
+		device = inDevice;
+		filePath = inFilePath;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+		std::vector<char> initialData = ReadCacheFile(filePath);
+		if (!initialData.empty() && !IsCompatible(initialData))
+		{
+			LogWarning("Pipeline cache %s was created by another device or driver, starting with an empty cache", filePath.c_str());
+			initialData.clear();
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = initialData.size();
+		createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+		VkResult result = vkCreatePipelineCache(device, &createInfo, VulkanUtil::GetAllocationCallbacks(), &pipelineCache);
+		if (result != VK_SUCCESS && !initialData.empty())
+		{
+			LogWarning("Pipeline cache %s was rejected by the driver, starting with an empty cache. Vulkan error: %d", filePath.c_str(), result);
+			createInfo.initialDataSize = 0;
+			createInfo.pInitialData = nullptr;
+			initialData.clear();
+			result = vkCreatePipelineCache(device, &createInfo, VulkanUtil::GetAllocationCallbacks(), &pipelineCache);
+		}
+		Check(result == VK_SUCCESS, "Failed to create pipeline cache. Vulkan error: %d", result);
+
+		savedSize = initialData.size();
+	}
+
+	VulkanPipelineCache::~VulkanPipelineCache()
+	{
+		Save();
+		vkDestroyPipelineCache(device, pipelineCache, VulkanUtil::GetAllocationCallbacks());
+	}
+
+	void VulkanPipelineCache::Save()
+	{
+		size_t dataSize = 0;
+		VkResult result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr);
+		if (result != VK_SUCCESS || dataSize == savedSize)
+		{
+			return;
+		}
+
+		std::vector<char> data(dataSize);
+		result = vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data());
+		if (result != VK_SUCCESS)
+		{
+			LogWarning("Failed to read pipeline cache data. Vulkan error: %d", result);
+			return;
+		}
+		data.resize(dataSize);
+
+		// written next to the cache and renamed over it, so a crash mid-write never leaves a truncated cache behind
+		std::string tempFilePath = filePath + ".tmp";
+		{
+			std::ofstream file(tempFilePath, std::ios::binary | std::ios::trunc);
+			file.write(data.data(), data.size());
+			if (!file)
+			{
+				LogWarning("Failed to write pipeline cache %s", tempFilePath.c_str());
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFilePath, filePath, error);
+		if (error)
+		{
+			LogWarning("Failed to replace pipeline cache %s: %s", filePath.c_str(), error.message().c_str());
+			return;
+		}
+
+		savedSize = dataSize;
+	}
+
+	bool VulkanPipelineCache::IsCompatible(const std::vector<char>& data) const
+	{
+		VkPipelineCacheHeaderVersionOne header;
+		if (data.size() < sizeof(header))
+		{
+			return false;
+		}
+		memcpy(&header, data.data(), sizeof(header));
+
+		return header.headerSize >= sizeof(header)
+			&& header.headerSize <= data.size()
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == deviceProperties.vendorID
+			&& header.deviceID == deviceProperties.deviceID
+			&& memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+}
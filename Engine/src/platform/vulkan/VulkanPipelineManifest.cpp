@@ -0,0 +1,205 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanPipelineManifest.h"
+#include "platform/vulkan/VulkanShaderModule.h"
+
+#include "core/Logger.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <type_traits>
+
+namespace FGEngine
+{
+	// bounds the list lengths read from the file, so a corrupt count cannot turn into a huge allocation
+	static constexpr size_t MaxListLength = 64;
+
+	// enums go through uint32_t, reading them directly would need an operator>> per type
+	template<typename T>
+	static bool ReadValue(std::istream& stream, T& value)
+	{
+		if constexpr (std::is_enum_v<T>)
+		{
+			uint32_t raw;
+			if (!(stream >> raw)) return false;
+			value = static_cast<T>(raw);
+		}
+		else
+		{
+			if (!(stream >> value)) return false;
+		}
+		return true;
+	}
+
+	template<typename T>
+	static void WriteValue(std::ostream& stream, const T& value)
+	{
+		if constexpr (std::is_enum_v<T>)
+		{
+			stream << ' ' << static_cast<uint32_t>(value);
+		}
+		else
+		{
+			stream << ' ' << value;
+		}
+	}
+
+	bool VulkanPipelineManifest::Save(const std::string& filePath, const std::vector<VulkanPipelineState>& states)
+	{
+		// same as the pipeline cache, a crash mid-write keeps the previous manifest
+		std::string tempFilePath = filePath + ".tmp";
+		{
+			std::ofstream file(tempFilePath, std::ios::trunc);
+			file << "FGPipelineManifest " << Version << '\n';
+
+			for (const VulkanPipelineState& state : states)
+			{
+				file << std::hex << std::setw(16) << std::setfill('0') << state.PersistentHash() << std::dec << ' ';
+				file << std::quoted(state.vertexShaderModule->GetFilename()) << ' ' << std::quoted(state.fragmentShaderModule->GetFilename());
+
+				WriteValue(file, state.vertexBindings.size());
+				for (const VkVertexInputBindingDescription& binding : state.vertexBindings)
+				{
+					WriteValue(file, binding.binding);
+					WriteValue(file, binding.stride);
+					WriteValue(file, binding.inputRate);
+				}
+				WriteValue(file, state.vertexAttributes.size());
+				for (const VkVertexInputAttributeDescription& attribute : state.vertexAttributes)
+				{
+					WriteValue(file, attribute.location);
+					WriteValue(file, attribute.binding);
+					WriteValue(file, attribute.format);
+					WriteValue(file, attribute.offset);
+				}
+				WriteValue(file, state.topology);
+
+				WriteValue(file, state.polygonMode);
+				WriteValue(file, state.cullMode);
+				WriteValue(file, state.frontFace);
+
+				WriteValue(file, state.bDepthTest);
+				WriteValue(file, state.bDepthWrite);
+				WriteValue(file, state.depthCompareOp);
+
+				WriteValue(file, state.bBlend);
+				WriteValue(file, state.srcColorBlendFactor);
+				WriteValue(file, state.dstColorBlendFactor);
+				WriteValue(file, state.colorBlendOp);
+				WriteValue(file, state.srcAlphaBlendFactor);
+				WriteValue(file, state.dstAlphaBlendFactor);
+				WriteValue(file, state.alphaBlendOp);
+				WriteValue(file, state.colorWriteMask);
+
+				WriteValue(file, state.msaaSamples);
+
+				WriteValue(file, state.descriptorSetLayouts.size());
+
+				WriteValue(file, state.pushConstantRanges.size());
+				for (const VkPushConstantRange& range : state.pushConstantRanges)
+				{
+					WriteValue(file, range.stageFlags);
+					WriteValue(file, range.offset);
+					WriteValue(file, range.size);
+				}
+				WriteValue(file, state.subpass);
+				file << '\n';
+			}
+
+			if (!file)
+			{
+				LogWarning("Failed to write pipeline manifest %s", tempFilePath.c_str());
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFilePath, filePath, error);
+		if (error)
+		{
+			LogWarning("Failed to replace pipeline manifest %s: %s", filePath.c_str(), error.message().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	std::vector<VulkanPipelineManifestEntry> VulkanPipelineManifest::Load(const std::string& filePath)
+	{
+		std::vector<VulkanPipelineManifestEntry> entries;
+
+		std::ifstream file(filePath);
+		if (!file.is_open())
+		{
+			return entries;
+		}
+
+		std::string magic;
+		uint32_t version = 0;
+		if (!(file >> magic >> version) || magic != "FGPipelineManifest" || version != Version)
+		{
+			LogWarning("Ignoring pipeline manifest %s, unknown format or version", filePath.c_str());
+			return entries;
+		}
+
+		std::string line;
+		std::getline(file, line);
+		while (std::getline(file, line))
+		{
+			if (line.empty()) continue;
+
+			std::istringstream stream(line);
+			VulkanPipelineManifestEntry entry;
+			VulkanPipelineState& state = entry.state;
+
+			bool bValid = static_cast<bool>(stream >> std::hex >> entry.persistentHash >> std::dec);
+			bValid = bValid && static_cast<bool>(stream >> std::quoted(entry.vertexShaderFilename) >> std::quoted(entry.fragmentShaderFilename));
+
+			size_t count = 0;
+			bValid = bValid && ReadValue(stream, count) && count <= MaxListLength;
+			state.vertexBindings.resize(bValid ? count : 0);
+			for (VkVertexInputBindingDescription& binding : state.vertexBindings)
+			{
+				bValid = bValid && ReadValue(stream, binding.binding) && ReadValue(stream, binding.stride) && ReadValue(stream, binding.inputRate);
+			}
+			bValid = bValid && ReadValue(stream, count) && count <= MaxListLength;
+			state.vertexAttributes.resize(bValid ? count : 0);
+			for (VkVertexInputAttributeDescription& attribute : state.vertexAttributes)
+			{
+				bValid = bValid && ReadValue(stream, attribute.location) && ReadValue(stream, attribute.binding) && ReadValue(stream, attribute.format) && ReadValue(stream, attribute.offset);
+			}
+			bValid = bValid && ReadValue(stream, state.topology);
+
+			bValid = bValid && ReadValue(stream, state.polygonMode) && ReadValue(stream, state.cullMode) && ReadValue(stream, state.frontFace);
+
+			bValid = bValid && ReadValue(stream, state.bDepthTest) && ReadValue(stream, state.bDepthWrite) && ReadValue(stream, state.depthCompareOp);
+
+			bValid = bValid && ReadValue(stream, state.bBlend)
+				&& ReadValue(stream, state.srcColorBlendFactor) && ReadValue(stream, state.dstColorBlendFactor) && ReadValue(stream, state.colorBlendOp)
+				&& ReadValue(stream, state.srcAlphaBlendFactor) && ReadValue(stream, state.dstAlphaBlendFactor) && ReadValue(stream, state.alphaBlendOp)
+				&& ReadValue(stream, state.colorWriteMask);
+
+			bValid = bValid && ReadValue(stream, state.msaaSamples);
+
+			bValid = bValid && ReadValue(stream, count) && count <= MaxListLength;
+			state.descriptorSetLayouts.resize(bValid ? count : 0, VK_NULL_HANDLE);
+
+			bValid = bValid && ReadValue(stream, count) && count <= MaxListLength;
+			state.pushConstantRanges.resize(bValid ? count : 0);
+			for (VkPushConstantRange& range : state.pushConstantRanges)
+			{
+				bValid = bValid && ReadValue(stream, range.stageFlags) && ReadValue(stream, range.offset) && ReadValue(stream, range.size);
+			}
+			bValid = bValid && ReadValue(stream, state.subpass);
+
+			if (!bValid)
+			{
+				LogWarning("Skipping malformed pipeline manifest entry in %s", filePath.c_str());
+				continue;
+			}
+			entries.push_back(std::move(entry));
+		}
+
+		return entries;
+	}
+}
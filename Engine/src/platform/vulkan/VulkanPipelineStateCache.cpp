@@ -0,0 +1,177 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanPipelineStateCache.h"
+
+#include "core/Logger.h"
+#include "core/JobSystem.h"
+
+#include <chrono>
+
+namespace FGEngine
+{
+	VulkanPipelineStateCache::VulkanPipelineStateCache(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t compileThreadCount)
+	{
+		logicalDevice = inLogicalDevice;
+
+		compileThreads.reserve(compileThreadCount);
+		for (uint32_t i = 0; i < compileThreadCount; i++)
+		{
+			compileThreads.emplace_back(&VulkanPipelineStateCache::CompileLoop, this);
+		}
+	}
+
+	VulkanPipelineStateCache::~VulkanPipelineStateCache()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			bStopping = true;
+			// nobody is left to draw with them
+			compileQueue.clear();
+		}
+		queueNotEmpty.notify_all();
+
+		for (std::thread& compileThread : compileThreads)
+		{
+			compileThread.join();
+		}
+	}
+
+	std::shared_ptr<VulkanPipeline> VulkanPipelineStateCache::GetOrCreate(const VulkanPipelineState& state)
+	{
+		std::shared_ptr<Entry> entry = FindOrInsert(state);
+		if (!entry->bReady)
+		{
+			// waits instead when a compile thread is already on it
+			Compile(state, *entry, false);
+		}
+
+		return entry->pipeline;
+	}
+
+	std::shared_ptr<VulkanPipeline> VulkanPipelineStateCache::Request(const VulkanPipelineState& state)
+	{
+		std::shared_ptr<Entry> entry = FindOrInsert(state);
+		if (entry->bReady)
+		{
+			return entry->pipeline;
+		}
+
+		if (compileThreads.empty())
+		{
+			Compile(state, *entry, false);
+			return entry->pipeline;
+		}
+
+		if (!entry->bQueued.exchange(true))
+		{
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				compileQueue.push_back({ state, entry });
+			}
+			queueNotEmpty.notify_one();
+		}
+		return nullptr;
+	}
+
+	void VulkanPipelineStateCache::Precreate(const std::vector<VulkanPipelineState>& states, JobSystem& jobSystem)
+	{
+		jobSystem.ParallelFor(static_cast<uint32_t>(states.size()),
+			[this, &states](uint32_t index)
+			{
+				std::shared_ptr<Entry> entry = FindOrInsert(states[index]);
+				if (!entry->bReady)
+				{
+					Compile(states[index], *entry, true);
+				}
+			});
+	}
+
+	size_t VulkanPipelineStateCache::GetPipelineCount() const
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		return entries.size();
+	}
+
+	std::vector<VulkanPipelineState> VulkanPipelineStateCache::GetCompiledStates() const
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+
+		std::vector<VulkanPipelineState> states;
+		states.reserve(entries.size());
+		for (const auto& [state, entry] : entries)
+		{
+			if (entry->bReady)
+			{
+				states.push_back(state);
+			}
+		}
+		return states;
+	}
+
+	std::shared_ptr<VulkanPipelineStateCache::Entry> VulkanPipelineStateCache::FindOrInsert(const VulkanPipelineState& state)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(mutex);
+			auto it = entries.find(state);
+			if (it != entries.end())
+			{
+				return it->second;
+			}
+		}
+
+		std::unique_lock<std::shared_mutex> lock(mutex);
+		// another thread may have inserted it between the two locks
+		auto [it, bInserted] = entries.try_emplace(state, nullptr);
+		if (bInserted)
+		{
+			it->second = std::make_shared<Entry>();
+			it->second->id = static_cast<uint32_t>(entries.size() - 1);
+		}
+		return it->second;
+	}
+
+	void VulkanPipelineStateCache::Compile(const VulkanPipelineState& state, Entry& entry, bool bBackground)
+	{
+		std::call_once(entry.created,
+			[this, &state, &entry, bBackground]()
+			{
+				auto startTime = std::chrono::steady_clock::now();
+				entry.pipeline = std::make_shared<VulkanPipeline>(logicalDevice, state, entry.id);
+				double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+				// the persistent hash identifies the permutation across runs, it is what the manifest stores
+				unsigned long long stateHash = state.PersistentHash();
+				if (bBackground)
+				{
+					LogInfo("Pipeline %u (state %016llx) compiled in the background in %.2f ms", entry.id, stateHash, compileMs);
+				}
+				else if (compileMs > HitchThresholdMs)
+				{
+					LogWarning("Pipeline %u (state %016llx) compiled on the calling thread in %.2f ms", entry.id, stateHash, compileMs);
+				}
+				else
+				{
+					LogInfo("Pipeline %u (state %016llx) compiled in %.2f ms", entry.id, stateHash, compileMs);
+				}
+
+				entry.bReady = true;
+			});
+	}
+
+	void VulkanPipelineStateCache::CompileLoop()
+	{
+		while (true)
+		{
+			CompileJob job;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queueNotEmpty.wait(lock, [this]() { return bStopping || !compileQueue.empty(); });
+				if (bStopping) return;
+
+				job = std::move(compileQueue.front());
+				compileQueue.pop_front();
+			}
+
+			Compile(job.state, *job.entry, true);
+		}
+	}
+}
@@ -0,0 +1,843 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanRenderGraph.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanGpuProfiler.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+#include <algorithm>
+
+namespace FGEngine
+{
+#pragma region Helpers
+	static constexpr VkAccessFlags WriteAccessMask =
+		VK_ACCESS_SHADER_WRITE_BIT |
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT |
+		VK_ACCESS_HOST_WRITE_BIT |
+		VK_ACCESS_MEMORY_WRITE_BIT;
+
+	template <typename T>
+	static uint64_t ToKey(T handle)
+	{
+		// non-dispatchable handles are pointers on 64 bit and integers on 32 bit
+		return (uint64_t)handle;
+	}
+
+	static VkImage CreateTransientImage(VkDevice device, VkExtent2D extent, const VulkanGraphImageDesc& desc)
+	{
+		VkImageCreateInfo imageCreateInfo{};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.extent.width = extent.width;
+		imageCreateInfo.extent.height = extent.height;
+		imageCreateInfo.extent.depth = 1;
+		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.format = desc.format;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageCreateInfo.usage = desc.usage;
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageCreateInfo.samples = desc.samples;
+
+		VkImage image;
+		VkResult result = vkCreateImage(device, &imageCreateInfo, VulkanUtil::GetAllocationCallbacks(), &image);
+		Check(result == VK_SUCCESS, "Failed to create render graph image. Vulkan error: %d", result);
+		return image;
+	}
+#pragma endregion
+
+#pragma region VulkanRenderGraphBuilder
+	void VulkanRenderGraphBuilder::WriteColor(VulkanGraphImage image, VkAttachmentLoadOp loadOp, VkClearColorValue clearColor)
+	{
+		VulkanRenderGraph::Pass& pass = graph.passes[passIndex];
+		Check(pass.bGraphics, "Render graph pass %s writes a color attachment but is not a graphics pass", pass.name.c_str());
+
+		VulkanRenderGraph::Attachment attachment;
+		attachment.resource = image.index;
+		attachment.loadOp = loadOp;
+		attachment.clearValue.color = clearColor;
+		pass.colors.push_back(attachment);
+
+		bool bLoad = loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+		VulkanGraphAccess access;
+		access.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		access.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (bLoad ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : 0);
+		access.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		pass.uses.push_back({ image.index, access, bLoad, true });
+	}
+
+	void VulkanRenderGraphBuilder::WriteDepth(VulkanGraphImage image, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearDepth)
+	{
+		VulkanRenderGraph::Pass& pass = graph.passes[passIndex];
+		Check(pass.bGraphics, "Render graph pass %s writes a depth attachment but is not a graphics pass", pass.name.c_str());
+		Check(pass.depth.resource == UINT32_MAX, "Render graph pass %s writes more than one depth attachment", pass.name.c_str());
+
+		pass.depth.resource = image.index;
+		pass.depth.loadOp = loadOp;
+		pass.depth.clearValue.depthStencil = clearDepth;
+
+		// the depth test reads whatever the load op leaves behind
+		VulkanGraphAccess access;
+		access.stage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		access.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		access.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		pass.uses.push_back({ image.index, access, loadOp == VK_ATTACHMENT_LOAD_OP_LOAD, true });
+	}
+
+	void VulkanRenderGraphBuilder::ResolveColor(VulkanGraphImage image)
+	{
+		VulkanRenderGraph::Pass& pass = graph.passes[passIndex];
+		Check(pass.resolves.size() < pass.colors.size(), "Render graph pass %s resolves more color attachments than it writes", pass.name.c_str());
+
+		pass.resolves.push_back(image.index);
+
+		VulkanGraphAccess access;
+		access.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		access.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		access.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		pass.uses.push_back({ image.index, access, false, true });
+	}
+
+	void VulkanRenderGraphBuilder::ReadImage(VulkanGraphImage image, VkPipelineStageFlags stage)
+	{
+		VulkanGraphAccess access;
+		access.stage = stage;
+		access.access = VK_ACCESS_SHADER_READ_BIT;
+		access.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		graph.passes[passIndex].uses.push_back({ image.index, access, true, false });
+	}
+
+	void VulkanRenderGraphBuilder::ReadBuffer(VulkanGraphBuffer buffer, VkPipelineStageFlags stage, VkAccessFlags access)
+	{
+		graph.passes[passIndex].uses.push_back({ buffer.index, { stage, access, VK_IMAGE_LAYOUT_UNDEFINED }, true, false });
+	}
+
+	void VulkanRenderGraphBuilder::WriteBuffer(VulkanGraphBuffer buffer, VkPipelineStageFlags stage, VkAccessFlags access)
+	{
+		graph.passes[passIndex].uses.push_back({ buffer.index, { stage, access, VK_IMAGE_LAYOUT_UNDEFINED }, false, true });
+	}
+
+	void VulkanRenderGraphBuilder::CopyFromImage(VulkanGraphImage image)
+	{
+		VulkanGraphAccess access;
+		access.stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		access.access = VK_ACCESS_TRANSFER_READ_BIT;
+		access.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		graph.passes[passIndex].uses.push_back({ image.index, access, true, false });
+	}
+
+	void VulkanRenderGraphBuilder::UseSecondaryCommandBuffers()
+	{
+		graph.passes[passIndex].bSecondary = true;
+	}
+
+	void VulkanRenderGraphBuilder::SetSideEffects()
+	{
+		graph.passes[passIndex].bSideEffects = true;
+	}
+#pragma endregion
+
+#pragma region VulkanRenderGraph
+	VulkanRenderGraph::VulkanRenderGraph(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice)
+	{
+		logicalDevice = inLogicalDevice;
+	}
+
+	VulkanRenderGraph::~VulkanRenderGraph()
+	{
+		RetireExtentResources();
+
+		std::vector<VkRenderPass> renderPasses;
+		for (const Pass& pass : passes)
+		{
+			if (pass.renderPass != VK_NULL_HANDLE) renderPasses.push_back(pass.renderPass);
+		}
+
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), renderPasses = std::move(renderPasses)]()
+			{
+				for (VkRenderPass renderPass : renderPasses)
+				{
+					vkDestroyRenderPass(device, renderPass, VulkanUtil::GetAllocationCallbacks());
+				}
+			});
+	}
+
+	VulkanGraphImage VulkanRenderGraph::CreateImage(const std::string& name, const VulkanGraphImageDesc& desc)
+	{
+		Check(!bCompiled, "Render graph image %s created after Compile()", name.c_str());
+
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		resources.push_back(std::move(resource));
+		return { static_cast<uint32_t>(resources.size() - 1) };
+	}
+
+	VulkanGraphImage VulkanRenderGraph::ImportImage(const std::string& name, const VulkanGraphImageDesc& desc, const VulkanGraphAccess& initial, VkImageLayout finalLayout)
+	{
+		Check(!bCompiled, "Render graph image %s imported after Compile()", name.c_str());
+
+		Resource resource;
+		resource.name = name;
+		resource.bImported = true;
+		resource.desc = desc;
+		resource.initial = initial;
+		resource.finalLayout = finalLayout;
+		resources.push_back(std::move(resource));
+		return { static_cast<uint32_t>(resources.size() - 1) };
+	}
+
+	VulkanGraphBuffer VulkanRenderGraph::ImportBuffer(const std::string& name, VkPipelineStageFlags finalStage, VkAccessFlags finalAccess)
+	{
+		Check(!bCompiled, "Render graph buffer %s imported after Compile()", name.c_str());
+
+		// host writes are made visible by the submission, nothing to wait for before the first pass
+		Resource resource;
+		resource.name = name;
+		resource.bImage = false;
+		resource.bImported = true;
+		resource.initial.stage = 0;
+		resource.finalStage = finalStage;
+		resource.finalAccess = finalAccess;
+		resources.push_back(std::move(resource));
+		return { static_cast<uint32_t>(resources.size() - 1) };
+	}
+
+	void VulkanRenderGraph::AddGraphicsPass(const std::string& name, const std::function<void(VulkanRenderGraphBuilder&)>& setup, VulkanGraphExecute&& execute)
+	{
+		AddPass(name, true, setup, std::move(execute));
+	}
+
+	void VulkanRenderGraph::AddComputePass(const std::string& name, const std::function<void(VulkanRenderGraphBuilder&)>& setup, VulkanGraphExecute&& execute)
+	{
+		AddPass(name, false, setup, std::move(execute));
+	}
+
+	void VulkanRenderGraph::AddPass(const std::string& name, bool bGraphics, const std::function<void(VulkanRenderGraphBuilder&)>& setup, VulkanGraphExecute&& execute)
+	{
+		Check(!bCompiled, "Render graph pass %s added after Compile()", name.c_str());
+
+		Pass pass;
+		pass.name = name;
+		pass.bGraphics = bGraphics;
+		pass.execute = std::move(execute);
+		passes.push_back(std::move(pass));
+
+		VulkanRenderGraphBuilder builder(*this, static_cast<uint32_t>(passes.size() - 1));
+		setup(builder);
+	}
+
+	void VulkanRenderGraph::Compile()
+	{
+		Check(!bCompiled, "Render graph compiled twice");
+
+		CullPasses();
+		AssignAliasGroups();
+		PlanBarriers();
+
+		uint32_t livePassCount = 0;
+		for (Pass& pass : passes)
+		{
+			if (pass.bCulled) continue;
+
+			livePassCount++;
+			if (pass.bGraphics)
+			{
+				CreateRenderPass(pass);
+			}
+		}
+
+		bCompiled = true;
+		LogInfo("Render graph compiled, %u of %zu passes live, transient images in %u alias groups", livePassCount, passes.size(), aliasGroupCount);
+	}
+
+	void VulkanRenderGraph::Resize(VkExtent2D inExtent)
+	{
+		Check(bCompiled, "Render graph resized before Compile()");
+
+		RetireExtentResources();
+		extent = inExtent;
+
+		VkDevice device = *logicalDevice;
+		VulkanMemoryAllocator& allocator = logicalDevice->GetAllocator();
+
+		// one allocation per alias group, as large as its largest image. images of a group that can't share
+		// a memory type end up in an allocation of their own
+		struct Slot
+		{
+			VkMemoryRequirements requirements;
+			std::vector<uint32_t> members;
+		};
+
+		VkDeviceSize unaliasedBytes = 0;
+		VkDeviceSize aliasedBytes = 0;
+		for (uint32_t group = 0; group < aliasGroupCount; group++)
+		{
+			std::vector<Slot> slots;
+			for (uint32_t index = 0; index < resources.size(); index++)
+			{
+				Resource& resource = resources[index];
+				if (resource.aliasGroup != group) continue;
+
+				resource.image = CreateTransientImage(device, extent, resource.desc);
+
+				VkMemoryRequirements requirements;
+				vkGetImageMemoryRequirements(device, resource.image, &requirements);
+				unaliasedBytes += requirements.size;
+
+				auto slot = std::find_if(slots.begin(), slots.end(),
+					[&](const Slot& slot) { return (slot.requirements.memoryTypeBits & requirements.memoryTypeBits) != 0; });
+				if (slot == slots.end())
+				{
+					slots.push_back({ requirements, { index } });
+					continue;
+				}
+
+				slot->requirements.size = std::max(slot->requirements.size, requirements.size);
+				slot->requirements.alignment = std::max(slot->requirements.alignment, requirements.alignment);
+				slot->requirements.memoryTypeBits &= requirements.memoryTypeBits;
+				slot->members.push_back(index);
+			}
+
+			for (const Slot& slot : slots)
+			{
+				// recreated on resize, a dedicated allocation avoids churning the shared blocks
+				VulkanAllocation allocation = allocator.Allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, EVulkanResourceTiling::Optimal, true);
+				aliasedBytes += slot.requirements.size;
+
+				for (uint32_t index : slot.members)
+				{
+					Resource& resource = resources[index];
+					VkResult result = vkBindImageMemory(device, resource.image, allocation.memory, allocation.offset);
+					Check(result == VK_SUCCESS, "Failed to bind render graph image %s. Vulkan error: %d", resource.name.c_str(), result);
+
+					resource.imageView = VulkanUtil::CreateImageView(logicalDevice, resource.image, resource.desc.format, resource.desc.aspect, 1);
+				}
+				aliasAllocations.push_back(allocation);
+			}
+		}
+
+		LogInfo("Render graph transient images at %ux%u take %llu bytes, %llu without aliasing", extent.width, extent.height, aliasedBytes, unaliasedBytes);
+	}
+
+	void VulkanRenderGraph::SetImage(VulkanGraphImage image, VkImage vkImage, VkImageView vkImageView)
+	{
+		Resource& resource = resources[image.index];
+		Check(resource.bImported && resource.bImage, "Render graph resource %s is not an imported image", resource.name.c_str());
+
+		resource.image = vkImage;
+		resource.imageView = vkImageView;
+	}
+
+	void VulkanRenderGraph::SetBuffer(VulkanGraphBuffer buffer, VkBuffer vkBuffer)
+	{
+		Resource& resource = resources[buffer.index];
+		Check(resource.bImported && !resource.bImage, "Render graph resource %s is not an imported buffer", resource.name.c_str());
+
+		resource.buffer = vkBuffer;
+	}
+
+	void VulkanRenderGraph::SetClearValue(VulkanGraphImage image, const VkClearValue& clearValue)
+	{
+		for (Pass& pass : passes)
+		{
+			for (Attachment& color : pass.colors)
+			{
+				if (color.resource == image.index) color.clearValue = clearValue;
+			}
+			if (pass.depth.resource == image.index) pass.depth.clearValue = clearValue;
+		}
+	}
+
+	void VulkanRenderGraph::Execute(VkCommandBuffer commandBuffer, VulkanGpuProfiler* profiler)
+	{
+		Check(bCompiled && extent.width > 0, "Render graph executed before Compile() and Resize()");
+
+		for (const Pass& pass : passes)
+		{
+			if (pass.bCulled) continue;
+
+			RecordBarriers(commandBuffer, pass.barriers);
+
+			VulkanGraphContext context;
+			context.commandBuffer = commandBuffer;
+			context.extent = extent;
+
+			// after the barriers, waiting for earlier passes is not counted against this one
+			uint32_t scope = profiler ? profiler->BeginScope(commandBuffer, pass.name, true) : UINT32_MAX;
+
+			if (!pass.bGraphics)
+			{
+				pass.execute(context);
+				if (profiler) profiler->EndScope(commandBuffer, scope);
+				continue;
+			}
+
+			context.renderPass = pass.renderPass;
+			context.framebuffer = GetFramebuffer(pass);
+
+			// in attachment order, resolves are never cleared
+			std::vector<VkClearValue> clearValues;
+			for (const Attachment& color : pass.colors)
+			{
+				clearValues.push_back(color.clearValue);
+			}
+			if (pass.depth.resource != UINT32_MAX)
+			{
+				clearValues.push_back(pass.depth.clearValue);
+			}
+
+			VkRenderPassBeginInfo renderPassBeginInfo{};
+			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+			renderPassBeginInfo.renderPass = context.renderPass;
+			renderPassBeginInfo.framebuffer = context.framebuffer;
+			renderPassBeginInfo.renderArea.offset = { 0,0 };
+			renderPassBeginInfo.renderArea.extent = extent;
+			renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+			renderPassBeginInfo.pClearValues = clearValues.data();
+
+			vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, pass.bSecondary ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+			pass.execute(context);
+			vkCmdEndRenderPass(commandBuffer);
+			if (profiler) profiler->EndScope(commandBuffer, scope);
+		}
+
+		RecordBarriers(commandBuffer, finalBarriers);
+	}
+
+	VkRenderPass VulkanRenderGraph::GetRenderPass(const std::string& passName) const
+	{
+		for (const Pass& pass : passes)
+		{
+			if (pass.name == passName) return pass.renderPass;
+		}
+		return VK_NULL_HANDLE;
+	}
+
+	void VulkanRenderGraph::CullPasses()
+	{
+		// walking backwards, a resource is needed while a live pass after this point reads it before overwriting it.
+		// imported resources are read by whoever comes after the frame
+		std::vector<bool> needed(resources.size());
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			needed[i] = resources[i].bImported;
+		}
+
+		for (size_t passIndex = passes.size(); passIndex-- > 0;)
+		{
+			Pass& pass = passes[passIndex];
+
+			bool bLive = pass.bSideEffects;
+			for (const Use& use : pass.uses)
+			{
+				bLive |= use.bWrite && needed[use.resource];
+			}
+
+			pass.bCulled = !bLive;
+			if (!bLive)
+			{
+				LogInfo("Render graph pass %s culled, nothing reads its output", pass.name.c_str());
+				continue;
+			}
+
+			for (const Use& use : pass.uses)
+			{
+				if (use.bWrite && !use.bRead) needed[use.resource] = false;
+			}
+			for (const Use& use : pass.uses)
+			{
+				if (use.bRead) needed[use.resource] = true;
+			}
+		}
+	}
+
+	void VulkanRenderGraph::AssignAliasGroups()
+	{
+		std::vector<uint32_t> transients;
+		for (uint32_t passIndex = 0; passIndex < passes.size(); passIndex++)
+		{
+			if (passes[passIndex].bCulled) continue;
+
+			for (const Use& use : passes[passIndex].uses)
+			{
+				Resource& resource = resources[use.resource];
+				if (resource.bImported) continue;
+
+				if (resource.firstPass == UINT32_MAX)
+				{
+					resource.firstPass = passIndex;
+					transients.push_back(use.resource);
+				}
+				resource.lastPass = passIndex;
+			}
+		}
+
+		// first fit in order of first use, an image moves into the memory of one whose last use came before its first
+		std::vector<uint32_t> groupHeads;
+		std::vector<uint32_t> groupTails;
+		for (uint32_t index : transients)
+		{
+			Resource& resource = resources[index];
+
+			auto tail = std::find_if(groupTails.begin(), groupTails.end(),
+				[&](uint32_t tailIndex) { return resources[tailIndex].lastPass < resource.firstPass; });
+			if (tail == groupTails.end())
+			{
+				resource.aliasGroup = static_cast<uint32_t>(groupTails.size());
+				groupHeads.push_back(index);
+				groupTails.push_back(index);
+				continue;
+			}
+
+			resource.aliasGroup = resources[*tail].aliasGroup;
+			resource.previousAlias = *tail;
+			*tail = index;
+		}
+
+		// the first image of a group takes over from the last one of the frame before
+		for (size_t group = 0; group < groupHeads.size(); group++)
+		{
+			resources[groupHeads[group]].previousAlias = groupTails[group];
+		}
+		aliasGroupCount = static_cast<uint32_t>(groupHeads.size());
+	}
+
+	void VulkanRenderGraph::PlanBarriers()
+	{
+		// how every transient image is left at the end of the frame, the next image in its memory waits for that
+		std::vector<ResourceState> lastStates(resources.size());
+		std::vector<Barrier> unused;
+		for (const Pass& pass : passes)
+		{
+			if (pass.bCulled) continue;
+
+			for (const Use& use : pass.uses)
+			{
+				if (resources[use.resource].bImported) continue;
+				PlanUse(use.resource, true, use, lastStates[use.resource], unused);
+			}
+		}
+
+		std::vector<ResourceState> states(resources.size());
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			const Resource& resource = resources[i];
+			ResourceState& state = states[i];
+			if (resource.bImported)
+			{
+				state.layout = resource.initial.layout;
+				state.writeStage = resource.initial.stage;
+				state.writeAccess = resource.initial.access;
+			}
+			else if (resource.previousAlias != UINT32_MAX)
+			{
+				const ResourceState& previous = lastStates[resource.previousAlias];
+				state.writeStage = previous.writeStage;
+				state.writeAccess = previous.writeAccess;
+				state.readStages = previous.readStages;
+			}
+		}
+
+		for (Pass& pass : passes)
+		{
+			pass.barriers.clear();
+			if (pass.bCulled) continue;
+
+			for (const Use& use : pass.uses)
+			{
+				PlanUse(use.resource, resources[use.resource].bImage, use, states[use.resource], pass.barriers);
+			}
+		}
+
+		finalBarriers.clear();
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			const Resource& resource = resources[i];
+			const ResourceState& state = states[i];
+			if (!resource.bImported) continue;
+
+			if (!resource.bImage)
+			{
+				if (resource.finalStage == 0 || state.writeAccess == 0) continue;
+
+				finalBarriers.push_back({ static_cast<uint32_t>(i),
+					state.writeStage, state.writeAccess,
+					resource.finalStage, resource.finalAccess,
+					VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED });
+				continue;
+			}
+
+			if (resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || resource.finalLayout == state.layout) continue;
+
+			finalBarriers.push_back({ static_cast<uint32_t>(i),
+				state.writeStage | state.readStages, state.writeAccess,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				state.layout, resource.finalLayout });
+		}
+	}
+
+	void VulkanRenderGraph::PlanUse(uint32_t resource, bool bImage, const Use& use, ResourceState& state, std::vector<Barrier>& outBarriers)
+	{
+		const VkImageLayout layout = bImage ? use.access.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		const bool bLayoutChange = bImage && state.layout != layout;
+
+		if (bLayoutChange || use.bWrite)
+		{
+			// write after read only needs the readers to finish, write after write also the earlier writes to be available
+			if (bLayoutChange || state.writeAccess != 0 || state.readStages != 0)
+			{
+				outBarriers.push_back({ resource,
+					state.writeStage | state.readStages, state.writeAccess,
+					use.access.stage, use.access.access,
+					state.layout, layout });
+			}
+
+			// a layout transition is a write of its own, later readers wait for it like for one
+			state.writeStage = use.access.stage;
+			state.writeAccess = use.access.access & WriteAccessMask;
+			state.readStages = use.bWrite ? 0 : use.access.stage;
+			state.visibleStages = use.bWrite ? 0 : use.access.stage;
+			state.visibleAccess = use.bWrite ? 0 : use.access.access;
+		}
+		else
+		{
+			// reads after a read only wait when they come at a stage that has not seen the last write yet
+			bool bVisible = (use.access.stage & ~state.visibleStages) == 0 && (use.access.access & ~state.visibleAccess) == 0;
+			if (state.writeStage != 0 && !bVisible)
+			{
+				outBarriers.push_back({ resource,
+					state.writeStage, state.writeAccess,
+					use.access.stage, use.access.access,
+					layout, layout });
+				state.visibleStages |= use.access.stage;
+				state.visibleAccess |= use.access.access;
+			}
+			state.readStages |= use.access.stage;
+		}
+
+		state.layout = layout;
+	}
+
+	void VulkanRenderGraph::CreateRenderPass(Pass& pass)
+	{
+		Check(pass.resolves.empty() || pass.resolves.size() == pass.colors.size(), "Render graph pass %s resolves only some of its color attachments", pass.name.c_str());
+
+		uint32_t passIndex = static_cast<uint32_t>(&pass - passes.data());
+		std::vector<VkAttachmentDescription> attachments;
+		auto AddAttachment = [&](uint32_t resource, VkAttachmentLoadOp loadOp, VkImageLayout layout)
+			{
+				const VulkanGraphImageDesc& desc = resources[resource].desc;
+
+				// initial and final layouts match the subpass, the graph's barriers do the transitions
+				VkAttachmentDescription description{};
+				description.format = desc.format;
+				description.samples = desc.samples;
+				description.loadOp = loadOp;
+				description.storeOp = IsReadAfter(resource, passIndex) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				description.initialLayout = layout;
+				description.finalLayout = layout;
+				attachments.push_back(description);
+
+				return VkAttachmentReference{ static_cast<uint32_t>(attachments.size() - 1), layout };
+			};
+
+		std::vector<VkAttachmentReference> colorReferences;
+		for (const Attachment& color : pass.colors)
+		{
+			colorReferences.push_back(AddAttachment(color.resource, color.loadOp, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+		}
+
+		VkAttachmentReference depthReference{};
+		if (pass.depth.resource != UINT32_MAX)
+		{
+			depthReference = AddAttachment(pass.depth.resource, pass.depth.loadOp, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+		}
+
+		std::vector<VkAttachmentReference> resolveReferences;
+		for (uint32_t resolve : pass.resolves)
+		{
+			resolveReferences.push_back(AddAttachment(resolve, VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+		}
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+		subpass.pColorAttachments = colorReferences.data();
+		subpass.pDepthStencilAttachment = pass.depth.resource != UINT32_MAX ? &depthReference : nullptr;
+		subpass.pResolveAttachments = resolveReferences.empty() ? nullptr : resolveReferences.data();
+
+		VkRenderPassCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		createInfo.pAttachments = attachments.data();
+		createInfo.subpassCount = 1;
+		createInfo.pSubpasses = &subpass;
+
+		VkResult result = vkCreateRenderPass(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &pass.renderPass);
+		Check(result == VK_SUCCESS, "Failed to create render pass of %s. Vulkan error: %d", pass.name.c_str(), result);
+	}
+
+	bool VulkanRenderGraph::IsReadAfter(uint32_t resource, uint32_t passIndex) const
+	{
+		if (resources[resource].bImported) return true;
+
+		for (uint32_t laterPass = passIndex + 1; laterPass < passes.size(); laterPass++)
+		{
+			if (passes[laterPass].bCulled) continue;
+
+			for (const Use& use : passes[laterPass].uses)
+			{
+				if (use.resource != resource) continue;
+				// overwritten before anyone reads it
+				if (!use.bRead) return false;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	VkFramebuffer VulkanRenderGraph::GetFramebuffer(const Pass& pass)
+	{
+		std::vector<VkImageView> views;
+		for (const Attachment& color : pass.colors)
+		{
+			views.push_back(resources[color.resource].imageView);
+		}
+		if (pass.depth.resource != UINT32_MAX)
+		{
+			views.push_back(resources[pass.depth.resource].imageView);
+		}
+		for (uint32_t resolve : pass.resolves)
+		{
+			views.push_back(resources[resolve].imageView);
+		}
+
+		std::vector<uint64_t> key = { ToKey(pass.renderPass) };
+		for (VkImageView view : views)
+		{
+			key.push_back(ToKey(view));
+		}
+
+		VkFramebuffer& framebuffer = framebuffers[key];
+		if (framebuffer != VK_NULL_HANDLE) return framebuffer;
+
+		VkFramebufferCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		createInfo.renderPass = pass.renderPass;
+		createInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		createInfo.pAttachments = views.data();
+		createInfo.width = extent.width;
+		createInfo.height = extent.height;
+		createInfo.layers = 1;
+
+		VkResult result = vkCreateFramebuffer(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &framebuffer);
+		Check(result == VK_SUCCESS, "Failed to create frame buffer of %s. Vulkan error: %d", pass.name.c_str(), result);
+		return framebuffer;
+	}
+
+	void VulkanRenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers) const
+	{
+		if (barriers.empty()) return;
+
+		// buffers fold into one global memory barrier, images need their own for the layout
+		VkPipelineStageFlags srcStage = 0;
+		VkPipelineStageFlags dstStage = 0;
+		VkMemoryBarrier memoryBarrier{};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+
+		for (const Barrier& barrier : barriers)
+		{
+			srcStage |= barrier.srcStage;
+			dstStage |= barrier.dstStage;
+
+			const Resource& resource = resources[barrier.resource];
+			if (!resource.bImage)
+			{
+				memoryBarrier.srcAccessMask |= barrier.srcAccess;
+				memoryBarrier.dstAccessMask |= barrier.dstAccess;
+				continue;
+			}
+
+			VkImageMemoryBarrier imageBarrier{};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = barrier.srcAccess;
+			imageBarrier.dstAccessMask = barrier.dstAccess;
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.image;
+			imageBarrier.subresourceRange.aspectMask = resource.desc.aspect;
+			imageBarrier.subresourceRange.baseMipLevel = 0;
+			imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			imageBarrier.subresourceRange.baseArrayLayer = 0;
+			imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+			imageBarriers.push_back(imageBarrier);
+		}
+
+		bool bMemoryBarrier = memoryBarrier.srcAccessMask != 0 || memoryBarrier.dstAccessMask != 0;
+		vkCmdPipelineBarrier(commandBuffer,
+			srcStage != 0 ? srcStage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			dstStage,
+			0,
+			bMemoryBarrier ? 1 : 0, bMemoryBarrier ? &memoryBarrier : nullptr,
+			0, nullptr,
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+	}
+
+	void VulkanRenderGraph::RetireExtentResources()
+	{
+		std::vector<VkImageView> imageViews;
+		std::vector<VkImage> images;
+		for (Resource& resource : resources)
+		{
+			if (resource.bImported || resource.image == VK_NULL_HANDLE) continue;
+
+			imageViews.push_back(resource.imageView);
+			images.push_back(resource.image);
+			resource.imageView = VK_NULL_HANDLE;
+			resource.image = VK_NULL_HANDLE;
+		}
+
+		std::vector<VkFramebuffer> oldFramebuffers;
+		for (const auto& [key, framebuffer] : framebuffers)
+		{
+			oldFramebuffers.push_back(framebuffer);
+		}
+		framebuffers.clear();
+
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), allocator = &logicalDevice->GetAllocator(),
+			oldFramebuffers = std::move(oldFramebuffers), imageViews = std::move(imageViews), images = std::move(images), allocations = std::move(aliasAllocations)]() mutable
+			{
+				for (VkFramebuffer framebuffer : oldFramebuffers)
+				{
+					vkDestroyFramebuffer(device, framebuffer, VulkanUtil::GetAllocationCallbacks());
+				}
+				for (VkImageView imageView : imageViews)
+				{
+					vkDestroyImageView(device, imageView, VulkanUtil::GetAllocationCallbacks());
+				}
+				for (VkImage image : images)
+				{
+					vkDestroyImage(device, image, VulkanUtil::GetAllocationCallbacks());
+				}
+				for (VulkanAllocation& allocation : allocations)
+				{
+					allocator->Free(allocation);
+				}
+			});
+		aliasAllocations.clear();
+	}
+#pragma endregion
+}
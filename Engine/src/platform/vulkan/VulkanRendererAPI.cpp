@@ -5,23 +5,36 @@
 #include "platform/vulkan/VulkanPhysicalDevice.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
 #include "platform/vulkan/VulkanSwapChain.h"
+#include "platform/vulkan/VulkanOffscreenTarget.h"
 #include "platform/vulkan/VulkanPipeline.h"
+#include "platform/vulkan/VulkanPipelineStateCache.h"
+#include "platform/vulkan/VulkanPipelineManifest.h"
 #include "platform/vulkan/VulkanCommand.h"
+#include "platform/vulkan/VulkanUploadManager.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanPipelineCache.h"
+#include "platform/vulkan/VulkanResidencyManager.h"
+#include "platform/vulkan/VulkanCullingPass.h"
+#include "platform/vulkan/VulkanGpuProfiler.h"
 #include "platform/vulkan/VulkanShaderModule.h"
-#include "platform/vulkan/VulkanImageView.h"
 #include "platform/vulkan/VulkanTextureImageView.h"
 #include "platform/vulkan/VulkanBuffer.h"
-#include "platform/vulkan/VulkanDescriptor.h"
+#include "platform/vulkan/VulkanDescriptorAllocator.h"
+#include "platform/vulkan/VulkanDescriptorLayoutCache.h"
+#include "platform/vulkan/VulkanBindlessTable.h"
 #include "platform/vulkan/VulkanUtil.h"
 
 #include "core/Logger.h"
+#include "core/JobSystem.h"
+#include "core/InputSubsystem.h"
+#include "subsystem/SubsystemManager.h"
 #include "renderer/Texture.h"
-#include "renderer/Model.h"
+#include "renderer/Mesh.h"
 #include "renderer/Shader.h"
 
-#include <chrono>
-
-#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
 
 
 namespace FGEngine
@@ -30,7 +43,12 @@ namespace FGEngine
 	VulkanRendererAPI::VulkanRendererAPI(const RendererProperties& rendererProperties)
 	{
 		nativeWindow = rendererProperties.nativeWindow;
-		Check(nativeWindow, "No window supplied!");
+		const bool bHeadless = rendererProperties.IsHeadless();
+		if (bHeadless)
+		{
+			// nothing is presented, so there is no surface and no swap chain extension to ask for
+			deviceExtensions.clear();
+		}
 
 		vulkanInstance = std::make_shared<VulkanInstance>(nativeWindow,
 			VulkanInstanceParameters
@@ -42,109 +60,185 @@ namespace FGEngine
 		physicalDevice = std::make_shared<VulkanPhysicalDevice>(vulkanInstance, deviceExtensions);
 		msaaSamples = physicalDevice->GetMaxSampleCount();
 
-		logicalDevice = std::make_shared<VulkanLogicalDevice>(vulkanInstance, physicalDevice, deviceExtensions);
-
-		swapChain = std::make_shared<VulkanSwapChain>(vulkanInstance, physicalDevice, logicalDevice, nativeWindow);
-
-		CreateRenderPass();
-
-		descriptor = std::make_shared<VulkanDescriptor>(logicalDevice, MAX_FRAMES_IN_FLIGHT);
-
-		Shader vertShader("shader/TestShaderVert.spv", Shader::EType::Vertex);
-		Shader fragShader("shader/TestShaderFrag.spv", Shader::EType::Fragment);
-
-		VulkanPipelineSetting pipelineSetting;
-		pipelineSetting.vertexShaderModule = std::make_shared<VulkanShaderModule>(logicalDevice, vertShader);
-		pipelineSetting.fragmentShaderModule = std::make_shared<VulkanShaderModule>(logicalDevice, fragShader);
-		pipelineSetting.msaaSamples = msaaSamples;
-		pipelineSetting.descriptorSetLayout = descriptor->GetSetLayout();
-		pipelineSetting.renderPass = renderPass;
-
-		graphicsPipeline = std::make_shared<VulkanPipeline>(logicalDevice, pipelineSetting);
-
-		CreateColorResources();
-		CreateDepthResources();
+		// optional, the allocator estimates budgets on its own without it
+		if (physicalDevice->IsExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME))
+		{
+			deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		}
 
-		swapChain->CreateFrameBuffers(*colorImageView, *depthImageView, renderPass);
+		logicalDevice = std::make_shared<VulkanLogicalDevice>(vulkanInstance, physicalDevice, deviceExtensions);
 
-		command = std::make_shared<VulkanCommand>(physicalDevice, logicalDevice, MAX_FRAMES_IN_FLIGHT);
+		if (bHeadless)
+		{
+			const HeadlessProperties& headless = rendererProperties.headless;
+			offscreenTarget = std::make_shared<VulkanOffscreenTarget>(logicalDevice, VkExtent2D{ headless.width, headless.height },
+				static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT), headless.bReadback);
+			LogInfo("Rendering headless at %ux%u%s", headless.width, headless.height, headless.bReadback ? " with readback" : "");
+		}
+		else
+		{
+			swapChain = std::make_shared<VulkanSwapChain>(vulkanInstance, physicalDevice, logicalDevice, nativeWindow);
+		}
 
-		LoadModel();
+		// the graph only records the culling pass when it runs on the graphics queue
+		uniformRing = std::make_shared<VulkanUniformRing>(physicalDevice, logicalDevice, MAX_FRAMES_IN_FLIGHT);
+		cullingPass = std::make_shared<VulkanCullingPass>(logicalDevice, MAX_FRAMES_IN_FLIGHT, uniformRing->GetBuffer(), sizeof(UniformBufferObject));
+		BuildRenderGraph();
 
-		CreateUniformBuffer();
+		descriptorLayoutCache = std::make_shared<VulkanDescriptorLayoutCache>(logicalDevice);
+		descriptorAllocator = std::make_shared<VulkanDescriptorAllocator>(logicalDevice, MAX_FRAMES_IN_FLIGHT);
+		if (logicalDevice->IsBindlessEnabled())
+		{
+			bindlessTable = std::make_shared<VulkanBindlessTable>(*physicalDevice, logicalDevice);
+		}
+		CreateDescriptorSetLayouts();
 
-		descriptor->CreateDescriptorSets(MAX_FRAMES_IN_FLIGHT, uniformBuffers, sizeof(UniformBufferObject), textureImageView);
+		jobSystem = std::make_shared<JobSystem>();
+		pipelineStateCache = std::make_shared<VulkanPipelineStateCache>(logicalDevice);
+		CreatePipelineStates();
+		PrecreatePipelines();
 
+		command = std::make_shared<VulkanCommand>(physicalDevice, logicalDevice, MAX_FRAMES_IN_FLIGHT, jobSystem->GetThreadCount());
+		uploadManager = std::make_shared<VulkanUploadManager>(physicalDevice, logicalDevice);
+		residencyManager = std::make_shared<VulkanResidencyManager>(logicalDevice, MAX_FRAMES_IN_FLIGHT);
+		gpuProfiler = std::make_shared<VulkanGpuProfiler>(physicalDevice, logicalDevice, MAX_FRAMES_IN_FLIGHT);
 		CreateSyncObjects();
+
+		logicalDevice->GetAllocator().LogStats();
 	}
 
 	VulkanRendererAPI::~VulkanRendererAPI()
 	{
 		vkDeviceWaitIdle(*logicalDevice);
 
+		SavePipelineManifest();
+		// background compiles still reference the render pass and descriptor layout
+		pipelineStateCache.reset();
+		shaderModules.clear();
+
 		VulkanUtil::VectorDestroy(vkDestroySemaphore, *logicalDevice, imageAvailableSemaphores, nullptr);
 		VulkanUtil::VectorDestroy(vkDestroySemaphore, *logicalDevice, renderFinishedSemaphores, nullptr);
 		VulkanUtil::VectorDestroy(vkDestroyFence, *logicalDevice, inFlightFences, nullptr);
 
-		if (model)
-		{
-			delete model;
-			model = nullptr;
-		}
-
-		VulkanUtil::VectorDestroy(vkDestroyBuffer, *logicalDevice, uniformBuffers, nullptr);
-		VulkanUtil::VectorDestroy(vkFreeMemory, *logicalDevice, uniformBuffersMemory, nullptr);
-
-
-		vkDestroyRenderPass(*logicalDevice, renderPass, nullptr);
+		materialResources.Clear();
+		meshResources.Clear();
+		textureResources.Clear();
+		buffers.Clear();
+		textures.Clear();
+		renderGraph.reset();
+		logicalDevice->GetDeletionQueue().Flush();
 	}
 
 	void VulkanRendererAPI::SetClearColor(float r, float g, float b, float a)
 	{
 		clearColor = { r,g,b,a };
+
+		VkClearValue clearValue{};
+		clearValue.color = clearColor;
+		renderGraph->SetClearValue(sceneColorImage, clearValue);
 	}
 
 	void VulkanRendererAPI::Clear() const
 	{
 	}
 
-	void VulkanRendererAPI::Render(void* nativeWindow)
+	void VulkanRendererAPI::Render(void* nativeWindow, RenderQueue& renderQueue)
 	{
 		vkWaitForFences(*logicalDevice, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
-
-		uint32_t imageIndex;
-		VkResult result = vkAcquireNextImageKHR(*logicalDevice, *swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		logicalDevice->GetDeletionQueue().Collect(inFlightFrameNumbers[currentFrame]);
+		descriptorAllocator->ResetFrame(currentFrame);
+		// the fence above has signaled, so this never waits on the GPU
+		gpuProfiler->Collect(currentFrame);
+
+		// headless, every frame in flight has its own offscreen image
+		uint32_t imageIndex = currentFrame;
+		VkResult result = VK_SUCCESS;
+		if (swapChain)
 		{
-			RecreateSwapChain();
-			return;
+			result = vkAcquireNextImageKHR(*logicalDevice, *swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				RecreateSwapChain();
+				return;
+			}
+			Check(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR, "Failed to acquire swap chain image. Vulkan error: %d", result);
 		}
-		Check(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR, "Failed to acquire swap chain image. Vulkan error: %d", result);
 
 		vkResetFences(*logicalDevice, 1, &inFlightFences[currentFrame]);
 
+		// demotions replace resources, so this has to happen before anything of the frame is recorded
+		uint64_t frameNumber = logicalDevice->GetDeletionQueue().GetCurrentFrame();
+		residencyManager->Update(frameNumber);
+
+		// pipelines created after startup are kept even if the application does not shut down cleanly
+		if (frameNumber > 0 && frameNumber % PIPELINE_CACHE_SAVE_INTERVAL == 0)
+		{
+			logicalDevice->GetPipelineCache().Save();
+			SavePipelineManifest();
+		}
+
+		ResolveMaterialPipelines();
+		SortRenderQueue(renderQueue);
+		PrepareDraws(renderQueue, frameNumber);
+
 		VkCommandBuffer commandBuffer;
 		command->GetBuffer(currentFrame, commandBuffer);
 		vkResetCommandBuffer(commandBuffer, 0);
 		RecordCommandBuffer(commandBuffer, imageIndex);
 
-		UpdateUniformBuffer(currentFrame);
+		// uploads queued since the last frame land ahead of the draw on the same queue
+		uploadManager->Flush();
+
+		// last CPU work of the frame, everything above only references the uniform slot
+		LateLatchUniformBuffer(currentFrame);
 
-		VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+		// async culling reads the latched camera, it overlaps whatever the graphics queue still has in flight.
+		// the value of the binary semaphore is ignored
+		uint64_t cullingValue = cullingPass->IsAsync() ? cullingPass->Submit(currentFrame, drawObjectCount, frameUniforms.offset) : 0;
+		uint32_t waitCount = 0;
+		VkSemaphore waitSemaphores[2];
+		uint64_t waitValues[2];
+		VkPipelineStageFlags waitStages[2];
+		if (swapChain)
+		{
+			waitSemaphores[waitCount] = imageAvailableSemaphores[currentFrame];
+			waitValues[waitCount] = 0;
+			waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		}
+		if (cullingValue > 0)
+		{
+			waitSemaphores[waitCount] = cullingPass->GetTimelineSemaphore();
+			waitValues[waitCount] = cullingValue;
+			waitStages[waitCount++] = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+		}
 		VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineSubmitInfo.waitSemaphoreValueCount = waitCount;
+		timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pNext = cullingValue > 0 ? &timelineSubmitInfo : nullptr;
+		submitInfo.waitSemaphoreCount = waitCount;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.signalSemaphoreCount = swapChain ? 1 : 0;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
 		result = vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]);
 		Check(result == VK_SUCCESS, "Failed to submit draw command buffer. Vulkan error: %d", result);
+		inFlightFrameNumbers[currentFrame] = logicalDevice->GetDeletionQueue().EndFrame();
+
+		if (!swapChain)
+		{
+			// nothing to present, the fence alone tells when the frame is done
+			currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+			return;
+		}
 
 		VkSwapchainKHR swapChains[] = { *swapChain };
 		VkPresentInfoKHR presentInfo{};
@@ -169,9 +263,39 @@ namespace FGEngine
 
 	void VulkanRendererAPI::Resize()
 	{
+		// the offscreen target keeps the resolution it was created with
+		if (!swapChain) return;
+
 		bResizeRequested = true;
 	}
 
+	bool VulkanRendererAPI::ReadLastFrame(FrameReadback& outFrame)
+	{
+		if (!offscreenTarget || !offscreenTarget->HasReadback()) return false;
+
+		// Render() moves on to the next slot after every submission
+		uint32_t lastFrame = (currentFrame + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+		if (inFlightFrameNumbers[lastFrame] == 0) return false;
+
+		// the copy's final barrier makes the buffer visible to the host once the fence signals
+		vkWaitForFences(*logicalDevice, 1, &inFlightFences[lastFrame], VK_TRUE, UINT64_MAX);
+
+		const VkExtent2D extent = offscreenTarget->GetExtent();
+		outFrame.width = extent.width;
+		outFrame.height = extent.height;
+		outFrame.pixels.resize(static_cast<size_t>(offscreenTarget->GetReadbackSize()));
+		memcpy(outFrame.pixels.data(), offscreenTarget->GetReadbackData(lastFrame), outFrame.pixels.size());
+		return true;
+	}
+
+	bool VulkanRendererAPI::GetGpuFrameStats(GpuFrameStats& outStats) const
+	{
+		if (!gpuProfiler->IsEnabled()) return false;
+
+		outStats = gpuProfiler->GetLastFrameStats();
+		return true;
+	}
+
 	std::string VulkanRendererAPI::GetName() const
 	{
 		return "Vulkan";
@@ -196,156 +320,391 @@ namespace FGEngine
 		return result;
 	}
 
-	bool VulkanRendererAPI::IsSupported()
+	Handle<Texture> VulkanRendererAPI::CreateTexture(const Texture& texture)
 	{
-		return glfwVulkanSupported();
+		VulkanTextureResource resource;
+		resource.imageView = textures.Emplace(
+			physicalDevice, logicalDevice,
+			*uploadManager,
+			texture);
+		resource.residency = RegisterResidency(resource.imageView);
+		if (bindlessTable)
+		{
+			const VulkanTextureImageView& imageView = *textures.Get(resource.imageView);
+			resource.bindlessIndex = bindlessTable->RegisterTexture(imageView, imageView.GetSampler());
+			resource.bindlessGeneration = imageView.GetGeneration();
+		}
+
+		return HandleCast<Texture>(textureResources.Insert(std::move(resource)));
 	}
 
-	void VulkanRendererAPI::CreateRenderPass()
-	{
-		VkAttachmentDescription colorAttachmentDescription{};
-		colorAttachmentDescription.format = swapChain->GetImageFormat();
-		colorAttachmentDescription.samples = msaaSamples;
-		colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference colorAttachmentRef{};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription depthAttachmentDescription{};
-		depthAttachmentDescription.format = physicalDevice->FindDepthFormat();
-		depthAttachmentDescription.samples = msaaSamples;
-		depthAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentReference depthAttachmentRef{};
-		depthAttachmentRef.attachment = 1;
-		depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		VkAttachmentDescription colorAttachmentResolve{};
-		colorAttachmentResolve.format = swapChain->GetImageFormat();
-		colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-		VkAttachmentReference colorAttachmentResolveRef{};
-		colorAttachmentResolveRef.attachment = 2;
-		colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		VkSubpassDescription subpass{};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
-		subpass.pDepthStencilAttachment = &depthAttachmentRef;
-		subpass.pResolveAttachments = &colorAttachmentResolveRef;
-
-		VkSubpassDependency dependency{};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-		std::array<VkAttachmentDescription, 3> attachments = {
-			colorAttachmentDescription,
-			depthAttachmentDescription,
-			colorAttachmentResolve
-		};
+	void VulkanRendererAPI::DestroyTexture(Handle<Texture> texture)
+	{
+		Handle<VulkanTextureResource> handle = HandleCast<VulkanTextureResource>(texture);
+		const VulkanTextureResource* resource = textureResources.Get(handle);
+		if (!resource) return;
+
+		// materials still referring to it stop drawing
+		residencyManager->Unregister(resource->residency);
+		if (bindlessTable)
+		{
+			bindlessTable->ReleaseTexture(resource->bindlessIndex);
+		}
+		textures.Remove(resource->imageView);
+		textureResources.Remove(handle);
+	}
+
+	Handle<Mesh> VulkanRendererAPI::CreateMesh(const Mesh& mesh)
+	{
+		VulkanMeshResource resource;
+		resource.vertexBuffer = buffers.Emplace(logicalDevice);
+		buffers.Get(resource.vertexBuffer)->Init(*uploadManager, mesh.GetVertices(), EBufferType::Vertex);
+
+		resource.indexBuffer = buffers.Emplace(logicalDevice);
+		buffers.Get(resource.indexBuffer)->Init(*uploadManager, mesh.GetIndices(), EBufferType::Index);
+		resource.indexCount = static_cast<uint32_t>(mesh.GetIndices().size());
+
+		// sphere around the bounding box center, loose but cheap to test
+		glm::vec3 boundsMin(FLT_MAX);
+		glm::vec3 boundsMax(-FLT_MAX);
+		for (const Vertex& vertex : mesh.GetVertices())
+		{
+			boundsMin = glm::min(boundsMin, vertex.pos);
+			boundsMax = glm::max(boundsMax, vertex.pos);
+		}
+		glm::vec3 center = mesh.GetVertices().empty() ? glm::vec3(0.0f) : (boundsMin + boundsMax) * 0.5f;
+		float radius = 0.0f;
+		for (const Vertex& vertex : mesh.GetVertices())
+		{
+			radius = std::max(radius, glm::distance(center, vertex.pos));
+		}
+		resource.boundingSphere = glm::vec4(center, radius);
 
-		VkRenderPassCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-		createInfo.pAttachments = attachments.data();
-		createInfo.subpassCount = 1;
-		createInfo.pSubpasses = &subpass;
-		createInfo.dependencyCount = 1;
-		createInfo.pDependencies = &dependency;
+		resource.vertexResidency = RegisterResidency(resource.vertexBuffer);
+		resource.indexResidency = RegisterResidency(resource.indexBuffer);
 
-		VkResult result = vkCreateRenderPass(*logicalDevice, &createInfo, nullptr, &renderPass);
-		Check(result == VK_SUCCESS, "Failed to create render pass. Vulkan error: %d", result);
+		return HandleCast<Mesh>(meshResources.Insert(std::move(resource)));
+	}
 
+	void VulkanRendererAPI::DestroyMesh(Handle<Mesh> mesh)
+	{
+		Handle<VulkanMeshResource> handle = HandleCast<VulkanMeshResource>(mesh);
+		const VulkanMeshResource* resource = meshResources.Get(handle);
+		if (!resource) return;
+
+		residencyManager->Unregister(resource->vertexResidency);
+		residencyManager->Unregister(resource->indexResidency);
+		buffers.Remove(resource->vertexBuffer);
+		buffers.Remove(resource->indexBuffer);
+		meshResources.Remove(handle);
 	}
 
-	void VulkanRendererAPI::CreateColorResources()
+	Handle<Material> VulkanRendererAPI::CreateMaterial(const Material& material)
 	{
-		VulkanImageViewSetting colorImageViewSetting{};
-		colorImageViewSetting.imageFormat = swapChain->GetImageFormat();
-		colorImageViewSetting.msaaSamples = msaaSamples;
-		colorImageViewSetting.imageUsageFlags = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-		colorImageViewSetting.aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
+		Handle<VulkanTextureResource> texture = HandleCast<VulkanTextureResource>(material.texture);
+		const VulkanTextureResource* textureResource = textureResources.Get(texture);
+		Check(textureResource, "Material created with an invalid texture");
+
+		VulkanMaterialResource resource;
+		resource.texture = texture;
+		resource.pass = material.pass;
+		resource.baseColor = material.baseColor;
+		resource.pipelineState = passPipelineStates[static_cast<size_t>(material.pass)];
+		if (!material.vertexShader.empty())
+		{
+			resource.pipelineState.vertexShaderModule = LoadShaderModule(material.vertexShader, Shader::EType::Vertex);
+		}
+		if (!material.fragmentShader.empty())
+		{
+			resource.pipelineState.fragmentShaderModule = LoadShaderModule(material.fragmentShader, Shader::EType::Fragment);
+		}
+		if (material.blendMode == EBlendMode::Additive)
+		{
+			// blending in the opaque pass would depend on the order of the draws
+			Check(material.pass == ERenderPass::Transparent, "Additive material outside of the transparent pass");
+			resource.pipelineState.SetAdditiveBlend();
+		}
+		if (material.bDoubleSided)
+		{
+			resource.pipelineState.cullMode = VK_CULL_MODE_NONE;
+		}
+		resource.pipeline = pipelineStateCache->Request(resource.pipelineState);
+		resource.bPipelineReady = resource.pipeline != nullptr;
+		if (!resource.bPipelineReady)
+		{
+			resource.pipeline = fallbackPipelines[static_cast<size_t>(material.pass)];
+			pendingPipelineCount++;
+		}
 
-		colorImageView.reset();
-		colorImageView = std::make_shared<VulkanImageView>(physicalDevice, logicalDevice, swapChain, colorImageViewSetting);
+		return HandleCast<Material>(materialResources.Insert(std::move(resource)));
 	}
 
-	void VulkanRendererAPI::CreateDepthResources()
+	void VulkanRendererAPI::DestroyMaterial(Handle<Material> material)
 	{
-		VulkanImageViewSetting depthImageViewSetting{};
-		depthImageViewSetting.imageFormat = physicalDevice->FindDepthFormat();
-		depthImageViewSetting.msaaSamples = msaaSamples;
-		depthImageViewSetting.imageUsageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-		depthImageViewSetting.aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
+		Handle<VulkanMaterialResource> handle = HandleCast<VulkanMaterialResource>(material);
+		const VulkanMaterialResource* resource = materialResources.Get(handle);
+		if (!resource) return;
+
+		if (!resource->bPipelineReady)
+		{
+			pendingPipelineCount--;
+		}
 
-		depthImageView.reset();
-		depthImageView = std::make_shared<VulkanImageView>(physicalDevice, logicalDevice, swapChain, depthImageViewSetting);
+		materialResources.Remove(handle);
 	}
 
-	void VulkanRendererAPI::LoadModel()
+	bool VulkanRendererAPI::IsSupported()
 	{
-		//model = Model::GenerateQuad();
-		//Texture texture = Texture("texture/texture.jpg");
+		return glfwVulkanSupported();
+	}
 
-		model = new Model("model/viking_room/viking_room.obj");
-		model->SetTexture(Texture("model/viking_room/viking_room.png"));
+	void VulkanRendererAPI::BuildRenderGraph()
+	{
+		renderGraph = std::make_shared<VulkanRenderGraph>(logicalDevice);
+
+		VulkanGraphImageDesc colorDesc;
+		colorDesc.format = GetOutputFormat();
+		colorDesc.samples = msaaSamples;
+		colorDesc.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		colorDesc.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		sceneColorImage = renderGraph->CreateImage("SceneColor", colorDesc);
+
+		VulkanGraphImageDesc depthDesc;
+		depthDesc.format = physicalDevice->FindDepthFormat();
+		depthDesc.samples = msaaSamples;
+		depthDesc.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		depthDesc.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		VulkanGraphImage depthImage = renderGraph->CreateImage("SceneDepth", depthDesc);
+
+		VulkanGraphImageDesc outputDesc;
+		outputDesc.format = GetOutputFormat();
+		if (swapChain)
+		{
+			// acquired with a semaphore the submission waits for at color output, presented after the frame
+			VulkanGraphAccess acquired;
+			acquired.stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			outputImage = renderGraph->ImportImage("SwapChain", outputDesc, acquired, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		}
+		else
+		{
+			// the fence of its frame slot was waited for before recording, and it is resolved over completely
+			outputImage = renderGraph->ImportImage("Offscreen", outputDesc, VulkanGraphAccess{}, VK_IMAGE_LAYOUT_UNDEFINED);
+		}
 
-		textureImageView = std::make_shared<VulkanTextureImageView>(
-			physicalDevice, logicalDevice,
-			swapChain, command,
-			*model->GetTexture());
+		const bool bGraphicsCulling = !cullingPass->IsAsync();
+		if (bGraphicsCulling)
+		{
+			cullDrawBuffer = renderGraph->ImportBuffer("CullDraws");
+			cullInstanceBuffer = renderGraph->ImportBuffer("CullInstances");
+
+			// instance counts are accumulated on top of what the CPU wrote
+			renderGraph->AddComputePass("Culling",
+				[&](VulkanRenderGraphBuilder& builder)
+				{
+					builder.WriteBuffer(cullDrawBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+					builder.WriteBuffer(cullInstanceBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+				},
+				[this](const VulkanGraphContext& context)
+				{
+					cullingPass->Dispatch(context.commandBuffer, currentFrame, drawObjectCount, frameUniforms.offset);
+				});
+		}
+
+		renderGraph->AddGraphicsPass("Main",
+			[&](VulkanRenderGraphBuilder& builder)
+			{
+				builder.WriteColor(sceneColorImage, VK_ATTACHMENT_LOAD_OP_CLEAR, clearColor);
+				builder.WriteDepth(depthImage, VK_ATTACHMENT_LOAD_OP_CLEAR);
+				builder.ResolveColor(outputImage);
+				if (bGraphicsCulling)
+				{
+					builder.ReadBuffer(cullDrawBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+					builder.ReadBuffer(cullInstanceBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+				}
+				builder.UseSecondaryCommandBuffers();
+			},
+			[this](const VulkanGraphContext& context)
+			{
+				RecordMainPass(context);
+			});
 
+		if (offscreenTarget && offscreenTarget->HasReadback())
+		{
+			// ReadLastFrame() reads it on the host after the frame's fence
+			readbackBuffer = renderGraph->ImportBuffer("Readback", VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+
+			renderGraph->AddComputePass("Readback",
+				[&](VulkanRenderGraphBuilder& builder)
+				{
+					builder.CopyFromImage(outputImage);
+					builder.WriteBuffer(readbackBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+				},
+				[this](const VulkanGraphContext& context)
+				{
+					VkBufferImageCopy region{};
+					region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+					region.imageSubresource.layerCount = 1;
+					region.imageExtent = { context.extent.width, context.extent.height, 1 };
+					vkCmdCopyImageToBuffer(context.commandBuffer,
+						offscreenTarget->GetImage(currentFrame), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						offscreenTarget->GetReadbackBuffer(currentFrame), 1, &region);
+				});
+		}
 
-		std::vector<Vertex> vertices = model->GetMesh(0)->GetVertices();
-		vertexBuffer = std::make_shared<VulkanBuffer>(logicalDevice);
-		vertexBuffer->Init(physicalDevice, command, vertices, EBufferType::Vertex);
+		renderGraph->Compile();
+		renderGraph->Resize(GetOutputExtent());
+		renderPass = renderGraph->GetRenderPass("Main");
+	}
 
-		std::vector<uint32_t> indices = model->GetMesh(0)->GetIndices();
-		indexBuffer = std::make_shared<VulkanBuffer>(logicalDevice);
-		indexBuffer->Init(physicalDevice, command, indices, EBufferType::Index);
+	void VulkanRendererAPI::CreateDescriptorSetLayouts()
+	{
+		VkDescriptorSetLayoutBinding uboLayoutBinding{};
+		uboLayoutBinding.binding = 0;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		uboLayoutBinding.descriptorCount = 1;
+		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutBinding samplerLayoutBinding{};
+		samplerLayoutBinding.binding = 1;
+		samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		samplerLayoutBinding.descriptorCount = 1;
+		samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		VkDescriptorSetLayoutBinding instanceLayoutBinding{};
+		instanceLayoutBinding.binding = 2;
+		instanceLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		instanceLayoutBinding.descriptorCount = 1;
+		instanceLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+		VkDescriptorSetLayoutBinding drawLayoutBinding{};
+		drawLayoutBinding.binding = 3;
+		drawLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		drawLayoutBinding.descriptorCount = 1;
+		drawLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		materialSetLayout = bindlessTable
+			? descriptorLayoutCache->GetOrCreate({ uboLayoutBinding, instanceLayoutBinding, drawLayoutBinding })
+			: descriptorLayoutCache->GetOrCreate({ uboLayoutBinding, samplerLayoutBinding, instanceLayoutBinding, drawLayoutBinding });
 	}
 
-	void VulkanRendererAPI::CreateUniformBuffer()
+	void VulkanRendererAPI::CreatePipelineStates()
 	{
-		VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+		auto attributeDescriptions = VertexHelper::GetAttributeDescriptions();
+
+		VulkanPipelineState state;
+		state.vertexShaderModule = LoadShaderModule("shader/TestShaderVert.spv", Shader::EType::Vertex);
+		state.fragmentShaderModule = bindlessTable
+			? LoadShaderModule("shader/TestShaderBindlessFrag.spv", Shader::EType::Fragment)
+			: LoadShaderModule("shader/TestShaderFrag.spv", Shader::EType::Fragment);
+		state.vertexBindings = { VertexHelper::GetBindingDescription() };
+		state.vertexAttributes.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+		state.msaaSamples = msaaSamples;
+		// every state shares the layouts, so the bound descriptor sets survive a pipeline switch
+		state.descriptorSetLayouts = { materialSetLayout };
+		if (bindlessTable)
+		{
+			state.descriptorSetLayouts.push_back(bindlessTable->GetSetLayout());
+
+			// the texture slot is the same for every instance of a draw
+			VkPushConstantRange pushConstantRange{};
+			pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			pushConstantRange.offset = 0;
+			pushConstantRange.size = sizeof(VulkanDrawConstants);
+			state.pushConstantRanges = { pushConstantRange };
+		}
+		state.renderPass = renderPass;
 
-		uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-		uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-		uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+		passPipelineStates[static_cast<size_t>(ERenderPass::Opaque)] = state;
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		state.SetAlphaBlend();
+		passPipelineStates[static_cast<size_t>(ERenderPass::Transparent)] = state;
+
+		// blocking, but only once at startup
+		for (size_t pass = 0; pass < passPipelineStates.size(); pass++)
 		{
-			VulkanBuffer::CreateBuffer(
-				physicalDevice, logicalDevice,
-				bufferSize,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-				uniformBuffers[i], uniformBuffersMemory[i]);
+			fallbackPipelines[pass] = pipelineStateCache->GetOrCreate(passPipelineStates[pass]);
+		}
+	}
 
-			vkMapMemory(*logicalDevice, uniformBuffersMemory[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
+	void VulkanRendererAPI::PrecreatePipelines()
+	{
+		std::vector<VulkanPipelineManifestEntry> entries = VulkanPipelineManifest::Load(PIPELINE_MANIFEST_PATH);
+
+		std::vector<VulkanPipelineState> states;
+		states.reserve(entries.size());
+		for (VulkanPipelineManifestEntry& entry : entries)
+		{
+			// recorded with another sample count, it would not match the render pass
+			if (entry.state.msaaSamples != msaaSamples) continue;
+			// recorded with bindless on while it is off now, or the other way around
+			if (entry.state.descriptorSetLayouts.size() != passPipelineStates[0].descriptorSetLayouts.size()) continue;
+			if (entry.state.pushConstantRanges.size() != passPipelineStates[0].pushConstantRanges.size()) continue;
+
+			std::error_code error;
+			if (!std::filesystem::exists(entry.vertexShaderFilename, error) || !std::filesystem::exists(entry.fragmentShaderFilename, error)) continue;
+
+			VulkanPipelineState& state = entry.state;
+			state.vertexShaderModule = LoadShaderModule(entry.vertexShaderFilename, Shader::EType::Vertex);
+			state.fragmentShaderModule = LoadShaderModule(entry.fragmentShaderFilename, Shader::EType::Fragment);
+			state.descriptorSetLayouts = passPipelineStates[0].descriptorSetLayouts;
+			state.renderPass = renderPass;
+
+			// a mismatch means the entry was edited or damaged, whatever it describes now is not what was compiled
+			if (state.PersistentHash() != entry.persistentHash)
+			{
+				LogWarning("Skipping pipeline manifest entry %016llx, its state hashes to %016llx", (unsigned long long)entry.persistentHash, (unsigned long long)state.PersistentHash());
+				continue;
+			}
+			states.push_back(std::move(state));
 		}
+
+		if (states.empty()) return;
+
+		pipelineStateCache->Precreate(states, *jobSystem);
+		LogInfo("Pre-created %zu pipelines from %s", states.size(), PIPELINE_MANIFEST_PATH);
+	}
+
+	void VulkanRendererAPI::SavePipelineManifest() const
+	{
+		VulkanPipelineManifest::Save(PIPELINE_MANIFEST_PATH, pipelineStateCache->GetCompiledStates());
+	}
+
+	std::shared_ptr<VulkanShaderModule> VulkanRendererAPI::LoadShaderModule(const std::string& filename, Shader::EType type)
+	{
+		std::shared_ptr<VulkanShaderModule>& shaderModule = shaderModules[filename];
+		if (!shaderModule)
+		{
+			shaderModule = std::make_shared<VulkanShaderModule>(logicalDevice, Shader(filename, type));
+		}
+		return shaderModule;
+	}
+
+	Handle<VulkanResidentResource> VulkanRendererAPI::RegisterResidency(Handle<VulkanBuffer> buffer)
+	{
+		const VulkanAllocation& allocation = buffers.Get(buffer)->GetAllocation();
+		return residencyManager->Register({ allocation.memoryTypeIndex, allocation.size },
+			[this, buffer](VulkanResidency& residency)
+			{
+				VulkanBuffer* resource = buffers.Get(buffer);
+				if (!resource || !resource->Demote(*uploadManager)) return false;
+
+				residency = { resource->GetAllocation().memoryTypeIndex, resource->GetAllocation().size };
+				return true;
+			});
+	}
+
+	Handle<VulkanResidentResource> VulkanRendererAPI::RegisterResidency(Handle<VulkanTextureImageView> texture)
+	{
+		const VulkanAllocation& allocation = textures.Get(texture)->GetAllocation();
+		return residencyManager->Register({ allocation.memoryTypeIndex, allocation.size },
+			[this, texture](VulkanResidency& residency)
+			{
+				VulkanTextureImageView* resource = textures.Get(texture);
+				if (!resource || !resource->Demote(*uploadManager)) return false;
+
+				residency = { resource->GetAllocation().memoryTypeIndex, resource->GetAllocation().size };
+				return true;
+			});
 	}
 
 	void VulkanRendererAPI::CreateSyncObjects()
@@ -353,6 +712,7 @@ namespace FGEngine
 		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+		inFlightFrameNumbers.assign(MAX_FRAMES_IN_FLIGHT, 0);
 
 		VkSemaphoreCreateInfo semaphoreCreateInfo{};
 		semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -363,13 +723,13 @@ namespace FGEngine
 
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 		{
-			VkResult result = vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphores[i]);
+			VkResult result = vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, VulkanUtil::GetAllocationCallbacks(), &imageAvailableSemaphores[i]);
 			Check(result == VK_SUCCESS, "Failed to create image available semaphore. Vulkan error: %d", result);
 
-			result = vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, nullptr, &renderFinishedSemaphores[i]);
+			result = vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, VulkanUtil::GetAllocationCallbacks(), &renderFinishedSemaphores[i]);
 			Check(result == VK_SUCCESS, "Failed to create image render finished semaphore. Vulkan error: %d", result);
 
-			result = vkCreateFence(*logicalDevice, &fenceCreateInfo, nullptr, &inFlightFences[i]);
+			result = vkCreateFence(*logicalDevice, &fenceCreateInfo, VulkanUtil::GetAllocationCallbacks(), &inFlightFences[i]);
 			Check(result == VK_SUCCESS, "Failed to create in-flight fence. Vulkan error: %d", result);
 		}
 	}
@@ -383,32 +743,206 @@ namespace FGEngine
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(*logicalDevice);
-
 		physicalDevice->Refresh(vulkanInstance);
 
 		swapChain->Recreate(vulkanInstance, physicalDevice, nativeWindow);
 
-		CreateColorResources();
-		CreateDepthResources();
+		// render passes stay, only the attachments and frame buffers follow the extent
+		renderGraph->Resize(swapChain->GetExtent());
+	}
+
+	VkExtent2D VulkanRendererAPI::GetOutputExtent() const
+	{
+		return swapChain ? swapChain->GetExtent() : offscreenTarget->GetExtent();
+	}
+
+	VkFormat VulkanRendererAPI::GetOutputFormat() const
+	{
+		return swapChain ? swapChain->GetImageFormat() : offscreenTarget->GetImageFormat();
+	}
+
+	void VulkanRendererAPI::ResolveMaterialPipelines()
+	{
+		if (pendingPipelineCount == 0) return;
 
-		swapChain->CreateFrameBuffers(*colorImageView, *depthImageView, renderPass);
+		for (VulkanMaterialResource& material : materialResources)
+		{
+			if (material.bPipelineReady) continue;
+
+			if (std::shared_ptr<VulkanPipeline> pipeline = pipelineStateCache->Request(material.pipelineState))
+			{
+				material.pipeline = pipeline;
+				material.bPipelineReady = true;
+				pendingPipelineCount--;
+			}
+		}
 	}
 
-	void VulkanRendererAPI::UpdateUniformBuffer(uint32_t currentImage)
+	void VulkanRendererAPI::SortRenderQueue(RenderQueue& renderQueue) const
 	{
-		static auto startTime = std::chrono::high_resolution_clock::now();
+		// the camera input of this frame is only latched after recording, last frame's position is close enough for ordering
+		const glm::vec3 cameraPosition = camera.GetPosition();
+		const float farPlane = camera.GetFarPlane();
 
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+		const std::vector<RenderItem>& items = renderQueue.GetItems();
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			const RenderItem& item = items[i];
+			const VulkanMaterialResource* material = materialResources.Get(HandleCast<VulkanMaterialResource>(item.material));
+			ERenderPass pass = material ? material->pass : ERenderPass::Opaque;
+			uint32_t pipelineId = material ? material->pipeline->GetId() : 0;
 
-		UniformBufferObject ubo{};
-		ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f), glm::vec3(0, 0, 1));
-		ubo.view = glm::lookAt(glm::vec3(2, 2, 2), glm::vec3(0, 0, 0), glm::vec3(0, 0, 1));
-		ubo.projection = glm::perspective(glm::radians(45.0f), swapChain->GetExtent().width / (float)swapChain->GetExtent().height, 0.1f, 10.0f);
-		ubo.projection[1][1] *= -1; // flip y-axis
+			float depth = glm::distance(cameraPosition, glm::vec3(item.transform[3])) / farPlane;
+			renderQueue.SetSortKey(i, RenderQueue::MakeSortKey(pass, pipelineId, item.material.GetIndex(), item.mesh.GetIndex(), depth));
+		}
 
-		memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+		renderQueue.Sort();
+	}
+
+	void VulkanRendererAPI::PrepareDraws(const RenderQueue& renderQueue, uint64_t frameNumber)
+	{
+		const std::vector<RenderItem>& items = renderQueue.GetItems();
+		const std::vector<RenderQueueEntry>& entries = renderQueue.GetSortedEntries();
+
+		// every submission of the same mesh and material in a row becomes one instanced draw, except for transparent ones
+		struct Run
+		{
+			size_t begin;
+			size_t end;
+		};
+		std::vector<Run> runs;
+
+		drawBatches.clear();
+		drawObjectCount = 0;
+		for (size_t runBegin = 0, runEnd = 0; runBegin < entries.size(); runBegin = runEnd)
+		{
+			const RenderItem& item = items[entries[runBegin].itemIndex];
+			Handle<VulkanMeshResource> mesh = HandleCast<VulkanMeshResource>(item.mesh);
+			Handle<VulkanMaterialResource> material = HandleCast<VulkanMaterialResource>(item.material);
+			const VulkanMaterialResource* materialResource = materialResources.Get(material);
+
+			// the culling pass packs visible instances in any order, which would undo the back to front sort
+			const bool bInstanced = !materialResource || materialResource->pass != ERenderPass::Transparent;
+			runEnd = runBegin + 1;
+			while (bInstanced && runEnd < entries.size()
+				&& items[entries[runEnd].itemIndex].mesh == item.mesh
+				&& items[entries[runEnd].itemIndex].material == item.material)
+			{
+				runEnd++;
+			}
+
+			// resources destroyed after submission are skipped
+			if (!meshResources.Contains(mesh) || !materialResource || !textureResources.Contains(materialResource->texture)) continue;
+
+			drawBatches.push_back({ mesh, material, 0, {} });
+			runs.push_back({ runBegin, runEnd });
+			drawObjectCount += static_cast<uint32_t>(runEnd - runBegin);
+		}
+
+		cullingPass->Reserve(currentFrame, drawObjectCount, static_cast<uint32_t>(drawBatches.size()));
+
+		// the frame's uniforms and one VulkanDrawUniforms per draw, all bound through dynamic offsets.
+		// growing replaces the buffer, which is fine as every set referencing it is written below
+		uniformRing->BeginFrame(currentFrame,
+			uniformRing->GetAlignedSize(sizeof(UniformBufferObject)) + uniformRing->GetAlignedSize(sizeof(VulkanDrawUniforms)) * drawBatches.size());
+		VkBuffer uniformBuffer = uniformRing->GetBuffer();
+		frameUniforms = uniformRing->Allocate(currentFrame, sizeof(UniformBufferObject));
+		cullingPass->SetUniformBuffer(currentFrame, uniformBuffer);
+
+		// with bindless one set serves every material of the frame
+		if (bindlessTable)
+		{
+			frameDescriptorSet = descriptorAllocator->Allocate(currentFrame, materialSetLayout);
+			VulkanDescriptorWriter()
+				.WriteBuffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformBuffer, 0, sizeof(UniformBufferObject))
+				.WriteBuffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, cullingPass->GetInstanceBuffers()[currentFrame])
+				.WriteBuffer(3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformBuffer, 0, sizeof(VulkanDrawUniforms))
+				.Update(*logicalDevice, frameDescriptorSet);
+		}
+
+		// instance counts start at zero, the culling pass counts the visible instances in
+		VulkanCullObject* objects = cullingPass->GetObjects(currentFrame);
+		VkDrawIndexedIndirectCommand* draws = cullingPass->GetDraws(currentFrame);
+		uint32_t objectCount = 0;
+		for (uint32_t drawIndex = 0; drawIndex < drawBatches.size(); drawIndex++)
+		{
+			const VulkanMeshResource& mesh = *meshResources.Get(drawBatches[drawIndex].mesh);
+			VulkanMaterialResource& material = *materialResources.Get(drawBatches[drawIndex].material);
+			draws[drawIndex] = { mesh.indexCount, 0, 0, 0, objectCount };
+
+			VulkanTextureResource& texture = *textureResources.Get(material.texture);
+			const VulkanTextureImageView& imageView = *textures.Get(texture.imageView);
+			if (bindlessTable)
+			{
+				// a demoted texture is a new image, its old slot may still be read by frames in flight
+				if (texture.bindlessGeneration != imageView.GetGeneration())
+				{
+					bindlessTable->ReleaseTexture(texture.bindlessIndex);
+					texture.bindlessIndex = bindlessTable->RegisterTexture(imageView, imageView.GetSampler());
+					texture.bindlessGeneration = imageView.GetGeneration();
+				}
+			}
+			// written fresh every frame, so replaced textures and instance buffers need no tracking
+			else if (material.descriptorSetFrame != frameNumber)
+			{
+				material.descriptorSet = descriptorAllocator->Allocate(currentFrame, materialSetLayout);
+				material.descriptorSetFrame = frameNumber;
+				VulkanDescriptorWriter()
+					.WriteBuffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformBuffer, 0, sizeof(UniformBufferObject))
+					.WriteImage(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageView, imageView.GetSampler())
+					.WriteBuffer(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, cullingPass->GetInstanceBuffers()[currentFrame])
+					.WriteBuffer(3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformBuffer, 0, sizeof(VulkanDrawUniforms))
+					.Update(*logicalDevice, material.descriptorSet);
+			}
+
+			VulkanUniformAllocation drawUniforms = uniformRing->Allocate(currentFrame, sizeof(VulkanDrawUniforms));
+			static_cast<VulkanDrawUniforms*>(drawUniforms.mappedData)->baseColor = material.baseColor;
+			drawBatches[drawIndex].uniformOffset = drawUniforms.offset;
+			drawBatches[drawIndex].constants.textureIndex = texture.bindlessIndex;
+
+			// here rather than while recording, which runs on several threads
+			residencyManager->Touch(mesh.vertexResidency, frameNumber);
+			residencyManager->Touch(mesh.indexResidency, frameNumber);
+			residencyManager->Touch(texture.residency, frameNumber);
+
+			for (size_t i = runs[drawIndex].begin; i < runs[drawIndex].end; i++)
+			{
+				const RenderItem& item = items[entries[i].itemIndex];
+				objects[objectCount++] = { item.transform, item.color, mesh.boundingSphere, drawIndex };
+			}
+		}
+	}
+
+	void VulkanRendererAPI::LateLatchUniformBuffer(uint32_t currentImage)
+	{
+		// the view written below, the camera itself only ever moves by whole snapshots
+		Camera latchedCamera = camera;
+
+		// the input subsystem is registered after the window (and so the renderer) is created
+		if (InputSubsystem* inputSubsystem = SubsystemManager::Get().GetSubsystem<InputSubsystem>())
+		{
+			const InputSnapshot snapshot = inputSubsystem->GetSnapshot();
+			camera.ApplyInput(snapshot);
+			latchedCamera = camera;
+
+			// the snapshot is as old as the last ProcessQueue, the cursor is read again so a drag that went on while
+			// the frame was recorded still shows. the next snapshot carries that movement into the camera
+			if (nativeWindow && glfwGetMouseButton(nativeWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+			{
+				glm::dvec2 cursorPosition;
+				glfwGetCursorPos(nativeWindow, &cursorPosition.x, &cursorPosition.y);
+				latchedCamera.Rotate(cursorPosition - snapshot.cursorPosition);
+			}
+		}
+
+		const VkExtent2D extent = GetOutputExtent();
+		glm::mat4 view = latchedCamera.GetView();
+		glm::mat4 projection = latchedCamera.GetProjection(extent.width / (float)extent.height);
+
+		// the ring is host coherent and is not read by the GPU until the submission below, so no flush is needed
+		uint8_t* mappedData = static_cast<uint8_t*>(frameUniforms.mappedData);
+		memcpy(mappedData + offsetof(UniformBufferObject, view), &view, sizeof(view));
+		memcpy(mappedData + offsetof(UniformBufferObject, projection), &projection, sizeof(projection));
 	}
 
 	void VulkanRendererAPI::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
@@ -421,57 +955,164 @@ namespace FGEngine
 		VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 		Check(result == VK_SUCCESS, "Failed to begin recording command buffer. Vulkan error: %d", result);
 
-		std::array<VkClearValue, 2> clearValues{};
-		clearValues[0].color = clearColor;
-		clearValues[1].depthStencil = { 1.0f, 0 };
+		if (swapChain)
+		{
+			renderGraph->SetImage(outputImage, swapChain->GetImage(imageIndex), swapChain->GetImageView(imageIndex));
+		}
+		else
+		{
+			renderGraph->SetImage(outputImage, offscreenTarget->GetImage(imageIndex), offscreenTarget->GetImageView(imageIndex));
+			if (offscreenTarget->HasReadback())
+			{
+				renderGraph->SetBuffer(readbackBuffer, offscreenTarget->GetReadbackBuffer(imageIndex));
+			}
+		}
+		if (!cullingPass->IsAsync())
+		{
+			// replaced when a frame outgrows them
+			renderGraph->SetBuffer(cullDrawBuffer, cullingPass->GetDrawBuffer(currentFrame));
+			renderGraph->SetBuffer(cullInstanceBuffer, cullingPass->GetInstanceBuffers()[currentFrame]);
+		}
+
+		gpuProfiler->BeginFrame(commandBuffer, currentFrame, logicalDevice->GetDeletionQueue().GetCurrentFrame());
+		renderGraph->Execute(commandBuffer, gpuProfiler.get());
 
-		VkRenderPassBeginInfo renderPassBeginInfo{};
-		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassBeginInfo.renderPass = renderPass;
-		renderPassBeginInfo.framebuffer = swapChain->GetFrameBuffer(imageIndex);
-		renderPassBeginInfo.renderArea.offset = { 0,0 };
-		renderPassBeginInfo.renderArea.extent = swapChain->GetExtent();
-		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassBeginInfo.pClearValues = clearValues.data();
+		result = vkEndCommandBuffer(commandBuffer);
+		Check(result == VK_SUCCESS, "Failed to record command buffer. Vulkan error: %d", result);
+	}
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	void VulkanRendererAPI::RecordMainPass(const VulkanGraphContext& context)
+	{
+		// contiguous ranges of the sorted draws, recorded in parallel and executed in order
+		uint32_t drawCount = static_cast<uint32_t>(drawBatches.size());
+		uint32_t secondaryCount = std::min((drawCount + MIN_DRAWS_PER_SECONDARY - 1) / MIN_DRAWS_PER_SECONDARY, command->GetSecondaryCount());
+		uint32_t drawsPerSecondary = secondaryCount > 0 ? (drawCount + secondaryCount - 1) / secondaryCount : 0;
+
+		// a scope per secondary, reserved up front since scopes can only be added on this thread
+		std::vector<uint32_t> drawScopes(secondaryCount);
+		for (uint32_t i = 0; i < secondaryCount; i++)
 		{
-			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *graphicsPipeline);
+			uint32_t firstDraw = i * drawsPerSecondary;
+			uint32_t endDraw = std::min(firstDraw + drawsPerSecondary, drawCount);
+			drawScopes[i] = gpuProfiler->AddScope("Draws " + std::to_string(firstDraw) + "-" + std::to_string(endDraw));
+		}
 
-			VkViewport viewport{};
-			viewport.x = 0;
-			viewport.y = 0;
-			viewport.width = static_cast<float>(swapChain->GetExtent().width);
-			viewport.height = static_cast<float>(swapChain->GetExtent().height);
-			viewport.minDepth = 0.0f;
-			viewport.maxDepth = 1.0f;
+		command->ResetSecondaryBuffers(currentFrame);
+		jobSystem->ParallelFor(secondaryCount, [&](uint32_t secondaryIndex)
+			{
+				uint32_t firstDraw = secondaryIndex * drawsPerSecondary;
+				uint32_t endDraw = std::min(firstDraw + drawsPerSecondary, drawCount);
+				RecordDraws(command->GetSecondaryBuffer(currentFrame, secondaryIndex), context, firstDraw, endDraw, drawScopes[secondaryIndex]);
+			});
 
-			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		std::vector<VkCommandBuffer> secondaryBuffers(secondaryCount);
+		for (uint32_t i = 0; i < secondaryCount; i++)
+		{
+			secondaryBuffers[i] = command->GetSecondaryBuffer(currentFrame, i);
+		}
 
-			VkRect2D scissor{};
-			scissor.offset = { 0,0 };
-			scissor.extent = swapChain->GetExtent();
+		if (secondaryCount > 0)
+		{
+			vkCmdExecuteCommands(context.commandBuffer, secondaryCount, secondaryBuffers.data());
+		}
+	}
 
-			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	void VulkanRendererAPI::RecordDraws(VkCommandBuffer commandBuffer, const VulkanGraphContext& context, uint32_t firstDraw, uint32_t endDraw, uint32_t scope) const
+	{
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = context.renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = context.framebuffer;
+		// the statistics query of the main pass stays active while the secondaries execute
+		inheritanceInfo.pipelineStatistics = gpuProfiler->GetInheritedStatistics();
 
-			VkBuffer vertexBuffers[] = { *vertexBuffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		VkCommandBufferBeginInfo commandBufferBeginInfo{};
+		commandBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-			vkCmdBindIndexBuffer(commandBuffer, *indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+		Check(result == VK_SUCCESS, "Failed to begin recording secondary command buffer. Vulkan error: %d", result);
 
-			VkDescriptorSet descriptorSet = descriptor->GetSet(currentFrame);
+		// secondaries inherit no state from the primary or each other
+		VkViewport viewport{};
+		viewport.x = 0;
+		viewport.y = 0;
+		viewport.width = static_cast<float>(context.extent.width);
+		viewport.height = static_cast<float>(context.extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0,0 };
+		scissor.extent = context.extent;
+
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		gpuProfiler->WriteBegin(commandBuffer, scope);
+
+		// the queue is sorted by pipeline and mesh, so a bind is only recorded when one of them changes
+		const VulkanPipeline* boundPipeline = nullptr;
+		const VulkanMeshResource* boundMesh = nullptr;
+
+		// bound once, every pipeline layout is compatible with the fallback's
+		if (bindlessTable)
+		{
+			VkDescriptorSet descriptorSet = bindlessTable->GetSet();
 			vkCmdBindDescriptorSets(commandBuffer,
-				VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline->GetLayout(), 0,
+				VK_PIPELINE_BIND_POINT_GRAPHICS, fallbackPipelines[0]->GetLayout(), 1,
 				1, &descriptorSet,
 				0, nullptr);
+		}
+
+		VkBuffer drawBuffer = cullingPass->GetDrawBuffer(currentFrame);
+		for (uint32_t drawIndex = firstDraw; drawIndex < endDraw; drawIndex++)
+		{
+			const VulkanMeshResource* mesh = meshResources.Get(drawBatches[drawIndex].mesh);
+			const VulkanMaterialResource* material = materialResources.Get(drawBatches[drawIndex].material);
+
+			const VulkanPipeline* pipeline = material->pipeline.get();
+			if (pipeline != boundPipeline)
+			{
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
+				boundPipeline = pipeline;
+			}
+
+			// rebinding the same set with new dynamic offsets is cheap, every draw has its own uniforms
+			const DrawBatch& draw = drawBatches[drawIndex];
+			VkDescriptorSet descriptorSet = bindlessTable ? frameDescriptorSet : material->descriptorSet;
+			uint32_t dynamicOffsets[] = { frameUniforms.offset, draw.uniformOffset };
+			vkCmdBindDescriptorSets(commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetLayout(), 0,
+				1, &descriptorSet,
+				2, dynamicOffsets);
 
-			vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(model->GetMesh(0)->GetIndices().size()), 1, 0, 0, 0);
+			if (bindlessTable)
+			{
+				vkCmdPushConstants(commandBuffer, pipeline->GetLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VulkanDrawConstants), &draw.constants);
+			}
+
+			if (mesh != boundMesh)
+			{
+				VkBuffer vertexBuffers[] = { *buffers.Get(mesh->vertexBuffer) };
+				VkDeviceSize offsets[] = { 0 };
+				vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+				vkCmdBindIndexBuffer(commandBuffer, *buffers.Get(mesh->indexBuffer), 0, VK_INDEX_TYPE_UINT32);
+				boundMesh = mesh;
+			}
+
+			// culled instances only show up in the instance count
+			vkCmdDrawIndexedIndirect(commandBuffer, drawBuffer, drawIndex * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
 		}
-		vkCmdEndRenderPass(commandBuffer);
+
+		gpuProfiler->WriteEnd(commandBuffer, scope);
 
 		result = vkEndCommandBuffer(commandBuffer);
-		Check(result == VK_SUCCESS, "Failed to record command buffer. Vulkan error: %d", result);
+		Check(result == VK_SUCCESS, "Failed to record secondary command buffer. Vulkan error: %d", result);
 	}
 #pragma endregion
 
@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanResidencyManager.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+
+#include "core/Logger.h"
+
+#include <algorithm>
+
+namespace FGEngine
+{
+	VulkanResidencyManager::VulkanResidencyManager(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t inFrameLatency)
+	{
+		logicalDevice = inLogicalDevice;
+		frameLatency = inFrameLatency;
+
+		heapCooldownFrames.resize(logicalDevice->GetAllocator().GetHeapCount(), 0);
+	}
+
+	Handle<VulkanResidentResource> VulkanResidencyManager::Register(const VulkanResidency& residency, VulkanDemoteFunction&& demote)
+	{
+		VulkanResidentResource resource;
+		resource.residency = residency;
+		resource.demote = std::move(demote);
+		return resources.Insert(std::move(resource));
+	}
+
+	void VulkanResidencyManager::Unregister(Handle<VulkanResidentResource> handle)
+	{
+		resources.Remove(handle);
+	}
+
+	void VulkanResidencyManager::Touch(Handle<VulkanResidentResource> handle, uint64_t frame)
+	{
+		if (VulkanResidentResource* resource = resources.Get(handle))
+		{
+			resource->lastUsedFrame = frame;
+		}
+	}
+
+	void VulkanResidencyManager::Update(uint64_t frame)
+	{
+		VulkanMemoryAllocator& allocator = logicalDevice->GetAllocator();
+		allocator.UpdateBudgets();
+
+		for (uint32_t heapIndex = 0; heapIndex < allocator.GetHeapCount(); heapIndex++)
+		{
+			// memory from the last demotion is still waiting in the deletion queue
+			if (frame < heapCooldownFrames[heapIndex]) continue;
+
+			VulkanHeapBudget budget = allocator.GetHeapBudget(heapIndex);
+			if (budget.usage <= static_cast<VkDeviceSize>(budget.budget * HighWatermark)) continue;
+
+			VkDeviceSize targetUsage = static_cast<VkDeviceSize>(budget.budget * LowWatermark);
+			VkDeviceSize excessBytes = budget.usage - targetUsage;
+
+			// resources drawn this frame are last resort, they would come straight back into use
+			std::vector<VulkanResidentResource*> candidates;
+			for (VulkanResidentResource& resource : resources)
+			{
+				if (!resource.bDemotable || resource.lastUsedFrame >= frame) continue;
+				if (allocator.GetHeapIndex(resource.residency.memoryTypeIndex) != heapIndex) continue;
+
+				candidates.push_back(&resource);
+			}
+			std::sort(candidates.begin(), candidates.end(),
+				[](const VulkanResidentResource* a, const VulkanResidentResource* b)
+				{
+					return a->lastUsedFrame < b->lastUsedFrame;
+				});
+
+			VkDeviceSize freedBytes = 0;
+			uint32_t demotedCount = 0;
+			for (VulkanResidentResource* resource : candidates)
+			{
+				VulkanResidency previous = resource->residency;
+				if (!resource->demote(resource->residency))
+				{
+					resource->bDemotable = false;
+					continue;
+				}
+
+				bool bMovedHeap = allocator.GetHeapIndex(resource->residency.memoryTypeIndex) != heapIndex;
+				freedBytes += bMovedHeap ? previous.size : previous.size - std::min(previous.size, resource->residency.size);
+				demotedCount++;
+
+				if (freedBytes >= excessBytes) break;
+			}
+
+			LogWarning("Heap %u at %llu / %llu bytes of budget, demoted %u resources to free %llu bytes",
+				heapIndex, budget.usage, budget.budget, demotedCount, freedBytes);
+
+			heapCooldownFrames[heapIndex] = frame + frameLatency + 1;
+		}
+	}
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "platform/vulkan/VulkanShaderModule.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanUtil.h"
 #include "renderer/Shader.h"
 
 namespace FGEngine
@@ -8,6 +9,7 @@ namespace FGEngine
 	VulkanShaderModule::VulkanShaderModule(const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, const Shader& shader)
 	{
 		logicalDevice = inLogicalDevice;
+		filename = shader.GetShaderFilename();
 
 		std::vector<char> shaderCode = shader.GetShaderCode();
 		Check(shaderCode.size() > 0, "Shader code from (%s) is empty!", shader.GetShaderFilename());
@@ -17,7 +19,7 @@ namespace FGEngine
 		createInfo.codeSize = shaderCode.size();
 		createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
 
-		VkResult result = vkCreateShaderModule(*logicalDevice, &createInfo, nullptr, &shaderModule);
+		VkResult result = vkCreateShaderModule(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &shaderModule);
 
 		// shader stage create info
 		{
@@ -32,12 +34,15 @@ namespace FGEngine
 			case Shader::EType::Fragment:
 				shaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
 				break;
+			case Shader::EType::Compute:
+				shaderStageCreateInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+				break;
 			}
 		}
 	}
 
 	VulkanShaderModule::~VulkanShaderModule()
 	{
-		vkDestroyShaderModule(*logicalDevice, shaderModule, nullptr);
+		vkDestroyShaderModule(*logicalDevice, shaderModule, VulkanUtil::GetAllocationCallbacks());
 	}
 }
\ No newline at end of file
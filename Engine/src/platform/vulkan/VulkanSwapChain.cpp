@@ -3,6 +3,7 @@
 #include "platform/vulkan/VulkanInstance.h"
 #include "platform/vulkan/VulkanPhysicalDevice.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
 #include "platform/vulkan/VulkanUtil.h"
 
 #include <algorithm>
@@ -84,18 +85,30 @@ namespace FGEngine
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(*logicalDevice);
+		// the old chain is handed to the new one and retired with its views,
+		// frames in flight keep using them until their fences signal
+		VkSwapchainKHR oldSwapChain = swapChain;
+		std::vector<VkImageView> oldImageViews = std::move(imageViews);
+		imageViews.clear();
 
-		CleanUp();
-
-		CreateSwapChain(vulkanInstance, physicalDevice, nativeWindow);
+		CreateSwapChain(vulkanInstance, physicalDevice, nativeWindow, oldSwapChain);
 		CreateImageViews();
+
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), oldSwapChain, oldImageViews = std::move(oldImageViews)]()
+			{
+				for (VkImageView imageView : oldImageViews)
+				{
+					vkDestroyImageView(device, imageView, VulkanUtil::GetAllocationCallbacks());
+				}
+				vkDestroySwapchainKHR(device, oldSwapChain, VulkanUtil::GetAllocationCallbacks());
+			});
 		//CreateColorResources();
 		//CreateDepthResources();
 		//CreateFrameBuffers();
 	}
 
-	void VulkanSwapChain::CreateSwapChain(const std::shared_ptr<VulkanInstance>& vulkanInstance, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, GLFWwindow* nativeWindow)
+	void VulkanSwapChain::CreateSwapChain(const std::shared_ptr<VulkanInstance>& vulkanInstance, const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, GLFWwindow* nativeWindow, VkSwapchainKHR oldSwapChain)
 	{
 		SwapChainSupportDetails supportDetails = physicalDevice->GetSwapChainSupportDetails();
 		int width, height;
@@ -157,9 +170,9 @@ namespace FGEngine
 		createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		createInfo.oldSwapchain = oldSwapChain;
 
-		VkResult result = vkCreateSwapchainKHR(*logicalDevice, &createInfo, nullptr, &swapChain);
+		VkResult result = vkCreateSwapchainKHR(*logicalDevice, &createInfo, VulkanUtil::GetAllocationCallbacks(), &swapChain);
 		Check(result == VK_SUCCESS, "Failed to create swap chain. Vulkan error: %d", result);
 
 		uint32_t swapChainImageCount;
@@ -193,34 +206,7 @@ namespace FGEngine
 		//vkDestroyImage(*logicalDevice, depthImage, nullptr);
 		//vkFreeMemory(*logicalDevice, depthImageMemory, nullptr);
 
-		VulkanUtil::VectorDestroy(vkDestroyFramebuffer, *logicalDevice, frameBuffers, nullptr);
 		VulkanUtil::VectorDestroy(vkDestroyImageView, *logicalDevice, imageViews, nullptr);
-		vkDestroySwapchainKHR(*logicalDevice, swapChain, nullptr);
-	}
-
-	void VulkanSwapChain::CreateFrameBuffers(VkImageView colorImageView, VkImageView depthImageView, VkRenderPass renderPass)
-	{
-		frameBuffers.resize(imageViews.size());
-
-		for (size_t i = 0; i < imageViews.size(); i++)
-		{
-			std::array<VkImageView, 3> attachments = {
-				colorImageView,
-				depthImageView,
-				imageViews[i]
-			};
-
-			VkFramebufferCreateInfo createInfo{};
-			createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			createInfo.renderPass = renderPass;
-			createInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-			createInfo.pAttachments = attachments.data();
-			createInfo.width = extent.width;
-			createInfo.height = extent.height;
-			createInfo.layers = 1;
-
-			VkResult result = vkCreateFramebuffer(*logicalDevice, &createInfo, nullptr, &frameBuffers[i]);
-			Check(result == VK_SUCCESS, "Failed to create frame buffer %d. Vulkan error: %d", i, result);
-		}
+		vkDestroySwapchainKHR(*logicalDevice, swapChain, VulkanUtil::GetAllocationCallbacks());
 	}
 }
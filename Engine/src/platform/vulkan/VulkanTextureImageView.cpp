@@ -2,245 +2,130 @@
 #include "platform/vulkan/VulkanTextureImageView.h"
 #include "platform/vulkan/VulkanPhysicalDevice.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
-#include "platform/vulkan/VulkanSwapChain.h"
-#include "platform/vulkan/VulkanCommand.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanUploadManager.h"
 #include "platform/vulkan/VulkanUtil.h"
 
 #include "renderer/Texture.h"
 
 namespace FGEngine
 {
-	void GenerateMipmaps(VkPhysicalDevice physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, std::shared_ptr<VulkanCommand> command, VkImage image, VkFormat imageFormat, int32_t textureWidth, int32_t textureHeight, uint32_t mipLevels)
+	VulkanTextureImageView::VulkanTextureImageView(
+		const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice,
+		const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, 
+		VulkanUploadManager& uploadManager, 
+		const Texture& texture)
 	{
-		VkFormatProperties formatProperties;
-		vkGetPhysicalDeviceFormatProperties(physicalDevice, imageFormat, &formatProperties);
-
-		Check(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT, "Texture image format does not support linear blitting!");
-
-		VkCommandBuffer commandBuffer = command->BeginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.image = image;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-		barrier.subresourceRange.levelCount = 1;
-
-		int32_t mipWidth = textureWidth;
-		int32_t mipHeight = textureHeight;
-
-		for (uint32_t i = 1; i < mipLevels; i++)
-		{
-			barrier.subresourceRange.baseMipLevel = i - 1;
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
-
-			VkImageBlit blit{};
-			blit.srcOffsets[0] = { 0,0,0 };
-			blit.srcOffsets[1] = { mipWidth,mipHeight,1 };
-			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			blit.srcSubresource.mipLevel = i - 1;
-			blit.srcSubresource.baseArrayLayer = 0;
-			blit.srcSubresource.layerCount = 1;
-			blit.dstOffsets[0] = { 0,0,0 };
-			blit.dstOffsets[1] =
-			{
-				mipWidth > 1 ? mipWidth / 2 : 1,
-				mipHeight > 1 ? mipHeight / 2 : 1,
-				1
-			};
-			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			blit.dstSubresource.mipLevel = i;
-			blit.dstSubresource.baseArrayLayer = 0;
-			blit.dstSubresource.layerCount = 1;
-
-			vkCmdBlitImage(commandBuffer,
-				image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				1, &blit,
-				VK_FILTER_LINEAR);
-
-			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		logicalDevice = inLogicalDevice;
+		width = static_cast<uint32_t>(texture.GetWidth());
+		height = static_cast<uint32_t>(texture.GetHeight());
 
-			vkCmdPipelineBarrier(commandBuffer,
-				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
+		VkDeviceSize imageSize = texture.GetWidth() * texture.GetHeight() * 4;
+		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture.GetWidth(), texture.GetHeight())))) + 1;
 
-			if (mipWidth > 1) mipWidth /= 2;
-			if (mipHeight > 1) mipHeight /= 2;
-		}
+		VulkanUtil::CreateImage(logicalDevice,
+			texture.GetWidth(), texture.GetHeight(), mipLevels,
+			VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			image, imageAllocation);
 
-		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
-		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		uploadManager.UploadImage(image, VK_FORMAT_R8G8B8A8_SRGB, texture.Data(), imageSize, texture.GetWidth(), texture.GetHeight(), mipLevels);
 
-		vkCmdPipelineBarrier(commandBuffer,
-			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier);
+		imageView = VulkanUtil::CreateImageView(logicalDevice, image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
 
-		command->EndSingleTimeCommands(commandBuffer);
+		CreateTextureSampler(physicalDevice);
 	}
 
-	static void TransitionImageLayout(const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, std::shared_ptr<VulkanCommand> command, VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
+	VulkanTextureImageView::~VulkanTextureImageView()
 	{
-		VkCommandBuffer commandBuffer = command->BeginSingleTimeCommands();
-		{
-			VkImageMemoryBarrier barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-			barrier.oldLayout = oldLayout;
-			barrier.newLayout = newLayout;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = image;
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = mipLevels;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-
-			VkPipelineStageFlags sourceStage;
-			VkPipelineStageFlags destinationStage;
-			if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-			{
-				barrier.srcAccessMask = 0;
-				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-				sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-				destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			}
-			else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-			{
-				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		if (!logicalDevice) return;
 
-				sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-				destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-			}
-			else
+		RetireImage();
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), sampler = sampler]()
 			{
-				NoEntry("Unsupported layout transition!");
-			}
-
-
-			vkCmdPipelineBarrier(commandBuffer,
-				sourceStage, destinationStage,
-				0,
-				0, nullptr,
-				0, nullptr,
-				1, &barrier);
-		}
-		command->EndSingleTimeCommands(commandBuffer);
+				vkDestroySampler(device, sampler, VulkanUtil::GetAllocationCallbacks());
+			});
 	}
 
-	// TODO: when there's a proper vulkan class, use that instead. This function is temporary!
-	void CreateBuffer(
-		const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& logicalDevice,
-		VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
-		VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+	VulkanTextureImageView::VulkanTextureImageView(VulkanTextureImageView&& other) noexcept :
+		logicalDevice(std::move(other.logicalDevice)),
+		mipLevels(std::exchange(other.mipLevels, 0)),
+		width(std::exchange(other.width, 0)),
+		height(std::exchange(other.height, 0)),
+		generation(std::exchange(other.generation, 0)),
+		image(std::exchange(other.image, VK_NULL_HANDLE)),
+		imageAllocation(std::exchange(other.imageAllocation, VulkanAllocation())),
+		imageView(std::exchange(other.imageView, VK_NULL_HANDLE)),
+		sampler(std::exchange(other.sampler, VK_NULL_HANDLE))
 	{
-		VkBufferCreateInfo bufferCreateInfo{};
-		bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		bufferCreateInfo.size = size;
-		bufferCreateInfo.usage = usage;
-		bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		bufferCreateInfo.flags = 0;
-
-		VkResult result = vkCreateBuffer(*logicalDevice, &bufferCreateInfo, nullptr, &buffer);
-		Check(result == VK_SUCCESS, "Failed to create vertex buffer. Vulkan error: %d", result);
-
-		VkMemoryRequirements memoryRequirements;
-		vkGetBufferMemoryRequirements(*logicalDevice, buffer, &memoryRequirements);
-
-		VkMemoryAllocateInfo allocateInfo{};
-		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocateInfo.allocationSize = memoryRequirements.size;
-		allocateInfo.memoryTypeIndex = physicalDevice->FindMemoryType(memoryRequirements.memoryTypeBits, properties);
-
-		// NOTE: shouldn't do allocation for each individual buffer, instead should create a custom allocator
-		// ref: https://vulkan-tutorial.com/Vertex_buffers/Staging_buffer#:~:text=more%20complex%20geometry.-,Conclusion,-It%20should%20be
-		result = vkAllocateMemory(*logicalDevice, &allocateInfo, nullptr, &bufferMemory);
-		Check(result == VK_SUCCESS, "Failed to allocate vertex buffer memory. Vulkan error: %d", result);
-
-		vkBindBufferMemory(*logicalDevice, buffer, bufferMemory, 0);
 	}
 
-
-	VulkanTextureImageView::VulkanTextureImageView(
-		const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice,
-		const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, 
-		const std::shared_ptr<VulkanSwapChain>& swapChain, 
-		const std::shared_ptr<VulkanCommand>& command, 
-		const Texture& texture)
+	VulkanTextureImageView& VulkanTextureImageView::operator=(VulkanTextureImageView&& other) noexcept
 	{
-		logicalDevice = inLogicalDevice;
-
-		VkDeviceSize imageSize = texture.GetWidth() * texture.GetHeight() * 4;
-		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texture.GetWidth(), texture.GetHeight())))) + 1;
-
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-
-		CreateBuffer(physicalDevice, logicalDevice,
-			imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			stagingBuffer, stagingBufferMemory);
-
-		void* data;
-		vkMapMemory(*logicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
+		if (this != &other)
 		{
-			memcpy(data, texture.Data(), static_cast<size_t>(imageSize));
+			std::swap(logicalDevice, other.logicalDevice);
+			std::swap(mipLevels, other.mipLevels);
+			std::swap(width, other.width);
+			std::swap(height, other.height);
+			std::swap(generation, other.generation);
+			std::swap(image, other.image);
+			std::swap(imageAllocation, other.imageAllocation);
+			std::swap(imageView, other.imageView);
+			std::swap(sampler, other.sampler);
 		}
-		vkUnmapMemory(*logicalDevice, stagingBufferMemory);
+		return *this;
+	}
 
-		VulkanUtil::CreateImage(physicalDevice, logicalDevice,
-			texture.GetWidth(), texture.GetHeight(), mipLevels,
+	bool VulkanTextureImageView::Demote(VulkanUploadManager& uploadManager)
+	{
+		if (mipLevels <= 1 || std::max(width, height) <= MinDemotedSize) return false;
+
+		uint32_t demotedWidth = std::max(width >> 1, 1u);
+		uint32_t demotedHeight = std::max(height >> 1, 1u);
+		uint32_t demotedMipLevels = mipLevels - 1;
+
+		VkImage demotedImage;
+		VulkanAllocation demotedAllocation;
+		VulkanUtil::CreateImage(logicalDevice,
+			demotedWidth, demotedHeight, demotedMipLevels,
 			VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
 			VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			image, imageMemory);
+			demotedImage, demotedAllocation);
 
-		TransitionImageLayout(logicalDevice, command,
-			image, VK_FORMAT_R8G8B8A8_SRGB,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+		// the smaller mips already exist, so this is a copy rather than a resample
+		uploadManager.CopyImageMips(image, 1, demotedImage, demotedMipLevels, demotedWidth, demotedHeight);
 
-		command->CopyBufferToImage(stagingBuffer, image, texture.GetWidth(), texture.GetHeight());
+		RetireImage();
 
-		vkDestroyBuffer(*logicalDevice, stagingBuffer, nullptr);
-		vkFreeMemory(*logicalDevice, stagingBufferMemory, nullptr);
-
-		GenerateMipmaps(*physicalDevice, logicalDevice, command, image, VK_FORMAT_R8G8B8A8_SRGB, texture.GetWidth(), texture.GetHeight(), mipLevels);
-
-		imageView = VulkanUtil::CreateImageView(logicalDevice, image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
-
-		CreateTextureSampler(physicalDevice);
+		image = demotedImage;
+		imageAllocation = demotedAllocation;
+		imageView = VulkanUtil::CreateImageView(logicalDevice, image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, demotedMipLevels);
+		mipLevels = demotedMipLevels;
+		width = demotedWidth;
+		height = demotedHeight;
+		generation++;
+		return true;
 	}
 
-	VulkanTextureImageView::~VulkanTextureImageView()
+	void VulkanTextureImageView::RetireImage()
 	{
-		vkDestroySampler(*logicalDevice, sampler, nullptr);
-		vkDestroyImageView(*logicalDevice, imageView, nullptr);
-		vkDestroyImage(*logicalDevice, image, nullptr);
-		vkFreeMemory(*logicalDevice, imageMemory, nullptr);
+		if (image == VK_NULL_HANDLE) return;
+
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), allocator = &logicalDevice->GetAllocator(), imageView = imageView, image = image, imageAllocation = imageAllocation]() mutable
+			{
+				vkDestroyImageView(device, imageView, VulkanUtil::GetAllocationCallbacks());
+				vkDestroyImage(device, image, VulkanUtil::GetAllocationCallbacks());
+				allocator->Free(imageAllocation);
+			});
+
+		image = VK_NULL_HANDLE;
+		imageAllocation = VulkanAllocation();
+		imageView = VK_NULL_HANDLE;
 	}
 
 	void VulkanTextureImageView::CreateTextureSampler(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice)
@@ -266,7 +151,7 @@ namespace FGEngine
 		samplerCreateInfo.minLod = 0.0f;
 		samplerCreateInfo.maxLod = static_cast<float>(mipLevels);
 
-		VkResult result = vkCreateSampler(*logicalDevice, &samplerCreateInfo, nullptr, &sampler);
+		VkResult result = vkCreateSampler(*logicalDevice, &samplerCreateInfo, VulkanUtil::GetAllocationCallbacks(), &sampler);
 		Check(result == VK_SUCCESS, "Failed to create texture sampler. Vulkan error: %d", result);
 	}
 }
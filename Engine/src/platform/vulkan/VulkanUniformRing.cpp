@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanUniformRing.h"
+#include "platform/vulkan/VulkanPhysicalDevice.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanDeletionQueue.h"
+#include "platform/vulkan/VulkanBuffer.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+namespace FGEngine
+{
+	VulkanUniformRing::VulkanUniformRing(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, uint32_t frameCount, VkDeviceSize inFrameSize)
+	{
+		logicalDevice = inLogicalDevice;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(*physicalDevice, &properties);
+		alignment = std::max<VkDeviceSize>(1, properties.limits.minUniformBufferOffsetAlignment);
+
+		frameSize = GetAlignedSize(inFrameSize);
+		frameHeads.resize(frameCount, 0);
+		CreateBuffer();
+	}
+
+	VulkanUniformRing::~VulkanUniformRing()
+	{
+		RetireBuffer();
+	}
+
+	bool VulkanUniformRing::BeginFrame(uint32_t frame, VkDeviceSize requiredBytes)
+	{
+		frameHeads[frame] = 0;
+		if (requiredBytes <= frameSize) return false;
+
+		// every region grows, the other frames will need the same soon enough
+		VkDeviceSize newFrameSize = frameSize;
+		while (newFrameSize < requiredBytes) newFrameSize *= 2;
+
+		LogInfo("Uniform ring grows from %llu to %llu bytes per frame", frameSize, newFrameSize);
+
+		RetireBuffer();
+		frameSize = newFrameSize;
+		CreateBuffer();
+		return true;
+	}
+
+	VulkanUniformAllocation VulkanUniformRing::Allocate(uint32_t frame, VkDeviceSize size)
+	{
+		VkDeviceSize alignedSize = GetAlignedSize(size);
+		Check(frameHeads[frame] + alignedSize <= frameSize, "Uniform ring frame %u out of space, BeginFrame() was given too few bytes", frame);
+
+		VkDeviceSize offset = frame * frameSize + frameHeads[frame];
+		frameHeads[frame] += alignedSize;
+
+		VulkanUniformAllocation result;
+		result.offset = static_cast<uint32_t>(offset);
+		result.mappedData = static_cast<uint8_t*>(allocation.mappedData) + offset;
+		return result;
+	}
+
+	VkDeviceSize VulkanUniformRing::GetAlignedSize(VkDeviceSize size) const
+	{
+		return (size + alignment - 1) / alignment * alignment;
+	}
+
+	void VulkanUniformRing::CreateBuffer()
+	{
+		VkDeviceSize size = frameSize * frameHeads.size();
+		Check(size <= UINT32_MAX, "Uniform ring of %llu bytes exceeds the range of dynamic offsets", size);
+
+		// the culling pass reads the frame's uniforms on the async compute queue
+		VulkanBuffer::CreateBuffer(
+			logicalDevice,
+			size,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffer, allocation, true);
+	}
+
+	void VulkanUniformRing::RetireBuffer()
+	{
+		logicalDevice->GetDeletionQueue().Retire(
+			[device = static_cast<VkDevice>(*logicalDevice), allocator = &logicalDevice->GetAllocator(), buffer = buffer, allocation = allocation]() mutable
+			{
+				vkDestroyBuffer(device, buffer, VulkanUtil::GetAllocationCallbacks());
+				allocator->Free(allocation);
+			});
+	}
+}
@@ -0,0 +1,665 @@
+#include "pch.h"
+#include "platform/vulkan/VulkanUploadManager.h"
+#include "platform/vulkan/VulkanPhysicalDevice.h"
+#include "platform/vulkan/VulkanLogicalDevice.h"
+#include "platform/vulkan/VulkanBuffer.h"
+#include "platform/vulkan/VulkanUtil.h"
+
+#include "core/Logger.h"
+
+namespace FGEngine
+{
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	VulkanUploadManager::VulkanUploadManager(const std::shared_ptr<VulkanPhysicalDevice>& inPhysicalDevice, const std::shared_ptr<VulkanLogicalDevice>& inLogicalDevice, VkDeviceSize inRingSize)
+	{
+		logicalDevice = inLogicalDevice;
+		physicalDevice = *inPhysicalDevice;
+		ringSize = inRingSize;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		// copy offsets must be a multiple of the texel size, 16 covers every format we upload
+		ringAlignment = std::max<VkDeviceSize>(16, properties.limits.optimalBufferCopyOffsetAlignment);
+
+		graphicsQueueFamily = inPhysicalDevice->GetQueueFamilyIndices().graphicsFamily.value();
+		transferQueueFamily = logicalDevice->GetTransferQueueFamily();
+		bDedicatedTransferQueue = logicalDevice->HasDedicatedTransferQueue();
+		LogInfo("Uploads run on the %s queue", bDedicatedTransferQueue ? "dedicated transfer" : "graphics");
+
+		VkCommandPoolCreateInfo poolCreateInfo{};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolCreateInfo.queueFamilyIndex = graphicsQueueFamily;
+
+		VkResult result = vkCreateCommandPool(*logicalDevice, &poolCreateInfo, VulkanUtil::GetAllocationCallbacks(), &commandPool);
+		Check(result == VK_SUCCESS, "Failed to create upload command pool. Vulkan error: %d", result);
+
+		std::array<VkCommandBuffer, BatchCount> commandBuffers;
+
+		VkCommandBufferAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocateInfo.commandPool = commandPool;
+		allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocateInfo.commandBufferCount = BatchCount;
+
+		result = vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, commandBuffers.data());
+		Check(result == VK_SUCCESS, "Failed to allocate upload command buffers. Vulkan error: %d", result);
+
+		std::array<VkCommandBuffer, BatchCount> transferCommandBuffers{};
+		if (bDedicatedTransferQueue)
+		{
+			poolCreateInfo.queueFamilyIndex = transferQueueFamily;
+			result = vkCreateCommandPool(*logicalDevice, &poolCreateInfo, VulkanUtil::GetAllocationCallbacks(), &transferCommandPool);
+			Check(result == VK_SUCCESS, "Failed to create transfer command pool. Vulkan error: %d", result);
+
+			allocateInfo.commandPool = transferCommandPool;
+			result = vkAllocateCommandBuffers(*logicalDevice, &allocateInfo, transferCommandBuffers.data());
+			Check(result == VK_SUCCESS, "Failed to allocate transfer command buffers. Vulkan error: %d", result);
+
+			VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+			semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+			semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+			semaphoreTypeCreateInfo.initialValue = 0;
+
+			VkSemaphoreCreateInfo semaphoreCreateInfo{};
+			semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+			semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+			result = vkCreateSemaphore(*logicalDevice, &semaphoreCreateInfo, VulkanUtil::GetAllocationCallbacks(), &timelineSemaphore);
+			Check(result == VK_SUCCESS, "Failed to create upload timeline semaphore. Vulkan error: %d", result);
+		}
+
+		VkFenceCreateInfo fenceCreateInfo{};
+		fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (uint32_t i = 0; i < BatchCount; i++)
+		{
+			batches[i].commandBuffer = commandBuffers[i];
+			batches[i].transferCommandBuffer = transferCommandBuffers[i];
+
+			result = vkCreateFence(*logicalDevice, &fenceCreateInfo, VulkanUtil::GetAllocationCallbacks(), &batches[i].fence);
+			Check(result == VK_SUCCESS, "Failed to create upload fence. Vulkan error: %d", result);
+		}
+
+		VulkanBuffer::CreateBuffer(logicalDevice,
+			ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			ring.buffer, ring.allocation);
+		Check(ring.allocation.mappedData, "Staging ring is not host visible");
+	}
+
+	VulkanUploadManager::~VulkanUploadManager()
+	{
+		Flush();
+		WaitIdle();
+
+		vkDestroyBuffer(*logicalDevice, ring.buffer, VulkanUtil::GetAllocationCallbacks());
+		logicalDevice->GetAllocator().Free(ring.allocation);
+
+		for (Batch& batch : batches)
+		{
+			vkDestroyFence(*logicalDevice, batch.fence, VulkanUtil::GetAllocationCallbacks());
+		}
+		vkDestroyCommandPool(*logicalDevice, commandPool, VulkanUtil::GetAllocationCallbacks());
+
+		if (bDedicatedTransferQueue)
+		{
+			vkDestroyCommandPool(*logicalDevice, transferCommandPool, VulkanUtil::GetAllocationCallbacks());
+			vkDestroySemaphore(*logicalDevice, timelineSemaphore, VulkanUtil::GetAllocationCallbacks());
+		}
+	}
+
+	void VulkanUploadManager::UploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+	{
+		StagingRange staging = AllocateStaging(size);
+		memcpy(staging.mappedData, data, static_cast<size_t>(size));
+
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = staging.offset;
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+
+		vkCmdCopyBuffer(GetTransferCommandBuffer(), staging.buffer, dstBuffer, 1, &copyRegion);
+		ReleaseToGraphics(dstBuffer, dstOffset, size);
+	}
+
+	void VulkanUploadManager::UploadImage(VkImage image, VkFormat format, const void* data, VkDeviceSize size, uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		StagingRange staging = AllocateStaging(size);
+		memcpy(staging.mappedData, data, static_cast<size_t>(size));
+
+		VkCommandBuffer commandBuffer = GetTransferCommandBuffer();
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = staging.offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+
+		region.imageOffset = { 0,0,0 };
+		region.imageExtent = { width, height, 1 };
+
+		vkCmdCopyBufferToImage(commandBuffer, staging.buffer, image,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// blits need a graphics queue
+		ReleaseToGraphics(image, mipLevels);
+		RecordMipmaps(GetRecordingCommandBuffer(), image, format, width, height, mipLevels);
+	}
+
+	void VulkanUploadManager::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+	{
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = 0;
+		copyRegion.dstOffset = 0;
+		copyRegion.size = size;
+
+		vkCmdCopyBuffer(GetRecordingCommandBuffer(), srcBuffer, dstBuffer, 1, &copyRegion);
+	}
+
+	void VulkanUploadManager::CopyImageMips(VkImage srcImage, uint32_t srcBaseMip, VkImage dstImage, uint32_t mipLevels, uint32_t width, uint32_t height)
+	{
+		VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+
+		std::array<VkImageMemoryBarrier, 2> barriers{};
+		for (VkImageMemoryBarrier& barrier : barriers)
+		{
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.levelCount = mipLevels;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+		}
+
+		// the source may still be sampled by earlier frames, the fragment stage dependency covers that
+		barriers[0].image = srcImage;
+		barriers[0].subresourceRange.baseMipLevel = srcBaseMip;
+		barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barriers[0].srcAccessMask = 0;
+		barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		barriers[1].image = dstImage;
+		barriers[1].subresourceRange.baseMipLevel = 0;
+		barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[1].srcAccessMask = 0;
+		barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			static_cast<uint32_t>(barriers.size()), barriers.data());
+
+		std::vector<VkImageCopy> regions(mipLevels);
+		for (uint32_t i = 0; i < mipLevels; i++)
+		{
+			VkImageCopy& region = regions[i];
+			region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.srcSubresource.mipLevel = srcBaseMip + i;
+			region.srcSubresource.baseArrayLayer = 0;
+			region.srcSubresource.layerCount = 1;
+			region.srcOffset = { 0,0,0 };
+			region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.dstSubresource.mipLevel = i;
+			region.dstSubresource.baseArrayLayer = 0;
+			region.dstSubresource.layerCount = 1;
+			region.dstOffset = { 0,0,0 };
+			region.extent = { std::max(width >> i, 1u), std::max(height >> i, 1u), 1 };
+		}
+
+		vkCmdCopyImage(commandBuffer,
+			srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+
+		VkImageMemoryBarrier& barrier = barriers[1];
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+	}
+
+	void VulkanUploadManager::Flush()
+	{
+		if (!bRecording) return;
+
+		Batch& batch = batches[currentBatch];
+
+		// device side copies have no per-resource barrier, make them visible to every later read at once
+		VkMemoryBarrier memoryBarrier{};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(batch.commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			1, &memoryBarrier,
+			0, nullptr,
+			0, nullptr);
+
+		VkResult result = vkEndCommandBuffer(batch.commandBuffer);
+		Check(result == VK_SUCCESS, "Failed to record upload command buffer. Vulkan error: %d", result);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+
+		// the graphics side acquires what the transfer side released, so it waits for the transfer submission
+		VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		if (bDedicatedTransferQueue)
+		{
+			result = vkEndCommandBuffer(batch.transferCommandBuffer);
+			Check(result == VK_SUCCESS, "Failed to record transfer command buffer. Vulkan error: %d", result);
+
+			timelineValue++;
+
+			VkTimelineSemaphoreSubmitInfo transferTimelineSubmitInfo{};
+			transferTimelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			transferTimelineSubmitInfo.signalSemaphoreValueCount = 1;
+			transferTimelineSubmitInfo.pSignalSemaphoreValues = &timelineValue;
+
+			VkSubmitInfo transferSubmitInfo{};
+			transferSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			transferSubmitInfo.pNext = &transferTimelineSubmitInfo;
+			transferSubmitInfo.commandBufferCount = 1;
+			transferSubmitInfo.pCommandBuffers = &batch.transferCommandBuffer;
+			transferSubmitInfo.signalSemaphoreCount = 1;
+			transferSubmitInfo.pSignalSemaphores = &timelineSemaphore;
+
+			result = vkQueueSubmit(logicalDevice->GetTransferQueue(), 1, &transferSubmitInfo, VK_NULL_HANDLE);
+			Check(result == VK_SUCCESS, "Failed to submit transfer command buffer. Vulkan error: %d", result);
+
+			timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineSubmitInfo.waitSemaphoreValueCount = 1;
+			timelineSubmitInfo.pWaitSemaphoreValues = &timelineValue;
+
+			submitInfo.pNext = &timelineSubmitInfo;
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &timelineSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+		}
+
+		result = vkQueueSubmit(logicalDevice->GetGraphicsQueue(), 1, &submitInfo, batch.fence);
+		Check(result == VK_SUCCESS, "Failed to submit upload command buffer. Vulkan error: %d", result);
+
+		submittedBatches.push_back(currentBatch);
+		currentBatch = (currentBatch + 1) % BatchCount;
+		bRecording = false;
+
+		RetireCompletedBatches();
+	}
+
+	void VulkanUploadManager::WaitIdle()
+	{
+		while (!submittedBatches.empty())
+		{
+			WaitForOldestBatch();
+		}
+	}
+
+	VulkanUploadManager::StagingRange VulkanUploadManager::AllocateStaging(VkDeviceSize size)
+	{
+		Check(size > 0, "Empty upload");
+
+		// opened first so the ring bytes are accounted to the batch that will read them
+		GetRecordingCommandBuffer();
+
+		if (size > ringSize)
+		{
+			LogWarning("Upload of %llu bytes does not fit the %llu byte staging ring, using a temporary staging buffer", size, ringSize);
+
+			StagingBuffer& staging = batches[currentBatch].oversizedBuffers.emplace_back();
+			VulkanBuffer::CreateBuffer(logicalDevice,
+				size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				staging.buffer, staging.allocation);
+
+			return { staging.buffer, 0, staging.allocation.mappedData };
+		}
+
+		VkDeviceSize offset;
+		while (!TryAllocateFromRing(size, offset))
+		{
+			if (submittedBatches.empty())
+			{
+				// the open batch holds the rest of the ring, it has to go out before its space comes back
+				Flush();
+				WaitIdle();
+				GetRecordingCommandBuffer();
+			}
+			else
+			{
+				WaitForOldestBatch();
+			}
+		}
+
+		return { ring.buffer, offset, static_cast<uint8_t*>(ring.allocation.mappedData) + offset };
+	}
+
+	bool VulkanUploadManager::TryAllocateFromRing(VkDeviceSize size, VkDeviceSize& outOffset)
+	{
+		if (ringUsedBytes == 0)
+		{
+			ringHead = 0;
+			ringTail = 0;
+		}
+		else if (ringUsedBytes == ringSize)
+		{
+			return false;
+		}
+
+		VkDeviceSize offset = AlignUp(ringHead, ringAlignment);
+		VkDeviceSize consumed = 0;
+		if (ringHead >= ringTail)
+		{
+			// free space is [head, ringSize) and [0, tail)
+			if (offset + size <= ringSize)
+			{
+				consumed = offset + size - ringHead;
+			}
+			else if (size <= ringTail)
+			{
+				// the skipped end of the ring belongs to this batch until it retires
+				offset = 0;
+				consumed = ringSize - ringHead + size;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else
+		{
+			// free space is [head, tail)
+			if (offset + size > ringTail) return false;
+			consumed = offset + size - ringHead;
+		}
+
+		ringHead = offset + size;
+		ringUsedBytes += consumed;
+
+		Batch& batch = batches[currentBatch];
+		batch.ringBytes += consumed;
+		batch.ringEnd = ringHead;
+
+		outOffset = offset;
+		return true;
+	}
+
+	VkCommandBuffer VulkanUploadManager::GetRecordingCommandBuffer()
+	{
+		Batch& batch = batches[currentBatch];
+		if (bRecording) return batch.commandBuffer;
+
+		// batches are submitted round robin, if this one is still in flight it is the oldest
+		if (!submittedBatches.empty() && submittedBatches.front() == currentBatch)
+		{
+			WaitForOldestBatch();
+		}
+
+		vkResetCommandBuffer(batch.commandBuffer, 0);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VkResult result = vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+		Check(result == VK_SUCCESS, "Failed to begin recording upload command buffer. Vulkan error: %d", result);
+
+		if (bDedicatedTransferQueue)
+		{
+			vkResetCommandBuffer(batch.transferCommandBuffer, 0);
+
+			result = vkBeginCommandBuffer(batch.transferCommandBuffer, &beginInfo);
+			Check(result == VK_SUCCESS, "Failed to begin recording transfer command buffer. Vulkan error: %d", result);
+		}
+
+		bRecording = true;
+		return batch.commandBuffer;
+	}
+
+	VkCommandBuffer VulkanUploadManager::GetTransferCommandBuffer()
+	{
+		VkCommandBuffer commandBuffer = GetRecordingCommandBuffer();
+		return bDedicatedTransferQueue ? batches[currentBatch].transferCommandBuffer : commandBuffer;
+	}
+
+	void VulkanUploadManager::ReleaseToGraphics(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (!bDedicatedTransferQueue) return;
+
+		// uploads target resources the graphics queue has not used yet, so only the way back needs a transfer
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = transferQueueFamily;
+		barrier.dstQueueFamilyIndex = graphicsQueueFamily;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+
+		// release, the destination access is ignored on this queue
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(GetTransferCommandBuffer(),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr,
+			1, &barrier,
+			0, nullptr);
+
+		// acquire, the semaphore wait already orders it after the release
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(GetRecordingCommandBuffer(),
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			1, &barrier,
+			0, nullptr);
+	}
+
+	void VulkanUploadManager::ReleaseToGraphics(VkImage image, uint32_t mipLevels)
+	{
+		if (!bDedicatedTransferQueue) return;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = transferQueueFamily;
+		barrier.dstQueueFamilyIndex = graphicsQueueFamily;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = mipLevels;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(GetTransferCommandBuffer(),
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+
+		// the mip blits read and write it next
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(GetRecordingCommandBuffer(),
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+	}
+
+	void VulkanUploadManager::RetireCompletedBatches()
+	{
+		while (!submittedBatches.empty())
+		{
+			Batch& batch = batches[submittedBatches.front()];
+			if (vkGetFenceStatus(*logicalDevice, batch.fence) != VK_SUCCESS) break;
+
+			RetireBatch(batch);
+			submittedBatches.pop_front();
+		}
+	}
+
+	void VulkanUploadManager::WaitForOldestBatch()
+	{
+		Batch& batch = batches[submittedBatches.front()];
+		vkWaitForFences(*logicalDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+
+		RetireBatch(batch);
+		submittedBatches.pop_front();
+	}
+
+	void VulkanUploadManager::RetireBatch(Batch& batch)
+	{
+		vkResetFences(*logicalDevice, 1, &batch.fence);
+
+		// batches retire in submission order, so the tail simply moves to the end of this batch
+		if (batch.ringBytes > 0)
+		{
+			ringTail = batch.ringEnd;
+			ringUsedBytes -= batch.ringBytes;
+			batch.ringBytes = 0;
+		}
+
+		for (StagingBuffer& staging : batch.oversizedBuffers)
+		{
+			vkDestroyBuffer(*logicalDevice, staging.buffer, VulkanUtil::GetAllocationCallbacks());
+			logicalDevice->GetAllocator().Free(staging.allocation);
+		}
+		batch.oversizedBuffers.clear();
+	}
+
+	void VulkanUploadManager::RecordMipmaps(VkCommandBuffer commandBuffer, VkImage image, VkFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		if (mipLevels > 1)
+		{
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+
+			Check(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT, "Texture image format does not support linear blitting!");
+		}
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = image;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.subresourceRange.levelCount = 1;
+
+		int32_t mipWidth = static_cast<int32_t>(width);
+		int32_t mipHeight = static_cast<int32_t>(height);
+
+		for (uint32_t i = 1; i < mipLevels; i++)
+		{
+			barrier.subresourceRange.baseMipLevel = i - 1;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+
+			VkImageBlit blit{};
+			blit.srcOffsets[0] = { 0,0,0 };
+			blit.srcOffsets[1] = { mipWidth,mipHeight,1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = i - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0,0,0 };
+			blit.dstOffsets[1] =
+			{
+				mipWidth > 1 ? mipWidth / 2 : 1,
+				mipHeight > 1 ? mipHeight / 2 : 1,
+				1
+			};
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = i;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+
+			vkCmdBlitImage(commandBuffer,
+				image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit,
+				VK_FILTER_LINEAR);
+
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrier);
+
+			if (mipWidth > 1) mipWidth /= 2;
+			if (mipHeight > 1) mipHeight /= 2;
+		}
+
+		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+			0, nullptr,
+			0, nullptr,
+			1, &barrier);
+	}
+}
@@ -2,6 +2,8 @@
 #include "platform/vulkan/VulkanUtil.h"
 #include "platform/vulkan/VulkanLogicalDevice.h"
 #include "platform/vulkan/VulkanPhysicalDevice.h"
+#include "platform/vulkan/VulkanMemoryAllocator.h"
+#include "core/MemoryTracker.h"
 
 #include <memory>
 
@@ -10,7 +12,7 @@
 
 namespace FGEngine
 {
-	void VulkanUtil::CreateImage(const std::shared_ptr<VulkanPhysicalDevice>& physicalDevice, const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	void VulkanUtil::CreateImage(const std::shared_ptr<VulkanLogicalDevice>& logicalDevice, uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VulkanAllocation& imageAllocation, bool bDedicatedMemory)
 	{
 		VkImageCreateInfo imageCreateInfo{};
 		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -28,23 +30,10 @@ namespace FGEngine
 		imageCreateInfo.samples = numSamples;
 		imageCreateInfo.flags = 0;
 
-		VkResult result = vkCreateImage(*logicalDevice, &imageCreateInfo, nullptr, &image);
+		VkResult result = vkCreateImage(*logicalDevice, &imageCreateInfo, VulkanUtil::GetAllocationCallbacks(), &image);
 		Check(result == VK_SUCCESS, "Failed to create image. Vulkan error: %d", result);
 
-		VkMemoryRequirements memoryRequirements;
-		vkGetImageMemoryRequirements(*logicalDevice, image, &memoryRequirements);
-
-		VkMemoryAllocateInfo memoryAllocateInfo{};
-		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		memoryAllocateInfo.allocationSize = memoryRequirements.size;
-		memoryAllocateInfo.memoryTypeIndex = physicalDevice->FindMemoryType(
-			memoryRequirements.memoryTypeBits,
-			properties);
-
-		result = vkAllocateMemory(*logicalDevice, &memoryAllocateInfo, nullptr, &imageMemory);
-		Check(result == VK_SUCCESS, "Failed to allocate image memory. Vulkan error: %d", result);
-
-		vkBindImageMemory(*logicalDevice, image, imageMemory, 0);
+		imageAllocation = logicalDevice->GetAllocator().AllocateImage(image, properties, tiling, bDedicatedMemory);
 	}
 
 	VkImageView VulkanUtil::CreateImageView(const std::shared_ptr<VulkanLogicalDevice>& device, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
@@ -65,9 +54,42 @@ namespace FGEngine
 		createInfo.subresourceRange.layerCount = 1;
 
 		VkImageView imageView;
-		VkResult result = vkCreateImageView(*device, &createInfo, nullptr, &imageView);
+		VkResult result = vkCreateImageView(*device, &createInfo, VulkanUtil::GetAllocationCallbacks(), &imageView);
 		Check(result == VK_SUCCESS, "Failed to create image view. Vulkan error: %d", result);
 
 		return imageView;
 	}
+
+#if ENABLE_MEMORY_TRACKING
+	static void* VKAPI_PTR TrackedAllocation(void*, size_t size, size_t alignment, VkSystemAllocationScope)
+	{
+		return MemoryTracker::Allocate(size, alignment, EMemoryTag::Vulkan);
+	}
+
+	static void* VKAPI_PTR TrackedReallocation(void*, void* original, size_t size, size_t alignment, VkSystemAllocationScope)
+	{
+		return MemoryTracker::Reallocate(original, size, alignment, EMemoryTag::Vulkan);
+	}
+
+	static void VKAPI_PTR TrackedFree(void*, void* memory)
+	{
+		MemoryTracker::Free(memory);
+	}
+#endif
+
+	const VkAllocationCallbacks* VulkanUtil::GetAllocationCallbacks()
+	{
+#if ENABLE_MEMORY_TRACKING
+		static const VkAllocationCallbacks callbacks
+		{
+			.pUserData = nullptr,
+			.pfnAllocation = TrackedAllocation,
+			.pfnReallocation = TrackedReallocation,
+			.pfnFree = TrackedFree,
+		};
+		return &callbacks;
+#else
+		return nullptr;
+#endif
+	}
 }
@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "renderer/Camera.h"
+#include "core/InputSubsystem.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace FGEngine
+{
+	static constexpr float RotateSensitivity = 0.005f;
+	static constexpr float ZoomSensitivity = 0.25f;
+	static constexpr float MinDistance = 1.0f;
+	static constexpr float MaxDistance = 8.0f;
+
+	Camera::Camera()
+	{
+		// looking at the origin from (2, 2, 2), z up
+		target = glm::vec3(0.0f);
+		yaw = glm::radians(45.0f);
+		pitch = std::asin(1.0f / std::sqrt(3.0f));
+		distance = std::sqrt(12.0f);
+
+		fieldOfView = glm::radians(45.0f);
+		nearPlane = 0.1f;
+		farPlane = 10.0f;
+	}
+
+	void Camera::ApplyInput(const InputSnapshot& snapshot)
+	{
+		if (snapshot.frame == lastInputFrame) return;
+		lastInputFrame = snapshot.frame;
+
+		if (snapshot.IsMouseButtonPressed(EMouseButton::Mouse_Left))
+		{
+			Rotate(snapshot.cursorDelta);
+		}
+
+		distance -= static_cast<float>(snapshot.mouseScroll.y) * ZoomSensitivity;
+		distance = std::clamp(distance, MinDistance, MaxDistance);
+	}
+
+	void Camera::Rotate(const glm::dvec2& cursorDelta)
+	{
+		yaw -= static_cast<float>(cursorDelta.x) * RotateSensitivity;
+		pitch += static_cast<float>(cursorDelta.y) * RotateSensitivity;
+		pitch = std::clamp(pitch, glm::radians(-89.0f), glm::radians(89.0f));
+	}
+
+	glm::mat4 Camera::GetView() const
+	{
+		return glm::lookAt(GetPosition(), target, glm::vec3(0, 0, 1));
+	}
+
+	glm::mat4 Camera::GetProjection(float aspectRatio) const
+	{
+		glm::mat4 projection = glm::perspective(fieldOfView, aspectRatio, nearPlane, farPlane);
+		projection[1][1] *= -1; // flip y-axis
+		return projection;
+	}
+
+	glm::vec3 Camera::GetPosition() const
+	{
+		glm::vec3 direction
+		{
+			std::cos(pitch) * std::cos(yaw),
+			std::cos(pitch) * std::sin(yaw),
+			std::sin(pitch)
+		};
+		return target + direction * distance;
+	}
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "renderer/Model.h"
 #include "core/Logger.h"
+#include "core/MemoryTracker.h"
 
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
@@ -10,6 +11,8 @@ namespace FGEngine
 {
 	Model* Model::GenerateQuad()
 	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Asset);
+
 		const std::vector<Vertex> vertices =
 		{
 			{{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
@@ -29,6 +32,9 @@ namespace FGEngine
 
 	Model::Model(const std::string& file)
 	{
+		// Assimp allocates from its own module, only the meshes copied out of the scene are tracked
+		ScopedMemoryTag memoryTag(EMemoryTag::Asset);
+
 		Assimp::Importer importer;
 
 		const aiScene* scene = importer.ReadFile(file, 
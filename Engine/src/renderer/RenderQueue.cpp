@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "renderer/RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+
+namespace FGEngine
+{
+	static constexpr uint32_t DepthBits = 20;
+	static constexpr uint32_t DepthMax = (1u << DepthBits) - 1;
+
+	void RenderQueue::Submit(Handle<Mesh> mesh, Handle<Material> material, const glm::mat4& transform, const glm::vec4& color)
+	{
+		entries.push_back({ 0, static_cast<uint32_t>(items.size()) });
+		items.push_back({ mesh, material, transform, color });
+	}
+
+	void RenderQueue::Clear()
+	{
+		// keeps the capacity, the queue is refilled every frame
+		items.clear();
+		entries.clear();
+	}
+
+	void RenderQueue::Sort()
+	{
+		scratch.resize(entries.size());
+
+		// LSD radix sort, one byte per pass
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			std::array<uint32_t, 256> offsets{};
+			for (const RenderQueueEntry& entry : entries)
+			{
+				offsets[(entry.key >> shift) & 0xFF]++;
+			}
+
+			// every key shares this byte, the pass would not move anything
+			if (offsets[(entries.empty() ? 0 : entries[0].key >> shift) & 0xFF] == entries.size()) continue;
+
+			uint32_t sum = 0;
+			for (uint32_t& offset : offsets)
+			{
+				uint32_t count = offset;
+				offset = sum;
+				sum += count;
+			}
+
+			for (const RenderQueueEntry& entry : entries)
+			{
+				scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+			}
+			entries.swap(scratch);
+		}
+	}
+
+	uint64_t RenderQueue::MakeSortKey(ERenderPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+	{
+		uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * DepthMax);
+
+		uint64_t key = static_cast<uint64_t>(pass) << 60;
+		if (pass == ERenderPass::Transparent)
+		{
+			// blending needs back to front, state changes come second
+			key |= (DepthMax - quantizedDepth) << 40;
+			key |= static_cast<uint64_t>(pipeline & 0xFFF) << 28;
+			key |= static_cast<uint64_t>(material & 0xFFFF) << 12;
+			key |= mesh & 0xFFF;
+		}
+		else
+		{
+			// mesh above depth keeps the instances of a mesh together, they are still front to back within the run
+			key |= static_cast<uint64_t>(pipeline & 0xFFF) << 48;
+			key |= static_cast<uint64_t>(material & 0xFFFF) << 32;
+			key |= static_cast<uint64_t>(mesh & 0xFFF) << 20;
+			key |= quantizedDepth;
+		}
+		return key;
+	}
+}
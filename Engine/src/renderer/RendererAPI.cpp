@@ -21,7 +21,8 @@ namespace FGEngine
 			LogWarning("OpenGL is not supported");
 			break;
 		case ERendererAPI::Vulkan:
-			if (VulkanRendererAPI::IsSupported())
+			// the glfw check needs a window system, headless only needs the loader and a driver
+			if (rendererProperties.IsHeadless() || VulkanRendererAPI::IsSupported())
 			{
 				return new VulkanRendererAPI(rendererProperties);
 			}
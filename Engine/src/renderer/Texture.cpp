@@ -1,7 +1,13 @@
 #include "pch.h"
 #include "renderer/Texture.h"
 #include "core/Logger.h"
+#include "core/MemoryTracker.h"
 
+#if ENABLE_MEMORY_TRACKING
+#define STBI_MALLOC(size) FGEngine::MemoryTracker::Allocate(size)
+#define STBI_REALLOC(ptr, size) FGEngine::MemoryTracker::Reallocate(ptr, size)
+#define STBI_FREE(ptr) FGEngine::MemoryTracker::Free(ptr)
+#endif
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -9,6 +15,8 @@ namespace FGEngine
 {
 	Texture::Texture(const std::string& path)
 	{
+		ScopedMemoryTag memoryTag(EMemoryTag::Asset);
+
 		stbi_set_flip_vertically_on_load(true);
 		texturePtr = stbi_load(path.c_str(), &width, &height, &channelCount, STBI_rgb_alpha);
 		Check(texturePtr, "failed to load texture from %s", path.c_str());